@@ -0,0 +1,90 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "yuki.h"
+#include "bench_common.h"
+
+#define BENCH_ROWS 100000L
+#define BENCH_LOOPS 200L
+
+static long bench_rss_kb()
+{
+    long pages = 0, rss = 0;
+    FILE * statm = fopen("/proc/self/statm", "r");
+
+    if (statm) {
+        if (fscanf(statm, "%ld %ld", &pages, &rss) != 2) {
+            rss = 0;
+        }
+
+        fclose(statm);
+    }
+
+    return rss * 4;
+}
+
+/**
+ * clone a big array, read it through, then clean up.
+ * it's what fetch_all does with a large result set.
+ * set ybuffer/mmap_threshold to 0 in config to compare with malloc.
+ * usage: bench_big_clone [config] [rows] [loops]
+ */
+int main(int argc, char * argv[])
+{
+    const char * config = argc > 1? argv[1]: "./bench.config";
+    long rows = argc > 2? atol(argv[2]): BENCH_ROWS;
+    long loops = argc > 3? atol(argv[3]): BENCH_LOOPS;
+    yvar_t * values = (yvar_t*)calloc(rows, sizeof(yvar_t));
+    volatile yint64_t sink = 0;
+    double start, clone_time = 0, clean_up_time = 0;
+    long i, j;
+
+    if (!values) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+
+    if (!yuki_init(config)) {
+        fprintf(stderr, "cannot init yuki with config %s\n", config);
+        return -1;
+    }
+
+    atexit(&yuki_shutdown);
+
+    for (i = 0; i < rows; i++) {
+        yvar_int64(values[i], i);
+    }
+
+    yvar_t array = YVAR_ARRAY_WITH_SIZE(values, rows);
+
+    for (i = 0; i < loops; i++) {
+        yvar_t * cloned = NULL;
+
+        start = bench_now();
+        if (!yvar_clone(cloned, array)) {
+            fprintf(stderr, "cannot clone\n");
+            return -1;
+        }
+
+        for (j = 0; j < rows; j++) {
+            yvar_t element = YVAR_EMPTY();
+            yint64_t value = 0;
+            yvar_array_get(*cloned, j, element);
+            yvar_get_int64(element, value);
+            sink += value;
+        }
+        clone_time += bench_now() - start;
+
+        start = bench_now();
+        yuki_clean_up();
+        clean_up_time += bench_now() - start;
+    }
+
+    printf("rows: %ld\n", rows);
+    printf("clone+read: us/op %.2f\n", clone_time * 1e6 / loops);
+    printf("clean up:   us/op %.2f\n", clean_up_time * 1e6 / loops);
+    printf("rss after clean up: KB %ld\n", bench_rss_kb());
+
+    free(values);
+    return 0;
+}
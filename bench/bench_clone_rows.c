@@ -0,0 +1,54 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "yuki.h"
+#include "bench_common.h"
+
+#define BENCH_ROWS 50000L
+#define BENCH_LOOPS 50L
+
+/**
+ * clone a result set shaped array of maps, then clean up.
+ * every row has int columns, a short string and a long string.
+ * usage: bench_clone_rows [config] [rows] [loops]
+ */
+int main(int argc, char * argv[])
+{
+    const char * config = argc > 1? argv[1]: "./bench.config";
+    long rows = argc > 2? atol(argv[2]): BENCH_ROWS;
+    long loops = argc > 3? atol(argv[3]): BENCH_LOOPS;
+    static const char intro[] = "a string longer than inline string in var";
+    double start, clone_time = 0;
+    long i;
+
+    if (!yuki_init(config)) {
+        fprintf(stderr, "cannot init yuki with config %s\n", config);
+        return -1;
+    }
+
+    atexit(&yuki_shutdown);
+
+    yvar_t result = YVAR_EMPTY();
+
+    if (!bench_build_rows(&result, rows, intro)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+
+    for (i = 0; i < loops; i++) {
+        yvar_t * cloned = NULL;
+
+        start = bench_now();
+        if (!yvar_clone(cloned, result)) {
+            fprintf(stderr, "cannot clone\n");
+            return -1;
+        }
+        clone_time += bench_now() - start;
+
+        yuki_clean_up();
+    }
+
+    printf("rows: %ld\n", rows);
+    printf("clone: us/op %.2f\n", clone_time * 1e6 / loops);
+    return 0;
+}
@@ -0,0 +1,81 @@
+#ifndef _YUKI_BENCH_COMMON_H_
+#define _YUKI_BENCH_COMMON_H_
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "yuki.h"
+
+#define BENCH_FIELDS 5
+
+/**
+ * malloc counter. link with -Wl,--wrap=malloc.
+ */
+static volatile unsigned long g_bench_malloc_count = 0;
+
+void * __real_malloc(size_t size);
+
+void * __wrap_malloc(size_t size)
+{
+    __sync_fetch_and_add(&g_bench_malloc_count, 1);
+    return __real_malloc(size);
+}
+
+static inline unsigned long bench_malloc_count()
+{
+    return __sync_fetch_and_add(&g_bench_malloc_count, 0);
+}
+
+static inline double bench_now()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/**
+ * build a result set shaped array of maps with uid, name, cash, diamond and intro columns.
+ * all rows share the same keys. memory is never freed and intro must outlive the rows.
+ */
+static inline ybool_t bench_build_rows(yvar_t * result, long rows, const char * intro)
+{
+    static yvar_t raw_keys[BENCH_FIELDS];
+    static yvar_t keys;
+    yvar_t * values = (yvar_t*)calloc(rows * BENCH_FIELDS, sizeof(yvar_t));
+    yvar_t * maps = (yvar_t*)calloc(rows, sizeof(yvar_t));
+    yvar_t * arrays = (yvar_t*)calloc(rows, sizeof(yvar_t));
+    ysize_t intro_len = strlen(intro);
+    long i;
+
+    if (!values || !maps || !arrays) {
+        free(values);
+        free(maps);
+        free(arrays);
+        return yfalse;
+    }
+
+    yvar_cstr(raw_keys[0], "uid");
+    yvar_cstr(raw_keys[1], "name");
+    yvar_cstr(raw_keys[2], "cash");
+    yvar_cstr(raw_keys[3], "diamond");
+    yvar_cstr(raw_keys[4], "intro");
+    yvar_array(keys, raw_keys);
+
+    for (i = 0; i < rows; i++) {
+        yvar_t * row = values + i * BENCH_FIELDS;
+        yvar_uint64(row[0], i);
+        yvar_cstr(row[1], "huandu");
+        yvar_int32(row[2], i * 10);
+        yvar_int32(row[3], i * 2);
+        yvar_cstr_with_size(row[4], intro, intro_len);
+        yvar_array_with_size(arrays[i], row, BENCH_FIELDS);
+        yvar_map(maps[i], keys, arrays[i]);
+    }
+
+    yvar_array_with_size(*result, maps, rows);
+    return ytrue;
+}
+
+#endif
@@ -0,0 +1,86 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "yuki.h"
+#include "bench_common.h"
+
+#define BENCH_ROWS 10000L
+#define BENCH_LOOPS 1000L
+
+/**
+ * pull the uid column out of a cloned result set, row by row and by yvar_array_extract_uint64().
+ * usage: bench_extract [config] [rows] [loops]
+ */
+int main(int argc, char * argv[])
+{
+    const char * config = argc > 1? argv[1]: "./bench.config";
+    long rows = argc > 2? atol(argv[2]): BENCH_ROWS;
+    long loops = argc > 3? atol(argv[3]): BENCH_LOOPS;
+    yuint64_t * uids = (yuint64_t*)calloc(rows, sizeof(yuint64_t));
+    yvar_t * result = NULL;
+    yuint64_t row_sum = 0, extract_sum = 0;
+    double start, row_time = 0, extract_time = 0;
+    long i, loop;
+
+    if (!uids) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+
+    if (!yuki_init(config)) {
+        fprintf(stderr, "cannot init yuki with config %s\n", config);
+        return -1;
+    }
+
+    atexit(&yuki_shutdown);
+
+    yvar_t raw_result = YVAR_EMPTY();
+
+    if (!bench_build_rows(&raw_result, rows, "intro")) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+
+    yvar_t uid_key = YVAR_CSTR("uid");
+
+    // a cloned result set is what a query returns
+    if (!yvar_clone(result, raw_result)) {
+        fprintf(stderr, "cannot clone result\n");
+        return -1;
+    }
+
+    for (loop = 0; loop < loops; loop++) {
+        start = bench_now();
+
+        for (i = 0; i < rows; i++) {
+            yvar_t row = YVAR_EMPTY();
+            yvar_t uid = YVAR_EMPTY();
+            yvar_array_get(*result, i, row);
+            yvar_map_get(row, uid_key, uid);
+            yvar_get_uint64(uid, uids[i]);
+        }
+
+        row_time += bench_now() - start;
+        row_sum += uids[rows - 1];
+
+        start = bench_now();
+
+        if (!yvar_array_extract_uint64(*result, uid_key, uids, rows)) {
+            fprintf(stderr, "cannot extract uid\n");
+            return -1;
+        }
+
+        extract_time += bench_now() - start;
+        extract_sum += uids[rows - 1];
+    }
+
+    if (row_sum != extract_sum) {
+        fprintf(stderr, "results don't match\n");
+        return -1;
+    }
+
+    printf("rows: %ld\n", rows);
+    printf("row by row: ns/row %.2f\n", row_time * 1e9 / loops / rows);
+    printf("extract: ns/row %.2f\n", extract_time * 1e9 / loops / rows);
+    return 0;
+}
@@ -0,0 +1,78 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "yuki.h"
+#include "bench_common.h"
+
+#define BENCH_TABLE_NAME "mysample"
+#define BENCH_LOOPS 100000
+
+/**
+ * measure mallocs and time per ytable_fetch_one().
+ * usage: bench_fetch_one [config] [table] [loops]
+ * each loop is one request: select with condition, fetch, clean up.
+ */
+int main(int argc, char * argv[])
+{
+    const char * config = argc > 1? argv[1]: "./bench.config";
+    const char * table = argc > 2? argv[2]: BENCH_TABLE_NAME;
+    long loops = argc > 3? atol(argv[3]): BENCH_LOOPS;
+
+    if (!yuki_init(config)) {
+        fprintf(stderr, "cannot init yuki with config %s\n", config);
+        return -1;
+    }
+
+    atexit(&yuki_shutdown);
+
+    yvar_t select_raw_fields[] = {
+        YVAR_CSTR("*")
+    };
+    yvar_t select_fields = YVAR_ARRAY(select_raw_fields);
+
+    yvar_triple_array_t select_raw_cond = {
+        {YVAR_CSTR("uid"), YVAR_CSTR("="), YVAR_CSTR("huandu")},
+        {YVAR_CSTR("int_value"), YVAR_CSTR(">"), YVAR_INT32(100)},
+    };
+
+    ytable_t * ytable = ytable_instance(table);
+    yvar_t * select_cond = NULL;
+    yvar_t * result = NULL;
+    long i;
+
+    if (!ytable) {
+        fprintf(stderr, "cannot find table %s\n", table);
+        return -2;
+    }
+
+    // warm up connection and thread data.
+    ytable_select(ytable, select_fields);
+    ytable_fetch_one(ytable, result);
+    yuki_clean_up();
+
+    unsigned long mallocs = bench_malloc_count();
+    double start = bench_now();
+
+    for (i = 0; i < loops; i++) {
+        yvar_triple_array_smart_clone(select_cond, select_raw_cond);
+
+        ytable = ytable_reset(ytable);
+        ytable_select(ytable, select_fields);
+        ytable_where(ytable, *select_cond);
+
+        if (!ytable_fetch_one(ytable, result)) {
+            fprintf(stderr, "fail to fetch one at loop %ld\n", i);
+            return -3;
+        }
+
+        yuki_clean_up();
+    }
+
+    double elapsed = bench_now() - start;
+    mallocs = bench_malloc_count() - mallocs;
+    ytable_release(ytable);
+
+    printf("fetch_one: loops %ld, mallocs/op %.2f, ns/op %.1f\n",
+        loops, (double)mallocs / loops, elapsed * 1e9 / loops);
+    return 0;
+}
@@ -0,0 +1,74 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "yuki.h"
+#include "bench_common.h"
+
+#define BENCH_MAX_THREADS 64
+#define BENCH_LOOPS 200000L
+
+static long g_bench_loops = BENCH_LOOPS;
+
+static void * _bench_worker(void * arg)
+{
+    (void)arg;
+    long i;
+
+    for (i = 0; i < g_bench_loops; i++) {
+        ybuffer_t * buffer = ybuffer_create_global(64);
+
+        if (!buffer || !ybuffer_destroy_global(buffer)) {
+            fprintf(stderr, "fail to create/destroy global buffer\n");
+            return NULL;
+        }
+
+        // destroyed buffers are freed in clean up
+        if ((i & 0x3FF) == 0x3FF) {
+            yuki_clean_up();
+        }
+    }
+
+    yuki_clean_up();
+    return NULL;
+}
+
+/**
+ * measure global buffer create/destroy throughput under contention.
+ * usage: bench_global_buffer [config] [loops per thread]
+ */
+int main(int argc, char * argv[])
+{
+    const char * config = argc > 1? argv[1]: "./bench.config";
+    pthread_t threads[BENCH_MAX_THREADS];
+    int thread_count, i;
+
+    if (argc > 2) {
+        g_bench_loops = atol(argv[2]);
+    }
+
+    if (!yuki_init(config)) {
+        fprintf(stderr, "cannot init yuki with config %s\n", config);
+        return -1;
+    }
+
+    atexit(&yuki_shutdown);
+
+    for (thread_count = 1; thread_count <= BENCH_MAX_THREADS; thread_count *= 2) {
+        double start = bench_now();
+
+        for (i = 0; i < thread_count; i++) {
+            pthread_create(&threads[i], NULL, &_bench_worker, NULL);
+        }
+
+        for (i = 0; i < thread_count; i++) {
+            pthread_join(threads[i], NULL);
+        }
+
+        double elapsed = bench_now() - start;
+        printf("global buffer: threads %2d, ns/op %8.1f, Mops/s %6.2f\n", thread_count,
+            elapsed * 1e9 / g_bench_loops, thread_count * g_bench_loops / elapsed / 1e6);
+    }
+
+    return 0;
+}
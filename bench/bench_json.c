@@ -0,0 +1,64 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "yuki.h"
+#include "bench_common.h"
+
+#define BENCH_ROWS 10000L
+#define BENCH_LOOPS 50L
+
+/**
+ * encode a result set shaped array of maps in json, then decode it.
+ * usage: bench_json [config] [rows] [loops]
+ */
+int main(int argc, char * argv[])
+{
+    const char * config = argc > 1? argv[1]: "./bench.config";
+    long rows = argc > 2? atol(argv[2]): BENCH_ROWS;
+    long loops = argc > 3? atol(argv[3]): BENCH_LOOPS;
+    static const char intro[] = "a \"quoted\" string with\ta tab, longer than most of other fields";
+    double start, encode_time = 0, decode_time = 0;
+    ysize_t json_size = 0;
+    long i;
+
+    if (!yuki_init(config)) {
+        fprintf(stderr, "cannot init yuki with config %s\n", config);
+        return -1;
+    }
+
+    atexit(&yuki_shutdown);
+
+    yvar_t result = YVAR_EMPTY();
+
+    if (!bench_build_rows(&result, rows, intro)) {
+        fprintf(stderr, "out of memory\n");
+        return -1;
+    }
+
+    for (i = 0; i < loops; i++) {
+        ycstr_t json;
+        yvar_t * decoded = NULL;
+
+        start = bench_now();
+        if (!yvar_to_json(result, json)) {
+            fprintf(stderr, "cannot encode\n");
+            return -1;
+        }
+        encode_time += bench_now() - start;
+
+        start = bench_now();
+        if (!yvar_from_json(json.str, json.size, decoded)) {
+            fprintf(stderr, "cannot decode\n");
+            return -1;
+        }
+        decode_time += bench_now() - start;
+
+        json_size = json.size;
+        yuki_clean_up();
+    }
+
+    printf("rows: %ld, json: %lu bytes\n", rows, (unsigned long)json_size);
+    printf("encode: us/op %.2f, MB/s %.1f\n", encode_time * 1e6 / loops, json_size * loops / encode_time / 1e6);
+    printf("decode: us/op %.2f, MB/s %.1f\n", decode_time * 1e6 / loops, json_size * loops / decode_time / 1e6);
+    return 0;
+}
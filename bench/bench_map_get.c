@@ -0,0 +1,61 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "yuki.h"
+#include "bench_common.h"
+
+#define BENCH_LOOPS 10000000L
+#define BENCH_MAX_KEYS 256
+
+/**
+ * look up every key of a cloned map in turn.
+ * usage: bench_map_get [config] [loops]
+ */
+int main(int argc, char * argv[])
+{
+    const char * config = argc > 1? argv[1]: "./bench.config";
+    long loops = argc > 2? atol(argv[2]): BENCH_LOOPS;
+    static const ysize_t key_counts[] = {4, 16, 64, BENCH_MAX_KEYS};
+    static char names[BENCH_MAX_KEYS][16];
+    static yvar_t raw_key_value[BENCH_MAX_KEYS][2];
+    volatile yint64_t sink = 0;
+    double start, elapsed;
+    ysize_t i, n;
+    long loop;
+
+    if (!yuki_init(config)) {
+        fprintf(stderr, "cannot init yuki with config %s\n", config);
+        return -1;
+    }
+
+    atexit(&yuki_shutdown);
+
+    for (i = 0; i < BENCH_MAX_KEYS; i++) {
+        ysize_t len = snprintf(names[i], sizeof(names[i]), "field_%03lu", i);
+        yvar_cstr_with_size(raw_key_value[i][0], names[i], len);
+        yvar_uint64(raw_key_value[i][1], i);
+    }
+
+    for (n = 0; n < sizeof(key_counts) / sizeof(key_counts[0]); n++) {
+        ysize_t count = key_counts[n];
+        yvar_t * map = NULL;
+
+        if (!yvar_map_clone(map, raw_key_value, count)) {
+            fprintf(stderr, "cannot clone map\n");
+            return -1;
+        }
+
+        start = bench_now();
+        for (loop = 0; loop < loops; loop++) {
+            yvar_t value = YVAR_EMPTY();
+            yvar_map_get(*map, raw_key_value[loop % count][0], value);
+            sink += value.data.yuint64_data;
+        }
+        elapsed = bench_now() - start;
+        printf("keys: %3lu  ns/get %.2f\n", count, elapsed * 1e9 / loops);
+
+        yuki_clean_up();
+    }
+
+    return 0;
+}
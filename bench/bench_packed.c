@@ -0,0 +1,120 @@
+#include <stdlib.h>
+#include <stdio.h>
+
+#include "yuki.h"
+#include "bench_common.h"
+
+#define BENCH_SIZE 100000L
+#define BENCH_LOOPS 1000L
+
+/**
+ * sum, min/max and find on an array of int64 vars and on a packed int64 array.
+ * usage: bench_packed [config] [size] [loops]
+ */
+int main(int argc, char * argv[])
+{
+    const char * config = argc > 1? argv[1]: "./bench.config";
+    long size = argc > 2? atol(argv[2]): BENCH_SIZE;
+    long loops = argc > 3? atol(argv[3]): BENCH_LOOPS;
+    yvar_t * yvars = (yvar_t*)calloc(size, sizeof(yvar_t));
+    yvar_t array = YVAR_EMPTY();
+    yvar_t packed = YVAR_EMPTY();
+    yvar_t sum = YVAR_EMPTY();
+    yvar_t min = YVAR_EMPTY();
+    yvar_t max = YVAR_EMPTY();
+    yvar_t needle = YVAR_EMPTY();
+    yint64_t array_sum = 0, array_min = 0, array_max = 0, value;
+    double start, array_sum_time = 0, array_min_max_time = 0, array_find_time = 0;
+    double packed_sum_time = 0, packed_min_max_time = 0, packed_find_time = 0;
+    ysize_t index = 0;
+    long i, found = 0;
+
+    if (!yvars || size <= 0) {
+        fprintf(stderr, "invalid size\n");
+        return -1;
+    }
+
+    if (!yuki_init(config)) {
+        fprintf(stderr, "cannot init yuki with config %s\n", config);
+        return -1;
+    }
+
+    atexit(&yuki_shutdown);
+
+    for (i = 0; i < size; i++) {
+        yvar_int64(yvars[i], (i * 7919) % 100003 - 50000);
+    }
+
+    yvar_array_with_size(array, yvars, size);
+
+    if (!yvar_packed_from_array(packed, array, YVAR_TYPE_INT64)) {
+        fprintf(stderr, "cannot pack array\n");
+        return -1;
+    }
+
+    // the last element is searched so that whole array is scanned
+    yvar_int64(needle, yvars[size - 1].data.yint64_data);
+
+    for (i = 0; i < loops; i++) {
+        start = bench_now();
+        array_sum = 0;
+
+        FOREACH_YVAR_ARRAY(array, sum_element) {
+            yvar_get_int64(*sum_element, value);
+            array_sum += value;
+        }
+
+        array_sum_time += bench_now() - start;
+
+        start = bench_now();
+        yvar_get_int64(yvars[0], array_min);
+        array_max = array_min;
+
+        FOREACH_YVAR_ARRAY(array, min_max_element) {
+            yvar_get_int64(*min_max_element, value);
+            array_min = value < array_min? value: array_min;
+            array_max = value > array_max? value: array_max;
+        }
+
+        array_min_max_time += bench_now() - start;
+
+        start = bench_now();
+
+        FOREACH_YVAR_ARRAY(array, find_element) {
+            if (yvar_equal(*find_element, needle)) {
+                found++;
+                break;
+            }
+        }
+
+        array_find_time += bench_now() - start;
+
+        start = bench_now();
+        yvar_packed_sum(packed, sum);
+        packed_sum_time += bench_now() - start;
+
+        start = bench_now();
+        yvar_packed_min_max(packed, min, max);
+        packed_min_max_time += bench_now() - start;
+
+        start = bench_now();
+        found += yvar_packed_find(packed, needle, index);
+        packed_find_time += bench_now() - start;
+    }
+
+    if (array_sum != sum.data.yint64_data || array_min != min.data.yint64_data
+            || array_max != max.data.yint64_data || found != loops * 2) {
+        fprintf(stderr, "results don't match\n");
+        return -1;
+    }
+
+    printf("size: %ld, var array: %lu bytes, packed: %lu bytes\n", size,
+        (unsigned long)(size * sizeof(yvar_t)), (unsigned long)(size * sizeof(yint64_t)));
+    printf("sum: array us/op %.2f, packed us/op %.2f\n",
+        array_sum_time * 1e6 / loops, packed_sum_time * 1e6 / loops);
+    printf("min/max: array us/op %.2f, packed us/op %.2f\n",
+        array_min_max_time * 1e6 / loops, packed_min_max_time * 1e6 / loops);
+    printf("find: array us/op %.2f, packed us/op %.2f\n",
+        array_find_time * 1e6 / loops, packed_find_time * 1e6 / loops);
+    return 0;
+}
@@ -0,0 +1,68 @@
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+
+#include "yuki.h"
+#include "bench_common.h"
+
+#define BENCH_LOOPS 100000000L
+
+static pthread_key_t g_bench_key;
+
+/**
+ * measure the cost of reaching per-thread state.
+ * usage: bench_thread_ctx [config] [loops]
+ */
+int main(int argc, char * argv[])
+{
+    const char * config = argc > 1? argv[1]: "./bench.config";
+    long loops = argc > 2? atol(argv[2]): BENCH_LOOPS;
+    volatile yint64_t sink = 0;
+    double start, elapsed;
+    long i;
+
+    if (!yuki_init(config)) {
+        fprintf(stderr, "cannot init yuki with config %s\n", config);
+        return -1;
+    }
+
+    atexit(&yuki_shutdown);
+
+    pthread_key_create(&g_bench_key, NULL);
+    pthread_setspecific(g_bench_key, (void*)&sink);
+
+    start = bench_now();
+    for (i = 0; i < loops; i++) {
+        sink += (yint64_t)(intptr_t)pthread_getspecific(g_bench_key);
+    }
+    elapsed = bench_now() - start;
+    printf("pthread_getspecific:   ns/op %.2f\n", elapsed * 1e9 / loops);
+
+    start = bench_now();
+    for (i = 0; i < loops; i++) {
+        sink += yuki_thread_ctx()->logid;
+    }
+    elapsed = bench_now() - start;
+    printf("yuki_thread_ctx:       ns/op %.2f\n", elapsed * 1e9 / loops);
+
+    start = bench_now();
+    for (i = 0; i < loops; i++) {
+        sink += ylog_get_pthread_key();
+    }
+    elapsed = bench_now() - start;
+    printf("ylog_get_pthread_key:  ns/op %.2f\n", elapsed * 1e9 / loops);
+
+    ybuffer_mark_t mark = ybuffer_mark();
+    start = bench_now();
+    for (i = 0; i < loops; i++) {
+        sink += (yint64_t)(intptr_t)ybuffer_simple_alloc(8);
+
+        if ((i & 0xFFF) == 0xFFF) {
+            ybuffer_rewind(mark);
+        }
+    }
+    elapsed = bench_now() - start;
+    printf("ybuffer_simple_alloc:  ns/op %.2f\n", elapsed * 1e9 / loops);
+
+    return 0;
+}
@@ -114,6 +114,7 @@ int main(int argc, char * argv[])
         return -5;
     }
 
+    ytable_release(ytable);
     YUKI_LOG_TRACE("Hooray!!!! Sample runs successfully!!!");
 
     return 0;
@@ -0,0 +1,342 @@
+#include <gtest/gtest.h>
+#include <pthread.h>
+
+#include "yuki.h"
+#define YUKI_CFG_FILE "./test/yuki.config"
+
+class YukiBufferTest : public ::testing::Test {
+protected:
+    virtual void SetUp()
+    {
+        yuki_init(YUKI_CFG_FILE);
+    }
+
+    virtual void TearDown()
+    {
+        yuki_clean_up();
+        yuki_shutdown();
+    }
+};
+
+TEST_F(YukiBufferTest, SimpleAlloc) {
+    char * small = (char*)ybuffer_simple_alloc(10);
+    ASSERT_TRUE(small);
+    ASSERT_EQ(0u, (ysize_t)small % sizeof(void*));
+    memset(small, 'a', 10);
+
+    // span several chunks and dedicated blocks
+    ysize_t sizes[] = {1, 100, 4000, YBUFFER_CHUNK_MIN_SIZE / 2, YBUFFER_CHUNK_MIN_SIZE * 3, 17};
+    ysize_t i, j;
+
+    for (j = 0; j < 50; j++) {
+        for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+            char * p = (char*)ybuffer_simple_alloc(sizes[i]);
+            ASSERT_TRUE(p);
+            memset(p, 'b', sizes[i]);
+        }
+    }
+
+    ASSERT_EQ('a', small[9]);
+
+    ybuffer_t * buffer = ybuffer_create(30);
+    ASSERT_TRUE(buffer);
+    ASSERT_EQ(ybuffer_round_up(30), ybuffer_available_size(buffer));
+    ASSERT_TRUE(ybuffer_alloc(buffer, 30));
+    ASSERT_EQ(0u, ybuffer_available_size(buffer));
+    ASSERT_FALSE(ybuffer_alloc(buffer, 1));
+}
+
+TEST_F(YukiBufferTest, MarkAndRewind) {
+    ASSERT_TRUE(ybuffer_simple_alloc(100));
+
+    ybuffer_mark_t mark = ybuffer_mark();
+    void * first = ybuffer_simple_alloc(64);
+    ASSERT_TRUE(first);
+
+    ysize_t i;
+    for (i = 0; i < 100; i++) {
+        ASSERT_TRUE(ybuffer_simple_alloc(YBUFFER_CHUNK_MIN_SIZE / 8));
+    }
+
+    ASSERT_TRUE(ybuffer_simple_alloc(YBUFFER_CHUNK_MIN_SIZE * 2));
+    ASSERT_TRUE(ybuffer_rewind(mark));
+
+    // memory after mark is reused
+    ASSERT_EQ(first, ybuffer_simple_alloc(64));
+
+    // nested marks must be rewound in LIFO order
+    ybuffer_mark_t outer = ybuffer_mark();
+    ASSERT_TRUE(ybuffer_simple_alloc(64));
+    ybuffer_mark_t inner = ybuffer_mark();
+    ASSERT_TRUE(ybuffer_simple_alloc(64));
+    ASSERT_TRUE(ybuffer_rewind(inner));
+    ASSERT_TRUE(ybuffer_rewind(outer));
+    ASSERT_FALSE(ybuffer_rewind(inner));
+
+    // clone after rewind still works
+    yvar_t * cloned = NULL;
+    yvar_t raw = YVAR_EMPTY();
+    yvar_cstr(raw, "rewind");
+    ASSERT_TRUE(yvar_clone(cloned, raw));
+    ASSERT_TRUE(yvar_equal(*cloned, raw));
+    ASSERT_TRUE(ybuffer_rewind(mark));
+}
+
+static void * _create_global_buffer(void * arg)
+{
+    (void)arg;
+    return ybuffer_create_global(1000);
+}
+
+TEST_F(YukiBufferTest, GlobalBufferCrossThread) {
+    pthread_t threads[4];
+    ybuffer_t * buffers[4];
+    ybuffer_stats_t before, stats;
+    ysize_t i;
+
+    ASSERT_TRUE(ybuffer_stats(NULL, &before));
+
+    for (i = 0; i < 4; i++) {
+        ASSERT_EQ(0, pthread_create(&threads[i], NULL, &_create_global_buffer, NULL));
+    }
+
+    for (i = 0; i < 4; i++) {
+        void * ret = NULL;
+        ASSERT_EQ(0, pthread_join(threads[i], &ret));
+        buffers[i] = (ybuffer_t*)ret;
+        ASSERT_TRUE(buffers[i]);
+        ASSERT_TRUE(ybuffer_alloc(buffers[i], 100));
+    }
+
+    ASSERT_TRUE(ybuffer_stats(NULL, &stats));
+    ASSERT_LE(before.global_bytes + 4000, stats.global_bytes);
+
+    // buffers created by other threads can be destroyed here
+    for (i = 0; i < 4; i++) {
+        ASSERT_TRUE(ybuffer_destroy_global(buffers[i]));
+        ASSERT_FALSE(ybuffer_destroy_global(buffers[i]));
+    }
+
+    // thread stats never count global buffers
+    ybuffer_stats_t thread_stats;
+    ASSERT_TRUE(ybuffer_stats(&thread_stats, &stats));
+    ASSERT_EQ(0u, thread_stats.global_bytes);
+    ASSERT_EQ(before.global_bytes, stats.global_bytes);
+
+    // the rest is swept by shutdown
+    ASSERT_TRUE(ybuffer_create_global(10));
+}
+
+TEST_F(YukiBufferTest, Pool) {
+    ybuffer_pool_t pool;
+    ASSERT_TRUE(ybuffer_pool_init(&pool, sizeof(yvar_t)));
+
+    void * objects[YBUFFER_POOL_SLAB_OBJECTS * 3];
+    ysize_t count = sizeof(objects) / sizeof(objects[0]);
+    ysize_t i, j;
+
+    for (i = 0; i < count; i++) {
+        objects[i] = ybuffer_pool_alloc(&pool);
+        ASSERT_TRUE(objects[i]);
+        memset(objects[i], 0xAB, sizeof(yvar_t));
+
+        for (j = 0; j < i; j++) {
+            ASSERT_NE(objects[i], objects[j]);
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        ybuffer_pool_free(&pool, objects[i]);
+    }
+
+    // freed objects are recycled
+    void * object = ybuffer_pool_alloc(&pool);
+    ybool_t recycled = yfalse;
+
+    for (i = 0; i < count; i++) {
+        if (object == objects[i]) {
+            recycled = ytrue;
+        }
+    }
+
+    ASSERT_TRUE(recycled);
+    ybuffer_pool_free(&pool, object);
+    ybuffer_pool_destroy(&pool);
+}
+
+TEST_F(YukiBufferTest, Stats) {
+    ybuffer_stats_t before, after, global;
+    ASSERT_TRUE(ybuffer_stats(&before, NULL));
+
+    ybuffer_mark_t mark = ybuffer_mark();
+    ASSERT_TRUE(ybuffer_site_simple_alloc(100, YBUFFER_SITE_SQL));
+    ASSERT_TRUE(ybuffer_site_create(YBUFFER_CHUNK_MAX_SIZE, YBUFFER_SITE_CLONE));
+
+    ASSERT_TRUE(ybuffer_stats(&after, &global));
+    ASSERT_EQ(before.alloc_count[YBUFFER_SITE_SQL] + 1, after.alloc_count[YBUFFER_SITE_SQL]);
+    ASSERT_EQ(before.alloc_count[YBUFFER_SITE_CLONE] + 1, after.alloc_count[YBUFFER_SITE_CLONE]);
+    ASSERT_LE(before.live_bytes + 100 + YBUFFER_CHUNK_MAX_SIZE, after.live_bytes);
+    ASSERT_LE(after.live_bytes, after.peak_bytes);
+    ASSERT_LT(before.chunk_count, after.chunk_count);
+    ASSERT_LE(after.live_bytes, global.live_bytes);
+    ASSERT_LE(after.alloc_count[YBUFFER_SITE_SQL], global.alloc_count[YBUFFER_SITE_SQL]);
+
+    ASSERT_TRUE(ybuffer_rewind(mark));
+    ASSERT_TRUE(ybuffer_stats(&after, NULL));
+    ASSERT_EQ(before.live_bytes, after.live_bytes);
+    ASSERT_EQ(before.chunk_count, after.chunk_count);
+    ASSERT_LE(before.live_bytes + 100 + YBUFFER_CHUNK_MAX_SIZE, after.peak_bytes);
+
+    // global buffer is counted until destroyed
+    ybuffer_stats_t global_before;
+    ASSERT_TRUE(ybuffer_stats(NULL, &global_before));
+    ybuffer_t * buffer = ybuffer_create_global(1000);
+    ASSERT_TRUE(buffer);
+    ASSERT_TRUE(ybuffer_stats(&after, &global));
+    ASSERT_LE(global_before.global_bytes + 1000, global.global_bytes);
+    ASSERT_EQ(0u, after.global_bytes);
+    ASSERT_TRUE(ybuffer_destroy_global(buffer));
+    ASSERT_TRUE(ybuffer_stats(NULL, &global));
+    ASSERT_EQ(global_before.global_bytes, global.global_bytes);
+
+    yuki_clean_up();
+    ASSERT_TRUE(ybuffer_stats(&after, NULL));
+    ASSERT_EQ(0u, after.live_bytes);
+    ASSERT_EQ(0u, after.chunk_count);
+    ASSERT_EQ(0u, after.wasted_bytes);
+}
+
+TEST_F(YukiBufferTest, MappedBlock) {
+    ybuffer_mark_t mark = ybuffer_mark();
+    ysize_t size = YBUFFER_MMAP_THRESHOLD * 2;
+    char * block = (char*)ybuffer_simple_alloc(size);
+    ASSERT_TRUE(block);
+    block[0] = 'a';
+    block[size - 1] = 'z';
+
+    // mapping is cached after rewind and reused with pages dropped
+    ASSERT_TRUE(ybuffer_rewind(mark));
+    char * reused = (char*)ybuffer_simple_alloc(size);
+    ASSERT_EQ(block, reused);
+    ASSERT_EQ(0, reused[size - 1]);
+
+    // small buffer still comes from chunk
+    ASSERT_TRUE(ybuffer_simple_alloc(100));
+}
+
+static ybool_t _allow_once(ysize_t live_bytes, ysize_t size, ysize_t budget, void * data)
+{
+    ysize_t * calls = (ysize_t*)data;
+    return (*calls)++ == 0;
+}
+
+TEST_F(YukiBufferTest, Budget) {
+    ybuffer_stats_t stats;
+    ASSERT_TRUE(ybuffer_stats(&stats, NULL));
+    yuint64_t refused_count = stats.refused_count;
+    ybuffer_set_thread_budget(stats.live_bytes + 1024);
+
+    ASSERT_TRUE(ybuffer_simple_alloc(512));
+    ASSERT_FALSE(ybuffer_over_budget());
+    ASSERT_FALSE(ybuffer_simple_alloc(1024));
+    ASSERT_TRUE(ybuffer_over_budget());
+
+    // callback can let allocation go on
+    ysize_t calls = 0;
+    ybuffer_set_budget_callback(&_allow_once, &calls);
+    ASSERT_TRUE(ybuffer_create(1024));
+    ASSERT_FALSE(ybuffer_create(1024));
+    ASSERT_EQ(2u, calls);
+    ybuffer_set_budget_callback(NULL, NULL);
+
+    ASSERT_TRUE(ybuffer_stats(&stats, NULL));
+    ASSERT_EQ(refused_count + 2, stats.refused_count);
+
+    // global buffer is not limited
+    ASSERT_TRUE(ybuffer_create_global(4096));
+
+    ybuffer_set_thread_budget(YBUFFER_BUDGET_UNLIMITED);
+    ASSERT_TRUE(ybuffer_simple_alloc(4096));
+
+    // clean up resets the flag
+    yuki_clean_up();
+    ASSERT_FALSE(ybuffer_over_budget());
+    ybuffer_set_thread_budget(0);
+}
+
+static void * _detach_clone(void * arg)
+{
+    yvar_t ** cloned = (yvar_t**)arg;
+    yvar_t value = YVAR_EMPTY();
+    yvar_cstr(value, "owned by another thread");
+
+    if (!yvar_clone(*cloned, value)) {
+        return NULL;
+    }
+
+    // thread exits after detaching. memory must survive.
+    return ybuffer_detach();
+}
+
+TEST_F(YukiBufferTest, DetachAndAdopt) {
+    pthread_t thread;
+    yvar_t * cloned = NULL;
+    void * ret = NULL;
+    ASSERT_EQ(0, pthread_create(&thread, NULL, &_detach_clone, &cloned));
+    ASSERT_EQ(0, pthread_join(thread, &ret));
+
+    ybuffer_chain_t * chain = (ybuffer_chain_t*)ret;
+    ASSERT_TRUE(chain);
+    ASSERT_TRUE(cloned);
+
+    ybuffer_stats_t before, after;
+    ASSERT_TRUE(ybuffer_stats(&before, NULL));
+    ASSERT_TRUE(ybuffer_adopt(chain));
+    ASSERT_TRUE(ybuffer_stats(&after, NULL));
+    ASSERT_LT(before.live_bytes, after.live_bytes);
+    ASSERT_LT(before.chunk_count, after.chunk_count);
+
+    ASSERT_STREQ("owned by another thread", yvar_cstr_buffer(*cloned));
+
+    // detach in the same thread and adopt it back
+    ASSERT_TRUE(ybuffer_simple_alloc(100));
+    ybuffer_mark_t mark = ybuffer_mark();
+    ASSERT_TRUE(ybuffer_simple_alloc(100));
+    chain = ybuffer_detach();
+    ASSERT_TRUE(chain);
+    ASSERT_TRUE(ybuffer_stats(&after, NULL));
+    ASSERT_EQ(0u, after.live_bytes);
+    ASSERT_FALSE(ybuffer_rewind(mark));
+    ASSERT_TRUE(ybuffer_adopt(chain));
+
+    yuki_clean_up();
+    ASSERT_TRUE(ybuffer_stats(&after, NULL));
+    ASSERT_EQ(0u, after.live_bytes);
+
+    // adopted chain is passed on by next detach. clean up must not free it.
+    ASSERT_EQ(0, pthread_create(&thread, NULL, &_detach_clone, &cloned));
+    ASSERT_EQ(0, pthread_join(thread, &ret));
+    ASSERT_TRUE(ybuffer_adopt((ybuffer_chain_t*)ret));
+    ASSERT_TRUE(ybuffer_stats(&before, NULL));
+    chain = ybuffer_detach();
+    ASSERT_TRUE(chain);
+    yuki_clean_up();
+
+    // spare chunks kept by clean up are all reused
+    for (int i = 0; i < 80; i++) {
+        char * reused = (char*)ybuffer_simple_alloc(4096);
+        ASSERT_TRUE(reused);
+        memset(reused, 'X', 4096);
+    }
+
+    ASSERT_STREQ("owned by another thread", yvar_cstr_buffer(*cloned));
+
+    ASSERT_TRUE(ybuffer_adopt(chain));
+    ASSERT_TRUE(ybuffer_stats(&after, NULL));
+    ASSERT_LE(before.live_bytes, after.live_bytes);
+    ASSERT_STREQ("owned by another thread", yvar_cstr_buffer(*cloned));
+
+    yuki_clean_up();
+    ASSERT_TRUE(ybuffer_stats(&after, NULL));
+    ASSERT_EQ(0u, after.live_bytes);
+}
@@ -0,0 +1,261 @@
+#include <gtest/gtest.h>
+#include <string.h>
+#include <string>
+
+#include "yuki.h"
+
+#define YUKI_CFG_FILE "./test/yuki.config"
+
+static yuint64_t _test_random(yuint64_t * seed)
+{
+    // xorshift64
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+    return *seed;
+}
+
+static ybool_t _test_from_json(const char * json, yvar_t ** yvar)
+{
+    return yvar_from_json(json, strlen(json), *yvar);
+}
+
+TEST(YukiJsonTest, Encode) {
+    yuki_init(YUKI_CFG_FILE);
+
+    static char name[] = "say \"hi\"\\\n\t\x01/";
+    yvar_t raw_items[4];
+    yvar_t raw_keys[5];
+    yvar_t raw_values[5];
+    yvar_t keys = YVAR_EMPTY();
+    yvar_t values = YVAR_EMPTY();
+    yvar_t map = YVAR_EMPTY();
+    yvar_t list = YVAR_EMPTY();
+    yvar_t item = YVAR_EMPTY();
+    ycstr_t json;
+
+    yvar_int8(raw_items[0], -1);
+    yvar_uint64(raw_items[1], YUKI_MAX_UINT64_VALUE);
+    yvar_bool(raw_items[2], yfalse);
+    yvar_undefined(raw_items[3]);
+    yvar_list(list);
+    yvar_int32(item, 3);
+    ASSERT_TRUE(yvar_list_push_back(list, item));
+
+    yvar_cstr(raw_keys[0], "name");
+    yvar_cstr(raw_keys[1], "items");
+    yvar_int32(raw_keys[2], 42);
+    yvar_cstr(raw_keys[3], "list");
+    yvar_cstr(raw_keys[4], "empty");
+    yvar_cstr(raw_values[0], name);
+    yvar_array(raw_values[1], raw_items);
+    yvar_bool(raw_values[2], ytrue);
+    raw_values[3] = list;
+    yvar_array_with_size(raw_values[4], NULL, 0);
+    yvar_array(keys, raw_keys);
+    yvar_array(values, raw_values);
+    yvar_map(map, keys, values);
+
+    ASSERT_TRUE(yvar_to_json(map, json));
+    ASSERT_STREQ("{\"name\":\"say \\\"hi\\\"\\\\\\n\\t\\u0001/\",\"items\":[-1,18446744073709551615,false,null],"
+        "\"42\":true,\"list\":[3],\"empty\":[]}", json.str);
+    ASSERT_EQ(strlen(json.str), json.size);
+
+    // packed array is encoded as an array
+    yint32_t raw_ids[] = {-1, 0, 2147483647};
+    yvar_t ids = YVAR_EMPTY();
+    yvar_packed(ids, YVAR_TYPE_INT32, raw_ids, 3);
+    ycstr_t ids_json;
+    ASSERT_TRUE(yvar_to_json(ids, ids_json));
+    ASSERT_STREQ("[-1,0,2147483647]", ids_json.str);
+
+    // map key must be a string or an int
+    yvar_bool(raw_keys[2], ytrue);
+    ASSERT_FALSE(yvar_to_json(map, json));
+
+    // nested as deep as decoder allows
+    yvar_t nested[YJSON_MAX_DEPTH + 1];
+    ysize_t i;
+    yvar_undefined(nested[0]);
+
+    for (i = 1; i <= YJSON_MAX_DEPTH; i++) {
+        yvar_array_with_size(nested[i], nested + i - 1, 1);
+    }
+
+    yvar_t * decoded = NULL;
+    ASSERT_TRUE(yvar_to_json(nested[YJSON_MAX_DEPTH], json));
+    ASSERT_TRUE(yvar_from_json(json.str, json.size, decoded));
+
+    yvar_t too_deep = YVAR_EMPTY();
+    yvar_array_with_size(too_deep, nested + YJSON_MAX_DEPTH, 1);
+    ASSERT_FALSE(yvar_to_json(too_deep, json));
+
+    yuki_clean_up();
+}
+
+TEST(YukiJsonTest, Decode) {
+    yuki_init(YUKI_CFG_FILE);
+
+    static const char json[] = " {\"uid\": 10001, \"name\" : \"huandu\", \"tags\":[true, false, null, -5, []],"
+        "\"big\":18446744073709551615, \"text\":\"a\\\"b\\\\c\\/\\u00e9\\ud83d\\ude00\", \"empty\": {}} ";
+    yvar_t * yvar = NULL;
+    yvar_t key = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    yvar_t element = YVAR_EMPTY();
+    yint64_t int_value = 0;
+
+    ASSERT_TRUE(yvar_from_json(json, sizeof(json) - 1, yvar));
+    ASSERT_TRUE(yvar_is_map(*yvar));
+    ASSERT_EQ(6u, yvar_count(*yvar));
+
+    yvar_cstr(key, "uid");
+    ASSERT_TRUE(yvar_map_get(*yvar, key, value));
+    ASSERT_EQ(YVAR_TYPE_INT64, value.type);
+    ASSERT_TRUE(yvar_get_int64(value, int_value));
+    ASSERT_EQ(10001, int_value);
+
+    // string without escaped char points to json
+    yvar_cstr(key, "name");
+    ASSERT_TRUE(yvar_map_get(*yvar, key, value));
+    ASSERT_EQ(6u, yvar_cstr_strlen(value));
+    ASSERT_EQ(0, memcmp("huandu", yvar_cstr_buffer(value), 6));
+    ASSERT_TRUE(yvar_cstr_buffer(value) > json && yvar_cstr_buffer(value) < json + sizeof(json));
+
+    yvar_cstr(key, "tags");
+    ASSERT_TRUE(yvar_map_get(*yvar, key, value));
+    ASSERT_EQ(5u, yvar_count(value));
+    ASSERT_TRUE(yvar_array_get(value, 0, element));
+    ASSERT_EQ(YVAR_TYPE_BOOL, element.type);
+    ASSERT_TRUE(element.data.ybool_data);
+    ASSERT_TRUE(yvar_array_get(value, 2, element));
+    ASSERT_TRUE(yvar_is_undefined(element));
+    ASSERT_TRUE(yvar_array_get(value, 3, element));
+    ASSERT_TRUE(yvar_get_int64(element, int_value));
+    ASSERT_EQ(-5, int_value);
+    ASSERT_TRUE(yvar_array_get(value, 4, element));
+    ASSERT_TRUE(yvar_is_array(element));
+    ASSERT_EQ(0u, yvar_count(element));
+
+    yvar_cstr(key, "big");
+    ASSERT_TRUE(yvar_map_get(*yvar, key, value));
+    ASSERT_EQ(YVAR_TYPE_UINT64, value.type);
+    ASSERT_EQ(YUKI_MAX_UINT64_VALUE, value.data.yuint64_data);
+
+    yvar_cstr(key, "text");
+    ASSERT_TRUE(yvar_map_get(*yvar, key, value));
+    ASSERT_STREQ("a\"b\\c/\xc3\xa9\xf0\x9f\x98\x80", yvar_cstr_buffer(value));
+    ASSERT_EQ(strlen(yvar_cstr_buffer(value)), yvar_cstr_strlen(value));
+
+    yvar_cstr(key, "empty");
+    ASSERT_TRUE(yvar_map_get(*yvar, key, value));
+    ASSERT_TRUE(yvar_is_map(value));
+    ASSERT_EQ(0u, yvar_count(value));
+
+    // scalar as root
+    ASSERT_TRUE(_test_from_json("-9223372036854775808", &yvar));
+    ASSERT_TRUE(yvar_get_int64(*yvar, int_value));
+    ASSERT_EQ(YUKI_MIN_INT64_VALUE, int_value);
+    ASSERT_TRUE(_test_from_json("\"\"", &yvar));
+    ASSERT_EQ(0u, yvar_cstr_strlen(*yvar));
+
+    yuki_clean_up();
+}
+
+TEST(YukiJsonTest, BadJson) {
+    yuki_init(YUKI_CFG_FILE);
+
+    const char * cases[] = {
+        "",
+        "   ",
+        "[1,]",
+        "[1 2]",
+        "{\"a\" 1}",
+        "{\"a\":}",
+        "{1:2}",
+        "{\"a\":1,}",
+        "[",
+        "]",
+        "[1]]",
+        "[1] 2",
+        "\"abc",
+        "\"a\\\"",
+        "\"a\x01\"",
+        "\"\\x\"",
+        "\"\\u12\"",
+        "\"\\ud83d\"",
+        "\"\\ude00\"",
+        "tru",
+        "nulll",
+        "true false",
+        "01",
+        "-",
+        "1.5",
+        "1e3",
+        "+1",
+        "18446744073709551616",
+        "-9223372036854775809",
+        "[1}",
+        "{\"a\":1]",
+        "\"a\"b",
+    };
+    yvar_t * yvar = NULL;
+    ysize_t i;
+
+    for (i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        ASSERT_FALSE(_test_from_json(cases[i], &yvar)) << cases[i];
+    }
+
+    // nested too deep
+    std::string deep(YJSON_MAX_DEPTH, '[');
+    deep.append(YJSON_MAX_DEPTH, ']');
+    ASSERT_TRUE(_test_from_json(deep.c_str(), &yvar));
+    deep = "[" + deep + "]";
+    ASSERT_FALSE(_test_from_json(deep.c_str(), &yvar));
+
+    yuki_clean_up();
+}
+
+TEST(YukiJsonTest, RoundTrip) {
+    yuki_init(YUKI_CFG_FILE);
+
+    // strings full of quotes, backslashes and control chars cross 64-byte blocks
+    const char chars[] = "ab\"\\\\\n\x1f\x7f\xe4\xb8\x80{}[]:, ";
+    yuint64_t seed = 0x9E3779B97F4A7C15ULL;
+    int round;
+
+    for (round = 0; round < 200; round++) {
+        ysize_t count = _test_random(&seed) % 20;
+        yvar_t * strings = (yvar_t*)ybuffer_simple_alloc((count + 1) * sizeof(yvar_t));
+        yvar_t array = YVAR_EMPTY();
+        ysize_t i, j;
+
+        for (i = 0; i < count; i++) {
+            ysize_t size = _test_random(&seed) % 150;
+            char * data = (char*)ybuffer_simple_alloc(size + 1);
+
+            for (j = 0; j < size; j++) {
+                data[j] = chars[_test_random(&seed) % (sizeof(chars) - 1)];
+            }
+
+            data[size] = '\0';
+            yvar_cstr_with_size(strings[i], data, size);
+        }
+
+        yvar_int64(strings[count], (yint64_t)_test_random(&seed));
+        yvar_array_with_size(array, strings, count + 1);
+
+        ycstr_t json;
+        yvar_t * decoded = NULL;
+        ASSERT_TRUE(yvar_to_json(array, json));
+        ASSERT_TRUE(yvar_from_json(json.str, json.size, decoded)) << json.str;
+        ASSERT_TRUE(yvar_equal(*decoded, array)) << json.str;
+
+        // encoded again to the same json
+        ycstr_t again;
+        ASSERT_TRUE(yvar_to_json(*decoded, again));
+        ASSERT_EQ(json.size, again.size);
+        ASSERT_EQ(0, memcmp(json.str, again.str, json.size));
+    }
+
+    yuki_clean_up();
+}
@@ -0,0 +1,341 @@
+#include <gtest/gtest.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "yuki.h"
+
+#define YUKI_CFG_FILE "./test/yuki.config"
+
+/**
+ * serialize a var to a malloc'ed buffer.
+ */
+static void * _test_serialize(const yvar_t & yvar, ysize_t & size)
+{
+    size = yvar_serialized_size(yvar);
+
+    if (!size) {
+        return NULL;
+    }
+
+    void * buffer = malloc(size);
+
+    if (!yvar_serialize(yvar, buffer, size)) {
+        free(buffer);
+        return NULL;
+    }
+
+    return buffer;
+}
+
+TEST(YukiSerializeTest, RoundTrip) {
+    yuki_init(YUKI_CFG_FILE);
+
+    static char intro[] = "a string longer than inline string in var";
+    static char name[] = "yuki";
+    yvar_t scalars[12];
+    int i;
+
+    for (i = 0; i < 12; i++) {
+        scalars[i] = YVAR_EMPTY();
+    }
+
+    yvar_bool(scalars[1], ytrue);
+    yvar_int8(scalars[2], -8);
+    yvar_uint8(scalars[3], 200);
+    yvar_int16(scalars[4], -1600);
+    yvar_uint16(scalars[5], 60000);
+    yvar_int32(scalars[6], -32);
+    yvar_uint32(scalars[7], 4000000000u);
+    yvar_int64(scalars[8], YUKI_MIN_INT64_VALUE);
+    yvar_uint64(scalars[9], YUKI_MAX_UINT64_VALUE);
+    yvar_cstr(scalars[10], intro);
+    yvar_cstr(scalars[11], name);
+
+    yvar_t array = YVAR_EMPTY();
+    yvar_array(array, scalars);
+
+    yvar_t list = YVAR_EMPTY();
+    yvar_list(list);
+
+    for (i = 0; i < 40; i++) {
+        yvar_t value = YVAR_EMPTY();
+        yvar_int32(value, i);
+        ASSERT_TRUE(yvar_list_push_back(list, value));
+    }
+
+    yvar_t raw_keys[3];
+    yvar_t raw_values[3];
+    yvar_t keys = YVAR_EMPTY();
+    yvar_t values = YVAR_EMPTY();
+    yvar_t map = YVAR_EMPTY();
+    yvar_cstr(raw_keys[0], "array");
+    yvar_cstr(raw_keys[1], "list");
+    yvar_cstr(raw_keys[2], "empty");
+    raw_values[0] = array;
+    raw_values[1] = list;
+    yvar_list(raw_values[2]);
+    yvar_array(keys, raw_keys);
+    yvar_array(values, raw_values);
+    yvar_map(map, keys, values);
+
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, map));
+
+    ysize_t size = 0;
+    void * buffer = _test_serialize(*cloned, size);
+    ASSERT_TRUE(NULL != buffer);
+    ASSERT_EQ(0u, size % YVAR_SERIALIZE_ALIGNMENT);
+
+    yvar_view_t view;
+    ASSERT_TRUE(yvar_view_open(view, buffer, size));
+    ASSERT_EQ(YVAR_TYPE_MAP, yvar_view_type(view));
+    ASSERT_EQ(3u, yvar_view_count(view));
+
+    yvar_t * loaded = NULL;
+    ASSERT_TRUE(yvar_view_load(view, loaded));
+    ASSERT_TRUE(yvar_equal(*loaded, *cloned));
+    ASSERT_TRUE(yvar_equal(*loaded, map));
+
+    // every scalar type alone
+    for (i = 0; i < 12; i++) {
+        ysize_t scalar_size = 0;
+        void * scalar_buffer = _test_serialize(scalars[i], scalar_size);
+        yvar_view_t scalar_view;
+        yvar_t value = YVAR_EMPTY();
+        ASSERT_TRUE(NULL != scalar_buffer);
+        ASSERT_TRUE(yvar_view_open(scalar_view, scalar_buffer, scalar_size));
+        ASSERT_EQ(scalars[i].type, yvar_view_type(scalar_view));
+        ASSERT_TRUE(yvar_view_get(scalar_view, value));
+        ASSERT_TRUE(yvar_equal(value, scalars[i])) << "type " << (int)scalars[i].type;
+        free(scalar_buffer);
+    }
+
+    // packed array is read in place
+    yuint16_t raw_ports[] = {80, 443, 8080};
+    yvar_t ports = YVAR_EMPTY();
+    yvar_packed(ports, YVAR_TYPE_UINT16, raw_ports, 3);
+    ysize_t ports_size = 0;
+    void * ports_buffer = _test_serialize(ports, ports_size);
+    yvar_view_t ports_view;
+    yvar_t ports_value = YVAR_EMPTY();
+    ASSERT_TRUE(NULL != ports_buffer);
+    ASSERT_TRUE(yvar_view_open(ports_view, ports_buffer, ports_size));
+    ASSERT_EQ(YVAR_TYPE_PACKED, yvar_view_type(ports_view));
+    ASSERT_EQ(3u, yvar_view_count(ports_view));
+    ASSERT_TRUE(yvar_view_get(ports_view, ports_value));
+    ASSERT_TRUE(yvar_equal(ports_value, ports));
+    ASSERT_TRUE(yvar_has_option(ports_value, YVAR_OPTION_READONLY));
+    ASSERT_TRUE((const char*)ports_buffer < (const char*)yvar_packed_data(ports_value, uint16));
+    free(ports_buffer);
+
+    // same var is serialized to same bytes
+    ysize_t again_size = 0;
+    void * again = _test_serialize(map, again_size);
+    ASSERT_EQ(size, again_size);
+    ASSERT_EQ(0, memcmp(buffer, again, size));
+    free(again);
+
+    // loaded strings point to buffer
+    yvar_view_t array_view, intro_view;
+    yvar_t intro_key = YVAR_EMPTY();
+    yvar_t intro_var = YVAR_EMPTY();
+    yvar_cstr(intro_key, "array");
+    ASSERT_TRUE(yvar_view_map_get(view, intro_key, array_view));
+    ASSERT_TRUE(yvar_view_array_get(array_view, 10, intro_view));
+    ASSERT_TRUE(yvar_view_get(intro_view, intro_var));
+    ASSERT_TRUE((const char*)buffer < yvar_cstr_buffer(intro_var));
+    ASSERT_TRUE((const char*)buffer + size > yvar_cstr_buffer(intro_var));
+    ASSERT_STREQ(intro, yvar_cstr_buffer(intro_var));
+
+    yuki_clean_up();
+    free(buffer);
+}
+
+TEST(YukiSerializeTest, View) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t raw_keys[4];
+    yvar_t raw_values[4];
+    yvar_t keys = YVAR_EMPTY();
+    yvar_t values = YVAR_EMPTY();
+    yvar_t map = YVAR_EMPTY();
+    yvar_t nested[2];
+    yvar_cstr(raw_keys[0], "uid");
+    yvar_cstr(raw_keys[1], "cash");
+    yvar_cstr(raw_keys[2], "name");
+    yvar_cstr(raw_keys[3], "items");
+    yvar_uint64(raw_values[0], 10001);
+    yvar_int32(raw_values[1], -5);
+    yvar_cstr(raw_values[2], "huandu");
+    yvar_int32(nested[0], 7);
+    yvar_int32(nested[1], 8);
+    yvar_array(raw_values[3], nested);
+    yvar_array(keys, raw_keys);
+    yvar_array(values, raw_values);
+    yvar_map(map, keys, values);
+
+    // unsorted keys are scanned one by one
+    ysize_t size = 0;
+    void * buffer = _test_serialize(map, size);
+    yvar_view_t view, value, key, item;
+    yvar_t output = YVAR_EMPTY();
+    yvar_t lookup = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_view_open(view, buffer, size));
+
+    yvar_cstr(lookup, "name");
+    ASSERT_TRUE(yvar_view_map_get(view, lookup, value));
+    ASSERT_EQ(YVAR_TYPE_CSTR, yvar_view_type(value));
+    ASSERT_TRUE(yvar_view_get(value, output));
+    ASSERT_TRUE(yvar_equal(output, raw_values[2]));
+
+    yvar_cstr(lookup, "items");
+    ASSERT_TRUE(yvar_view_map_get(view, lookup, value));
+    ASSERT_EQ(2u, yvar_view_count(value));
+    ASSERT_FALSE(yvar_view_get(value, output));
+    ASSERT_TRUE(yvar_view_array_get(value, 1, item));
+    ASSERT_TRUE(yvar_view_get(item, output));
+    ASSERT_TRUE(yvar_equal(output, nested[1]));
+    ASSERT_FALSE(yvar_view_array_get(value, 2, item));
+
+    yvar_cstr(lookup, "none");
+    ASSERT_FALSE(yvar_view_map_get(view, lookup, value));
+
+    ASSERT_TRUE(yvar_view_map_entry(view, 1, key, value));
+    ASSERT_TRUE(yvar_view_get(key, output));
+    ASSERT_TRUE(yvar_equal(output, raw_keys[1]));
+    ASSERT_TRUE(yvar_view_get(value, output));
+    ASSERT_TRUE(yvar_equal(output, raw_values[1]));
+    ASSERT_FALSE(yvar_view_map_entry(view, 4, key, value));
+    free(buffer);
+
+    // sorted keys are searched in binary
+    yvar_t sorted_keys[3];
+    yvar_t sorted_values[3];
+    yvar_t sorted_map = YVAR_EMPTY();
+    yvar_int32(sorted_keys[0], 1);
+    yvar_int32(sorted_keys[1], 5);
+    yvar_int32(sorted_keys[2], 9);
+    yvar_cstr(sorted_values[0], "one");
+    yvar_cstr(sorted_values[1], "five");
+    yvar_cstr(sorted_values[2], "nine");
+    yvar_array(keys, sorted_keys);
+    yvar_array(values, sorted_values);
+    yvar_set_option(keys, YVAR_OPTION_SORTED);
+    yvar_map(sorted_map, keys, values);
+
+    buffer = _test_serialize(sorted_map, size);
+    ASSERT_TRUE(yvar_view_open(view, buffer, size));
+
+    for (int i = 0; i < 3; i++) {
+        ASSERT_TRUE(yvar_view_map_get(view, sorted_keys[i], value));
+        ASSERT_TRUE(yvar_view_get(value, output));
+        ASSERT_TRUE(yvar_equal(output, sorted_values[i]));
+    }
+
+    yvar_int32(lookup, 4);
+    ASSERT_FALSE(yvar_view_map_get(view, lookup, value));
+
+    yvar_t * loaded = NULL;
+    ASSERT_TRUE(yvar_view_load(view, loaded));
+    ASSERT_TRUE(loaded->data.ymap_data.keys->options & YVAR_OPTION_SORTED);
+    free(buffer);
+
+    yuki_clean_up();
+}
+
+TEST(YukiSerializeTest, MappedFile) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t raw[3];
+    yvar_t array = YVAR_EMPTY();
+    yvar_cstr(raw[0], "mapped");
+    yvar_int64(raw[1], -1);
+    yvar_bool(raw[2], yfalse);
+    yvar_array(array, raw);
+
+    ysize_t size = 0;
+    void * buffer = _test_serialize(array, size);
+    ASSERT_TRUE(NULL != buffer);
+
+    FILE * file = tmpfile();
+    ASSERT_TRUE(NULL != file);
+    ASSERT_EQ(size, fwrite(buffer, 1, size, file));
+    ASSERT_EQ(0, fflush(file));
+    free(buffer);
+
+    void * mapped = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fileno(file), 0);
+    ASSERT_TRUE(MAP_FAILED != mapped);
+
+    yvar_view_t view;
+    yvar_t * loaded = NULL;
+    ASSERT_TRUE(yvar_view_open(view, mapped, size));
+    ASSERT_TRUE(yvar_view_load(view, loaded));
+    ASSERT_TRUE(yvar_equal(*loaded, array));
+
+    yuki_clean_up();
+    munmap(mapped, size);
+    fclose(file);
+}
+
+TEST(YukiSerializeTest, BadBuffer) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t raw[2];
+    yvar_t array = YVAR_EMPTY();
+    yvar_cstr(raw[0], "a string longer than inline string in var");
+    yvar_int32(raw[1], 1);
+    yvar_array(array, raw);
+
+    ysize_t size = 0;
+    char * buffer = (char*)_test_serialize(array, size);
+    yvar_view_t view;
+    yvar_t * loaded = NULL;
+    ASSERT_TRUE(NULL != buffer);
+
+    ASSERT_FALSE(yvar_serialize(array, buffer, size - 1));
+    ASSERT_FALSE(yvar_view_open(view, buffer, size - 1));
+    ASSERT_FALSE(yvar_view_open(view, buffer, 8));
+
+    // misaligned buffer
+    char * copy = (char*)malloc(size + 1);
+    memcpy(copy + 1, buffer, size);
+    ASSERT_FALSE(yvar_view_open(view, copy + 1, size));
+    free(copy);
+
+    // bad magic
+    buffer[0] ^= 0xff;
+    ASSERT_FALSE(yvar_view_open(view, buffer, size));
+    buffer[0] ^= 0xff;
+
+    // offset of array points out of buffer. header is 16 bytes followed by root.
+    yuint64_t * root_value = (yuint64_t*)(buffer + 16 + 16);
+    yuint64_t offset = *root_value;
+    *root_value = size;
+    ASSERT_TRUE(yvar_view_open(view, buffer, size));
+    ASSERT_FALSE(yvar_view_load(view, loaded));
+
+    *root_value = offset;
+
+    // second element is turned to an array containing itself
+    char * element = buffer + offset + 24;
+    element[0] = YVAR_TYPE_ARRAY;
+    *(yuint64_t*)(element + 8) = 2;
+    *(yuint64_t*)(element + 16) = offset;
+    ASSERT_TRUE(yvar_view_open(view, buffer, size));
+    ASSERT_FALSE(yvar_view_load(view, loaded));
+    element[0] = YVAR_TYPE_INT32;
+    *(yuint64_t*)(element + 8) = 0;
+    *(yuint64_t*)(element + 16) = 1;
+    ASSERT_TRUE(yvar_view_load(view, loaded));
+    ASSERT_TRUE(yvar_equal(*loaded, array));
+
+    // string without '\0'
+    memset(buffer + size - 8, 'x', 8);
+    ASSERT_TRUE(yvar_view_open(view, buffer, size));
+    ASSERT_FALSE(yvar_view_load(view, loaded));
+
+    yuki_clean_up();
+    free(buffer);
+}
@@ -0,0 +1,164 @@
+#include <gtest/gtest.h>
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "yuki.h"
+
+static yuint64_t _test_random(yuint64_t * seed)
+{
+    // xorshift64
+    *seed ^= *seed << 13;
+    *seed ^= *seed >> 7;
+    *seed ^= *seed << 17;
+    return *seed;
+}
+
+/**
+ * random value with random number of digits.
+ */
+static yuint64_t _test_random_value(yuint64_t * seed)
+{
+    yuint64_t value = _test_random(seed);
+    return value >> (_test_random(seed) % 64);
+}
+
+TEST(YukiStringTest, IntFormat) {
+    char buffer[YSTRING_INT_MAX_LENGTH + 1];
+
+    ASSERT_EQ(1u, ystring_from_int64(0, buffer));
+    ASSERT_STREQ("0", buffer);
+    ASSERT_EQ(2u, ystring_from_int64(-7, buffer));
+    ASSERT_STREQ("-7", buffer);
+    ASSERT_EQ(3u, ystring_from_uint64(100, buffer));
+    ASSERT_STREQ("100", buffer);
+    ASSERT_EQ(20u, ystring_from_int64(YUKI_MIN_INT64_VALUE, buffer));
+    ASSERT_STREQ("-9223372036854775808", buffer);
+    ASSERT_EQ(19u, ystring_from_int64(YUKI_MAX_INT64_VALUE, buffer));
+    ASSERT_STREQ("9223372036854775807", buffer);
+    ASSERT_EQ(20u, ystring_from_uint64(YUKI_MAX_UINT64_VALUE, buffer));
+    ASSERT_STREQ("18446744073709551615", buffer);
+
+    // every power of 10 and its neighbours
+    char expected[YSTRING_INT_MAX_LENGTH + 1];
+    yuint64_t value = 1;
+    int i;
+
+    for (i = 0; i < 20; i++, value *= 10) {
+        yuint64_t values[] = {value - 1, value, value + 1};
+        int j;
+
+        for (j = 0; j < 3; j++) {
+            snprintf(expected, sizeof(expected), "%llu", (unsigned long long)values[j]);
+            ASSERT_EQ(strlen(expected), ystring_from_uint64(values[j], buffer));
+            ASSERT_STREQ(expected, buffer);
+
+            snprintf(expected, sizeof(expected), "%lld", -(long long)(values[j] / 2));
+            ASSERT_EQ(strlen(expected), ystring_from_int64(-(yint64_t)(values[j] / 2), buffer));
+            ASSERT_STREQ(expected, buffer);
+        }
+    }
+}
+
+TEST(YukiStringTest, IntParse) {
+    yint64_t signed_value = 0;
+    yuint64_t unsigned_value = 0;
+
+    ASSERT_TRUE(ystring_to_int64("0", 1, &signed_value));
+    ASSERT_EQ(0, signed_value);
+    ASSERT_TRUE(ystring_to_int64("-123", 4, &signed_value));
+    ASSERT_EQ(-123, signed_value);
+    ASSERT_TRUE(ystring_to_int64("+123", 4, &signed_value));
+    ASSERT_EQ(123, signed_value);
+    ASSERT_TRUE(ystring_to_int64("-9223372036854775808", 20, &signed_value));
+    ASSERT_EQ(YUKI_MIN_INT64_VALUE, signed_value);
+    ASSERT_TRUE(ystring_to_int64("000000000000000000000042", 24, &signed_value));
+    ASSERT_EQ(42, signed_value);
+    ASSERT_TRUE(ystring_to_uint64("18446744073709551615", 20, &unsigned_value));
+    ASSERT_EQ(YUKI_MAX_UINT64_VALUE, unsigned_value);
+
+    // only size bytes are parsed
+    ASSERT_TRUE(ystring_to_int64("12345", 3, &signed_value));
+    ASSERT_EQ(123, signed_value);
+
+    ASSERT_FALSE(ystring_to_int64("", 0, &signed_value));
+    ASSERT_FALSE(ystring_to_int64("-", 1, &signed_value));
+    ASSERT_FALSE(ystring_to_int64(" 1", 2, &signed_value));
+    ASSERT_FALSE(ystring_to_int64("1 ", 2, &signed_value));
+    ASSERT_FALSE(ystring_to_int64("12345678a", 9, &signed_value));
+    ASSERT_FALSE(ystring_to_int64("1.5", 3, &signed_value));
+    ASSERT_FALSE(ystring_to_int64("9223372036854775808", 19, &signed_value));
+    ASSERT_FALSE(ystring_to_int64("-9223372036854775809", 20, &signed_value));
+    ASSERT_FALSE(ystring_to_uint64("18446744073709551616", 20, &unsigned_value));
+    ASSERT_FALSE(ystring_to_uint64("99999999999999999999", 20, &unsigned_value));
+    ASSERT_FALSE(ystring_to_uint64("100000000000000000000", 21, &unsigned_value));
+    ASSERT_FALSE(ystring_to_uint64("-1", 2, &unsigned_value));
+}
+
+TEST(YukiStringTest, FuzzWithLibc) {
+    yuint64_t seed = 0x9E3779B97F4A7C15ULL;
+    char buffer[YSTRING_INT_MAX_LENGTH + 1];
+    char expected[YSTRING_INT_MAX_LENGTH + 1];
+    int i;
+
+    // format and parse random values
+    for (i = 0; i < 200000; i++) {
+        yuint64_t unsigned_value = _test_random_value(&seed);
+        yint64_t signed_value = (_test_random(&seed) & 1)? (yint64_t)unsigned_value: -(yint64_t)unsigned_value;
+        yuint64_t unsigned_parsed = 0;
+        yint64_t signed_parsed = 0;
+        ysize_t len;
+
+        snprintf(expected, sizeof(expected), "%llu", (unsigned long long)unsigned_value);
+        len = ystring_from_uint64(unsigned_value, buffer);
+        ASSERT_STREQ(expected, buffer);
+        ASSERT_TRUE(ystring_to_uint64(buffer, len, &unsigned_parsed));
+        ASSERT_EQ(strtoull(expected, NULL, 10), unsigned_parsed);
+
+        snprintf(expected, sizeof(expected), "%lld", (long long)signed_value);
+        len = ystring_from_int64(signed_value, buffer);
+        ASSERT_STREQ(expected, buffer);
+        ASSERT_TRUE(ystring_to_int64(buffer, len, &signed_parsed));
+        ASSERT_EQ(strtoll(expected, NULL, 10), signed_parsed);
+    }
+
+    // random strings must be accepted exactly when strict strtoll/strtoull accepts them
+    const char chars[] = "0123456789000999-+a. ";
+    char str[32];
+
+    for (i = 0; i < 200000; i++) {
+        ysize_t size = _test_random(&seed) % 24;
+        ysize_t j;
+
+        for (j = 0; j < size; j++) {
+            str[j] = chars[_test_random(&seed) % (sizeof(chars) - 1)];
+        }
+
+        str[size] = '\0';
+
+        // libc skips leading spaces
+        ybool_t libc_candidate = size && ' ' != str[0];
+        char * end = NULL;
+
+        errno = 0;
+        long long libc_signed = strtoll(str, &end, 10);
+        ybool_t libc_signed_ok = libc_candidate && !errno && end == str + size;
+        yint64_t signed_parsed = 0;
+        ASSERT_EQ(libc_signed_ok, ystring_to_int64(str, size, &signed_parsed)) << str;
+
+        if (libc_signed_ok) {
+            ASSERT_EQ(libc_signed, signed_parsed) << str;
+        }
+
+        // strtoull accepts negative value and wraps it
+        errno = 0;
+        unsigned long long libc_unsigned = strtoull(str, &end, 10);
+        ybool_t libc_unsigned_ok = libc_candidate && '-' != str[0] && !errno && end == str + size;
+        yuint64_t unsigned_parsed = 0;
+        ASSERT_EQ(libc_unsigned_ok, ystring_to_uint64(str, size, &unsigned_parsed)) << str;
+
+        if (libc_unsigned_ok) {
+            ASSERT_EQ(libc_unsigned, unsigned_parsed) << str;
+        }
+    }
+}
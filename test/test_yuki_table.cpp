@@ -82,6 +82,7 @@ TEST_F(YukiTableTest, InsertOne) {
     yint64_t insert_id_value;
     ASSERT_TRUE(yvar_get_int64(insert_id, insert_id_value));
     ASSERT_TRUE(insert_id_value > 0);
+    ytable_release(ytable);
 }
 
 TEST_F(YukiTableTest, SelectOne) {
@@ -170,6 +171,7 @@ TEST_F(YukiTableTest, SelectOne) {
     ASSERT_TRUE(yvar_equal(cash_var, expected_cash_var));
     ASSERT_TRUE(yvar_equal(content_var, expected_content));
     ASSERT_TRUE(yvar_equal(created_at_var, expected_created_at));
+    ytable_release(ytable);
 }
 
 TEST_F(YukiTableTest, UpdateOne) {
@@ -230,6 +232,7 @@ TEST_F(YukiTableTest, UpdateOne) {
     yvar_t bool_true = YVAR_EMPTY();
     yvar_bool(bool_true, ytrue);
     ASSERT_TRUE(yvar_equal(*result, bool_true));
+    ytable_release(ytable);
 }
 
 
@@ -262,5 +265,102 @@ TEST_F(YukiTableTest, DeleteOne) {
     yvar_t bool_true = YVAR_EMPTY();
     yvar_bool(bool_true, ytrue);
     ASSERT_TRUE(yvar_equal(*result, bool_true));
+    ytable_release(ytable);
 }
 
+
+TEST_F(YukiTableTest, InstanceAndRelease) {
+    ytable_t * ytable = ytable_instance("mytest");
+    ASSERT_TRUE(ytable);
+    ytable_release(ytable);
+
+    // released instance is recycled
+    ytable_t * another = ytable_instance("mytest");
+    ASSERT_EQ(ytable, another);
+    ASSERT_EQ(YTABLE_DEFAULT_LIMIT, another->limit);
+    ytable_release(another);
+
+    ASSERT_FALSE(ytable_instance("no_such_table"));
+}
+
+TEST_F(YukiTableTest, OutOfBudget) {
+    yvar_t field = YVAR_EMPTY();
+    yvar_cstr(field, "uid");
+    yvar_t raw_fields[] = {
+        field
+    };
+    yvar_t fields = YVAR_EMPTY();
+    yvar_array(fields, raw_fields);
+
+    ytable_t * ytable = ytable_instance("mytest");
+    ASSERT_TRUE(ytable);
+
+    ybuffer_stats_t stats;
+    ASSERT_TRUE(ybuffer_stats(&stats, NULL));
+    ybuffer_set_thread_budget(stats.live_bytes + 1);
+
+    ASSERT_EQ(ytable_select(ytable, fields), ytable);
+    ASSERT_EQ(ytable_last_error(ytable), YTABLE_ERROR_OUT_OF_BUDGET);
+    ytable_release(ytable);
+
+    // nothing is refused in this call. sql without condition is a genuine error.
+    yvar_t * result = NULL;
+    ybuffer_set_thread_budget(0);
+    ytable = ytable_instance("mytest");
+    ASSERT_TRUE(ytable);
+    ASSERT_EQ(ytable_select(ytable, fields), ytable);
+    ASSERT_FALSE(ytable_fetch_all(ytable, result));
+    ASSERT_EQ(ytable_last_error(ytable), YTABLE_ERROR_CANNOT_BUILD_SQL);
+    ytable_release(ytable);
+}
+
+TEST_F(YukiTableTest, QueryLoop) {
+    yvar_t field = YVAR_EMPTY();
+    yvar_t cond_key = YVAR_EMPTY();
+    yvar_t cond_value = YVAR_EMPTY();
+    yvar_t op = YVAR_EMPTY();
+    yvar_cstr(field, "uid");
+    yvar_cstr(cond_key, "uid");
+    yvar_cstr(cond_value, "1234567890");
+    yvar_cstr(op, "=");
+
+    yvar_t raw_fields[] = {
+        field
+    };
+    yvar_t fields = YVAR_EMPTY();
+    yvar_array(fields, raw_fields);
+
+    yvar_triple_array_t raw_cond = {
+        {cond_key, op, cond_value},
+    };
+    yvar_t * cond;
+    ASSERT_TRUE(yvar_triple_array_smart_clone(cond, raw_cond));
+
+    ybuffer_stats_t stats;
+    ysize_t live_bytes = 0;
+    int i;
+
+    // query vars and result are dropped in each loop. nothing else is left in thread arena.
+    for (i = 0; i < 100; i++) {
+        ybuffer_mark_t mark = ybuffer_mark();
+        ytable_t * ytable = ytable_instance("mytest");
+        ASSERT_TRUE(ytable);
+        ASSERT_EQ(ytable_select(ytable, fields), ytable);
+        ASSERT_EQ(ytable_where(ytable, *cond), ytable);
+
+        yvar_t * result = NULL;
+        ASSERT_TRUE(ytable_fetch_one(ytable, result));
+        ASSERT_EQ(1u, yvar_count(*result));
+        ytable_release(ytable);
+        ASSERT_TRUE(ybuffer_rewind(mark));
+
+        ASSERT_TRUE(ybuffer_stats(&stats, NULL));
+
+        // first query opens connection
+        if (!i) {
+            live_bytes = stats.live_bytes;
+        }
+
+        ASSERT_EQ(live_bytes, stats.live_bytes);
+    }
+}
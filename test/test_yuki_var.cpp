@@ -1,8 +1,69 @@
 #include <gtest/gtest.h>
+#include <string>
+
 #include "yuki.h"
 
 #define YUKI_CFG_FILE "./test/yuki.config"
 
+typedef struct _test_walk_ctx_t {
+    std::string trace;
+    ysize_t max_depth;
+    ysize_t stop_at;
+    ysize_t ints;
+} test_walk_ctx_t;
+
+static YVAR_WALK_RESULT _test_walk_enter(yvar_walk_frame_t * frame, void * data)
+{
+    test_walk_ctx_t * ctx = (test_walk_ctx_t*)data;
+    const yvar_t * yvar = frame->yvar;
+
+    if (frame->depth > ctx->max_depth) {
+        ctx->max_depth = frame->depth;
+    }
+
+    if (yvar_like_int(*yvar)) {
+        ctx->ints++;
+        ctx->trace += std::to_string(yvar->data.yint32_data);
+        return ctx->ints == ctx->stop_at? YVAR_WALK_STOP: YVAR_WALK_SKIP;
+    }
+
+    if (yvar_like_string(*yvar)) {
+        ctx->trace += yvar_cstr_buffer(*yvar);
+        return YVAR_WALK_SKIP;
+    }
+
+    // a map is not walked into
+    if (yvar_is_map(*yvar)) {
+        ctx->trace += "M";
+        return YVAR_WALK_SKIP;
+    }
+
+    ctx->trace += "[";
+    return YVAR_WALK_CONTINUE;
+}
+
+static YVAR_WALK_RESULT _test_walk_leave(yvar_walk_frame_t * frame, void * data)
+{
+    test_walk_ctx_t * ctx = (test_walk_ctx_t*)data;
+    ctx->trace += "]" + std::to_string(frame->index);
+    return YVAR_WALK_CONTINUE;
+}
+
+static YVAR_WALK_RESULT _test_walk_add_one(yvar_walk_frame_t * frame, void * data)
+{
+    (void)data;
+
+    if (!frame->peer || frame->peer->type != frame->yvar->type) {
+        return YVAR_WALK_STOP;
+    }
+
+    if (YVAR_TYPE_INT32 == frame->yvar->type) {
+        frame->peer->data.yint32_data = frame->yvar->data.yint32_data + 1;
+    }
+
+    return YVAR_WALK_CONTINUE;
+}
+
 TEST(YukiVarTest, UseVar) {
     yuki_init(YUKI_CFG_FILE);
 
@@ -535,3 +596,1026 @@ TEST(YukiVarTest, VarArrayOfArrayCloneAndPin) {
     yuki_shutdown();
 }
 
+
+TEST(YukiVarTest, MapIndex) {
+    yuki_init(YUKI_CFG_FILE);
+
+    const ysize_t size = YVAR_MAP_INDEX_THRESHOLD * 4;
+    char names[size][16];
+    yvar_t raw_key_value[size + 1][2];
+    ysize_t i;
+
+    for (i = 0; i < size; i++) {
+        ysize_t len = snprintf(names[i], sizeof(names[i]), "field_%u", (unsigned)i);
+        yvar_cstr_with_size(raw_key_value[i][0], names[i], len);
+        yvar_uint64(raw_key_value[i][1], i);
+    }
+
+    // duplicated key is ignored as linear search does
+    raw_key_value[size][0] = raw_key_value[0][0];
+    yvar_uint64(raw_key_value[size][1], size);
+
+    yvar_t * map = NULL;
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_map_clone(map, raw_key_value, size + 1));
+    ASSERT_TRUE(yvar_has_option(*map, YVAR_OPTION_INDEXED));
+    ASSERT_TRUE(yvar_clone(cloned, *map));
+    ASSERT_TRUE(yvar_equal(*map, *cloned));
+
+    for (i = 0; i < size; i++) {
+        yvar_t value = YVAR_EMPTY();
+        yuint64_t number = 0;
+        ASSERT_TRUE(yvar_map_get(*cloned, raw_key_value[i][0], value));
+        ASSERT_TRUE(yvar_get_uint64(value, number));
+        ASSERT_EQ(i, number);
+    }
+
+    yvar_t value = YVAR_EMPTY();
+    yvar_t missing = YVAR_EMPTY();
+    yvar_cstr(missing, "no_such_field");
+    ASSERT_FALSE(yvar_map_get(*map, missing, value));
+    ASSERT_TRUE(yvar_is_undefined(value));
+
+    // small map has no index
+    ASSERT_TRUE(yvar_map_clone(map, raw_key_value, 2));
+    ASSERT_FALSE(yvar_has_option(*map, YVAR_OPTION_INDEXED));
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, CompareAndSort) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t int1 = YVAR_EMPTY();
+    yvar_t int2 = YVAR_EMPTY();
+    yvar_t uint1 = YVAR_EMPTY();
+    yvar_t str1 = YVAR_EMPTY();
+    yvar_t str2 = YVAR_EMPTY();
+    yvar_t str3 = YVAR_EMPTY();
+    yvar_t undefined = YVAR_EMPTY();
+    yvar_int32(int1, -5);
+    yvar_int32(int2, 7);
+    yvar_uint64(uint1, 3);
+    yvar_cstr(str1, "abc");
+    yvar_cstr(str2, "abcd");
+    yvar_cstr(str3, "abd");
+    yvar_undefined(undefined);
+
+    ASSERT_EQ(-1, yvar_compare(int1, int2));
+    ASSERT_EQ(1, yvar_compare(int2, int1));
+    ASSERT_EQ(0, yvar_compare(int1, int1));
+    ASSERT_EQ(-1, yvar_compare(str1, str2));
+    ASSERT_EQ(-1, yvar_compare(str2, str3));
+    ASSERT_EQ(0, yvar_compare(undefined, undefined));
+
+    // different types are ordered by type and never equal
+    ASSERT_NE(0, yvar_compare(int2, uint1));
+    ASSERT_EQ(-yvar_compare(int2, uint1), yvar_compare(uint1, int2));
+    ASSERT_EQ(-1, yvar_compare(undefined, int1));
+
+    yvar_t raw_arr[] = {str3, int2, str1, undefined, int1, str2, uint1};
+    yvar_t arr = YVAR_EMPTY();
+    yvar_array(arr, raw_arr);
+    ASSERT_TRUE(yvar_array_sort(arr));
+    ASSERT_TRUE(yvar_has_option(arr, YVAR_OPTION_SORTED));
+
+    ysize_t i;
+    for (i = 1; i < yvar_count(arr); i++) {
+        ASSERT_EQ(-1, yvar_compare(raw_arr[i - 1], raw_arr[i]));
+    }
+
+    ysize_t index = 0;
+    ASSERT_TRUE(yvar_array_bsearch(arr, str2, index));
+    ASSERT_TRUE(yvar_equal(raw_arr[index], str2));
+    yvar_t missing = YVAR_EMPTY();
+    yvar_cstr(missing, "zzz");
+    ASSERT_FALSE(yvar_array_bsearch(arr, missing, index));
+
+    // arrays compare element by element
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, arr));
+    ASSERT_EQ(0, yvar_compare(*cloned, arr));
+    yvar_t shorter = YVAR_EMPTY();
+    yvar_array_with_size(shorter, raw_arr, 3);
+    ASSERT_EQ(1, yvar_compare(arr, shorter));
+
+    // small map is sorted by key and searched by binary search
+    yvar_map_kv_t raw_key_value = {
+        {str3, int1},
+        {str1, int2},
+        {str2, uint1},
+        {str1, undefined},
+    };
+    yvar_t * map = NULL;
+    ASSERT_TRUE(yvar_map_smart_clone(map, raw_key_value));
+    ASSERT_TRUE(yvar_has_option(*map->data.ymap_data.keys, YVAR_OPTION_SORTED));
+
+    yvar_t value = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_map_get(*map, str1, value));
+    ASSERT_TRUE(yvar_equal(value, int2));
+    ASSERT_TRUE(yvar_map_get(*map, str3, value));
+    ASSERT_TRUE(yvar_equal(value, int1));
+    ASSERT_FALSE(yvar_map_get(*map, missing, value));
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, Intern) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t uid1 = YVAR_EMPTY();
+    yvar_t uid2 = YVAR_EMPTY();
+    yvar_t cash = YVAR_EMPTY();
+    yvar_t plain = YVAR_EMPTY();
+    char name[] = "uid_and_more";
+    ASSERT_TRUE(yvar_intern(uid1, "uid"));
+    ASSERT_TRUE(yvar_intern_with_size(uid2, name, 3));
+    ASSERT_TRUE(yvar_intern(cash, "cash"));
+    yvar_cstr(plain, "uid");
+
+    // the same string always gets the same canonical pointer
+    ASSERT_TRUE(yvar_is_cstr(uid1));
+    ASSERT_TRUE(yvar_has_option(uid1, YVAR_OPTION_INTERNED));
+    ASSERT_EQ(yvar_cstr_buffer(uid1), yvar_cstr_buffer(uid2));
+    ASSERT_EQ(3u, yvar_cstr_strlen(uid2));
+    ASSERT_EQ(0, strcmp("uid", yvar_cstr_buffer(uid2)));
+    ASSERT_TRUE(yvar_equal(uid1, uid2));
+    ASSERT_TRUE(yvar_equal(uid1, plain));
+    ASSERT_FALSE(yvar_equal(uid1, cash));
+    ASSERT_EQ(0, yvar_compare(uid1, plain));
+
+    // many strings grow the table without moving existing ones
+    ysize_t i;
+    char buffer[32];
+    yvar_t var = YVAR_EMPTY();
+
+    for (i = 0; i < 1000; i++) {
+        snprintf(buffer, sizeof(buffer), "field_%lu", (unsigned long)i);
+        ASSERT_TRUE(yvar_intern_with_size(var, buffer, strlen(buffer)));
+    }
+
+    ASSERT_TRUE(yvar_intern(var, "uid"));
+    ASSERT_EQ(yvar_cstr_buffer(uid1), yvar_cstr_buffer(var));
+
+    // clone shares interned strings instead of copying them
+    yvar_map_kv_t raw_key_value = {
+        {uid1, plain},
+        {cash, uid2},
+    };
+    yvar_t * map = NULL;
+    ASSERT_TRUE(yvar_map_smart_clone(map, raw_key_value));
+
+    yvar_t key = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_array_get(*map->data.ymap_data.keys, 1, key));
+    ASSERT_EQ(yvar_cstr_buffer(uid1), yvar_cstr_buffer(key));
+    ASSERT_TRUE(yvar_map_get(*map, plain, value));
+    ASSERT_TRUE(yvar_equal(value, plain));
+    ASSERT_NE(yvar_cstr_buffer(plain), yvar_cstr_buffer(value));
+    ASSERT_TRUE(yvar_map_get(*map, cash, value));
+    ASSERT_EQ(yvar_cstr_buffer(uid1), yvar_cstr_buffer(value));
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, InlineString) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t op = YVAR_EMPTY();
+    yvar_t name = YVAR_EMPTY();
+    yvar_t longest = YVAR_EMPTY();
+    yvar_t too_long = YVAR_EMPTY();
+    yvar_t empty = YVAR_EMPTY();
+    yvar_cstr(op, "=");
+    yvar_cstr(name, "huandu");
+    yvar_cstr(longest, "abcdefghijklmn");
+    yvar_cstr(too_long, "abcdefghijklmno");
+    yvar_cstr(empty, "");
+    ASSERT_EQ((ysize_t)YVAR_INLINE_STR_MAX_SIZE, yvar_cstr_strlen(longest));
+
+    yvar_t raw_arr[] = {op, name, longest, too_long, empty};
+    yvar_t arr = YVAR_EMPTY();
+    yvar_array(arr, raw_arr);
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, arr));
+    ASSERT_TRUE(yvar_equal(*cloned, arr));
+
+    // short strings are stored inside cloned vars
+    ysize_t i;
+    yvar_t value = YVAR_EMPTY();
+    char buffer[32];
+
+    for (i = 0; i < yvar_count(arr); i++) {
+        const yvar_t * element = cloned->data.yarray_data.yvars + i;
+        ASSERT_TRUE(yvar_array_get(*cloned, i, value));
+        ASSERT_EQ(yvar_cstr_strlen(raw_arr[i]), yvar_cstr_strlen(value));
+        ASSERT_STREQ(yvar_cstr_buffer(raw_arr[i]), yvar_cstr_buffer(*element));
+        ASSERT_TRUE(yvar_equal(raw_arr[i], value));
+        ASSERT_TRUE(yvar_equal(value, raw_arr[i]));
+        ASSERT_EQ(0, yvar_compare(raw_arr[i], value));
+        ASSERT_TRUE(yvar_get_cstr(value, buffer, sizeof(buffer)));
+        ASSERT_STREQ(yvar_cstr_buffer(raw_arr[i]), buffer);
+
+        if (yvar_cstr_strlen(raw_arr[i]) > YVAR_INLINE_STR_MAX_SIZE) {
+            ASSERT_FALSE(yvar_has_option(*element, YVAR_OPTION_INLINE));
+        } else {
+            ASSERT_TRUE(yvar_has_option(*element, YVAR_OPTION_INLINE));
+            ASSERT_EQ(element->data.yinline_data.str, yvar_cstr_buffer(*element));
+        }
+    }
+
+    ASSERT_FALSE(yvar_equal(cloned->data.yarray_data.yvars[0], cloned->data.yarray_data.yvars[1]));
+    ASSERT_EQ(-1, yvar_compare(cloned->data.yarray_data.yvars[2], cloned->data.yarray_data.yvars[3]));
+
+    // inline keys work with map lookup
+    yvar_map_kv_t raw_key_value = {
+        {op, name},
+        {name, too_long},
+    };
+    yvar_t * map = NULL;
+    ASSERT_TRUE(yvar_map_smart_clone(map, raw_key_value));
+    ASSERT_TRUE(yvar_map_get(*map, name, value));
+    ASSERT_TRUE(yvar_equal(value, too_long));
+
+    // clone of a cloned var keeps its own copy
+    yvar_t * cloned_again = NULL;
+    ASSERT_TRUE(yvar_clone(cloned_again, *map));
+    ASSERT_TRUE(yvar_equal(*cloned_again, *map));
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, StringHash) {
+    yuki_init(YUKI_CFG_FILE);
+
+    // size is known, so embedded '\0' is a part of string
+    yvar_t abc = YVAR_EMPTY();
+    yvar_t abd = YVAR_EMPTY();
+    yvar_cstr_with_size(abc, "a\0bc", 4);
+    yvar_cstr_with_size(abd, "a\0bd", 4);
+    ASSERT_FALSE(yvar_equal(abc, abd));
+    ASSERT_NE(0, yvar_compare(abc, abd));
+
+    yvar_t long_abc = YVAR_EMPTY();
+    yvar_t long_abd = YVAR_EMPTY();
+    yvar_cstr_with_size(long_abc, "a long string\0abc", 17);
+    yvar_cstr_with_size(long_abd, "a long string\0abd", 17);
+
+    yvar_t raw_arr[] = {abc, abd, long_abc, long_abd};
+    yvar_t arr = YVAR_EMPTY();
+    yvar_array(arr, raw_arr);
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, arr));
+
+    // clone caches hash and keeps every byte
+    ysize_t i, j;
+
+    for (i = 0; i < yvar_count(arr); i++) {
+        const yvar_t * element = cloned->data.yarray_data.yvars + i;
+        ASSERT_TRUE(yvar_has_option(*element, YVAR_OPTION_HASHED));
+        ASSERT_FALSE(yvar_has_option(raw_arr[i], YVAR_OPTION_HASHED));
+        ASSERT_EQ(yvar_hash(raw_arr[i]), yvar_hash(*element));
+        ASSERT_EQ(0, memcmp(yvar_cstr_buffer(raw_arr[i]), yvar_cstr_buffer(*element), yvar_cstr_strlen(*element)));
+
+        for (j = 0; j < yvar_count(arr); j++) {
+            ASSERT_EQ(i == j, yvar_equal(*element, cloned->data.yarray_data.yvars[j]));
+            ASSERT_EQ(i == j, yvar_equal(*element, raw_arr[j]));
+        }
+    }
+
+    // interned string shares the same hash
+    yvar_t interned = YVAR_EMPTY();
+    yvar_t plain = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_intern(interned, "diamond"));
+    yvar_cstr(plain, "diamond");
+    ASSERT_TRUE(yvar_has_option(interned, YVAR_OPTION_HASHED));
+    ASSERT_EQ(yvar_hash(plain), yvar_hash(interned));
+
+    // str is writable. its hash must follow its bytes.
+    char raw_str[] = "cash";
+    yvar_t str = YVAR_EMPTY();
+    yvar_str(str);
+    str.data.ystr_data.size = sizeof(raw_str) - 1;
+    str.data.ystr_data.str = raw_str;
+    yvar_t * cloned_str = NULL;
+    ASSERT_TRUE(yvar_clone(cloned_str, str));
+    ASSERT_FALSE(yvar_has_option(*cloned_str, YVAR_OPTION_HASHED));
+    memcpy(yvar_str_buffer(*cloned_str), "name", 4);
+
+    char raw_name[] = "name";
+    yvar_t name = YVAR_EMPTY();
+    yvar_str(name);
+    name.data.ystr_data.size = sizeof(raw_name) - 1;
+    name.data.ystr_data.str = raw_name;
+    ASSERT_TRUE(yvar_equal(*cloned_str, name));
+    ASSERT_EQ(yvar_hash(name), yvar_hash(*cloned_str));
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, Freeze) {
+    yuki_init(YUKI_CFG_FILE);
+
+    static const char intro[] = "a string longer than inline string";
+    yvar_t raw_ints[] = {YVAR_EMPTY(), YVAR_EMPTY(), YVAR_EMPTY()};
+    yvar_int32(raw_ints[0], 3);
+    yvar_int32(raw_ints[1], 1);
+    yvar_int32(raw_ints[2], 2);
+    yvar_t raw_arr[] = {YVAR_EMPTY(), YVAR_EMPTY(), YVAR_EMPTY()};
+    yvar_array(raw_arr[0], raw_ints);
+    yvar_cstr(raw_arr[1], intro);
+    yvar_list(raw_arr[2]);
+    ASSERT_TRUE(yvar_list_push_back(raw_arr[2], raw_ints[0]));
+    ASSERT_TRUE(yvar_list_push_back(raw_arr[2], raw_ints[1]));
+
+    yvar_t arr = YVAR_EMPTY();
+    yvar_array(arr, raw_arr);
+    yvar_t * pinned = NULL;
+    ASSERT_TRUE(yvar_pin(pinned, arr));
+    ASSERT_TRUE(yvar_freeze(*pinned));
+
+    const yvar_t * frozen_arr = pinned->data.yarray_data.yvars;
+    const yvar_t * frozen_ints = frozen_arr[0].data.yarray_data.yvars;
+    ASSERT_TRUE(yvar_has_option(frozen_arr[0], YVAR_OPTION_FROZEN));
+    ASSERT_TRUE(yvar_has_option(frozen_ints[2], YVAR_OPTION_FROZEN));
+    ASSERT_TRUE(yvar_has_option(frozen_arr[2].data.ylist_data.head->yvars[0], YVAR_OPTION_FROZEN));
+
+    // clone of frozen var shares everything
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, *pinned));
+    ASSERT_EQ(frozen_arr, cloned->data.yarray_data.yvars);
+    ASSERT_TRUE(yvar_equal(*cloned, *pinned));
+
+    // frozen elements are shared while others are copied
+    yvar_t long_str = YVAR_EMPTY();
+    yvar_cstr(long_str, intro);
+    yvar_t mixed_raw[] = {frozen_arr[0], frozen_arr[1], long_str};
+    yvar_t mixed = YVAR_EMPTY();
+    yvar_array(mixed, mixed_raw);
+    ASSERT_TRUE(yvar_clone(cloned, mixed));
+
+    const yvar_t * cloned_mixed = cloned->data.yarray_data.yvars;
+    ASSERT_EQ(frozen_ints, cloned_mixed[0].data.yarray_data.yvars);
+    ASSERT_EQ(yvar_cstr_buffer(frozen_arr[1]), yvar_cstr_buffer(cloned_mixed[1]));
+    ASSERT_NE(intro, yvar_cstr_buffer(cloned_mixed[2]));
+    ASSERT_FALSE(yvar_has_option(cloned_mixed[2], YVAR_OPTION_FROZEN));
+
+    // sort copies frozen array first
+    yvar_t ints = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_assign(ints, frozen_arr[0]));
+    ASSERT_TRUE(yvar_array_sort(ints));
+    ASSERT_FALSE(yvar_has_option(ints, YVAR_OPTION_FROZEN));
+    ASSERT_NE(frozen_ints, ints.data.yarray_data.yvars);
+    ASSERT_EQ(1, ints.data.yarray_data.yvars[0].data.yint32_data);
+    ASSERT_EQ(3, frozen_ints[0].data.yint32_data);
+    ASSERT_EQ(1, frozen_ints[1].data.yint32_data);
+
+    // push copies frozen list first
+    yvar_t list = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_assign(list, frozen_arr[2]));
+    ASSERT_TRUE(yvar_list_push_back(list, raw_ints[2]));
+    ASSERT_EQ(3u, yvar_count(list));
+    ASSERT_EQ(2u, yvar_count(frozen_arr[2]));
+    ASSERT_EQ(NULL, frozen_arr[2].data.ylist_data.tail->next);
+    ASSERT_NE(frozen_arr[2].data.ylist_data.head, list.data.ylist_data.head);
+
+    // frozen var is never assigned. a copy must be reset first.
+    yvar_t copy = YVAR_EMPTY();
+    yvar_t * shared = (yvar_t*)frozen_ints;
+    ASSERT_FALSE(yvar_assign(shared[0], raw_ints[1]));
+    ASSERT_EQ(3, frozen_ints[0].data.yint32_data);
+    ASSERT_TRUE(yvar_assign(copy, frozen_arr[0]));
+    ASSERT_FALSE(yvar_assign(copy, raw_ints[0]));
+    ASSERT_TRUE(yvar_memzero(copy));
+    ASSERT_TRUE(yvar_assign(copy, raw_ints[0]));
+    ASSERT_EQ(3u, yvar_count(frozen_arr[0]));
+
+    ASSERT_TRUE(yvar_unpin(pinned));
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, ListNodes) {
+    yuki_init(YUKI_CFG_FILE);
+
+    const ysize_t size = 100;
+    yvar_t list = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    yvar_list(list);
+    ASSERT_EQ(0u, yvar_count(list));
+
+    FOREACH_YVAR_LIST(list, nothing) {
+        FAIL() << "list is empty";
+    }
+
+    ysize_t i;
+
+    for (i = 0; i < size; i++) {
+        yvar_uint64(value, i);
+        ASSERT_TRUE(yvar_list_push_back(list, value));
+        ASSERT_EQ(i + 1, yvar_count(list));
+    }
+
+    // vars are stored in unrolled nodes
+    ysize_t nodes = 0;
+    const ylist_node_t * node;
+
+    for (node = list.data.ylist_data.head; node; node = node->next) {
+        ASSERT_EQ(nodes * YLIST_NODE_CAPACITY, node->offset);
+        nodes++;
+    }
+
+    ASSERT_EQ((size + YLIST_NODE_CAPACITY - 1) / YLIST_NODE_CAPACITY, nodes);
+
+    i = 0;
+    FOREACH_YVAR_LIST(list, v) {
+        ASSERT_EQ(i, v->data.yuint64_data);
+
+        if (++i == YLIST_NODE_CAPACITY + 1) {
+            break;
+        }
+    }
+
+    ASSERT_EQ(YLIST_NODE_CAPACITY + 1, i);
+
+    // cloned list is packed in one node and still equals original one
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, list));
+    ASSERT_EQ(cloned->data.ylist_data.head, cloned->data.ylist_data.tail);
+    ASSERT_EQ(size, yvar_count(*cloned));
+    ASSERT_TRUE(yvar_equal(list, *cloned));
+    ASSERT_EQ(0, yvar_compare(list, *cloned));
+
+    yvar_uint64(value, size);
+    ASSERT_TRUE(yvar_list_push_back(*cloned, value));
+    ASSERT_EQ(size + 1, yvar_count(*cloned));
+    ASSERT_FALSE(yvar_equal(list, *cloned));
+    ASSERT_GT(0, yvar_compare(list, *cloned));
+
+    i = 0;
+    FOREACH_YVAR_LIST(*cloned, cloned_value) {
+        ASSERT_EQ(i++, cloned_value->data.yuint64_data);
+    }
+
+    ASSERT_EQ(size + 1, i);
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, ArrayPush) {
+    yuki_init(YUKI_CFG_FILE);
+
+    const ysize_t size = 1000;
+    yvar_t arr = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    yvar_array_with_size(arr, NULL, 0);
+    ysize_t i;
+
+    for (i = 0; i < size; i++) {
+        yvar_uint64(value, i);
+        ASSERT_TRUE(yvar_array_push(arr, value));
+        ASSERT_EQ(i + 1, yvar_count(arr));
+    }
+
+    for (i = 0; i < size; i++) {
+        ASSERT_EQ(i, arr.data.yarray_data.yvars[i].data.yuint64_data);
+    }
+
+    // reserved array doesn't move
+    ASSERT_TRUE(yvar_array_reserve(arr, size * 3));
+    const yvar_t * yvars = arr.data.yarray_data.yvars;
+
+    for (i = size; i < size * 3; i++) {
+        yvar_uint64(value, i);
+        ASSERT_TRUE(yvar_array_push(arr, value));
+    }
+
+    ASSERT_EQ(yvars, arr.data.yarray_data.yvars);
+    ASSERT_EQ(size * 3, yvar_count(arr));
+
+    // a copy cannot overwrite vars pushed by another one
+    yvar_t copy = YVAR_EMPTY();
+    yvar_t str = YVAR_EMPTY();
+    yvar_array_with_size(arr, NULL, 0);
+    yvar_int32(value, 1);
+    ASSERT_TRUE(yvar_array_push(arr, value));
+    ASSERT_TRUE(yvar_assign(copy, arr));
+    yvar_int32(value, 2);
+    ASSERT_TRUE(yvar_array_push(arr, value));
+    yvar_cstr(str, "copy");
+    ASSERT_TRUE(yvar_array_push(copy, str));
+    ASSERT_EQ(2, arr.data.yarray_data.yvars[1].data.yint32_data);
+    ASSERT_TRUE(yvar_equal(copy.data.yarray_data.yvars[1], str));
+    ASSERT_EQ(1, copy.data.yarray_data.yvars[0].data.yint32_data);
+
+    // clone is a plain array
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, copy));
+    ASSERT_FALSE(yvar_has_option(*cloned, YVAR_OPTION_GROWABLE));
+    ASSERT_TRUE(yvar_equal(copy, *cloned));
+    ASSERT_TRUE(yvar_array_push(*cloned, value));
+    ASSERT_EQ(3u, yvar_count(*cloned));
+    ASSERT_EQ(2u, yvar_count(copy));
+
+    // readonly array cannot grow
+    yvar_set_option(copy, YVAR_OPTION_READONLY);
+    ASSERT_FALSE(yvar_array_push(copy, value));
+    ASSERT_FALSE(yvar_array_reserve(copy, 10));
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, Packed) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yint64_t raw_ids[] = {5, -3, 9, 0, 7};
+    yvar_t ids = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    yint64_t int_value = 0;
+    yint64_t total = 0;
+    ysize_t index = 0;
+
+    yvar_packed(ids, YVAR_TYPE_INT64, raw_ids, 5);
+    ASSERT_TRUE(yvar_is_packed(ids));
+    ASSERT_EQ(YVAR_TYPE_INT64, yvar_packed_type(ids));
+    ASSERT_EQ(5u, yvar_count(ids));
+    ASSERT_EQ(raw_ids, yvar_packed_data(ids, int64));
+
+    FOREACH_YVAR_PACKED(ids, int64, id) {
+        total += *id;
+    }
+
+    ASSERT_EQ(18, total);
+
+    // element type doesn't match
+    total = 0;
+
+    FOREACH_YVAR_PACKED(ids, int32, id32) {
+        total += *id32;
+    }
+
+    ASSERT_EQ(0, total);
+
+    ASSERT_TRUE(yvar_packed_get(ids, 1, value));
+    ASSERT_EQ(YVAR_TYPE_INT64, value.type);
+    ASSERT_TRUE(yvar_get_int64(value, int_value));
+    ASSERT_EQ(-3, int_value);
+    ASSERT_TRUE(yvar_packed_get(ids, 5, value));
+    ASSERT_TRUE(yvar_is_undefined(value));
+
+    // value is converted to element type
+    yvar_uint8(value, 100);
+    ASSERT_TRUE(yvar_packed_set(ids, 3, value));
+    ASSERT_EQ(100, raw_ids[3]);
+    ASSERT_FALSE(yvar_packed_set(ids, 5, value));
+    yvar_cstr(value, "100");
+    ASSERT_FALSE(yvar_packed_set(ids, 3, value));
+
+    // clone copies elements
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, ids));
+    ASSERT_NE(raw_ids, yvar_packed_data(*cloned, int64));
+    ASSERT_TRUE(yvar_equal(ids, *cloned));
+    ASSERT_EQ(0, yvar_compare(ids, *cloned));
+    yvar_int64(value, 6);
+    ASSERT_TRUE(yvar_packed_set(*cloned, 0, value));
+    ASSERT_FALSE(yvar_equal(ids, *cloned));
+    ASSERT_GT(0, yvar_compare(ids, *cloned));
+
+    // frozen packed array is copied before it's modified
+    yvar_t frozen = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_assign(frozen, ids));
+    ASSERT_TRUE(yvar_freeze(frozen));
+    ASSERT_TRUE(yvar_packed_set(frozen, 0, value));
+    ASSERT_EQ(5, raw_ids[0]);
+    ASSERT_EQ(6, yvar_packed_data(frozen, int64)[0]);
+
+    yvar_set_option(ids, YVAR_OPTION_READONLY);
+    ASSERT_FALSE(yvar_packed_set(ids, 0, value));
+
+    // packed array is not a scalar
+    ybool_t bool_value = yfalse;
+    ASSERT_FALSE(yvar_get_int64(ids, int_value));
+    ASSERT_TRUE(yvar_get_bool(ids, bool_value));
+    ASSERT_TRUE(bool_value);
+
+    // pack and unpack an array
+    yvar_t raw_values[3];
+    yvar_t arr = YVAR_EMPTY();
+    yvar_t packed = YVAR_EMPTY();
+    yvar_t unpacked = YVAR_EMPTY();
+    yvar_int32(raw_values[0], 1);
+    yvar_uint64(raw_values[1], 300);
+    yvar_int8(raw_values[2], -1);
+    yvar_array(arr, raw_values);
+    ASSERT_TRUE(yvar_packed_from_array(packed, arr, YVAR_TYPE_INT16));
+    ASSERT_EQ(YVAR_TYPE_INT16, yvar_packed_type(packed));
+    ASSERT_EQ(3u, yvar_count(packed));
+    ASSERT_EQ(300, yvar_packed_data(packed, int16)[1]);
+    ASSERT_TRUE(yvar_packed_to_array(unpacked, packed));
+    ASSERT_TRUE(yvar_is_array(unpacked));
+    ASSERT_EQ(3u, yvar_count(unpacked));
+    ASSERT_EQ(YVAR_TYPE_INT16, unpacked.data.yarray_data.yvars[2].type);
+    ASSERT_EQ(-1, unpacked.data.yarray_data.yvars[2].data.yint16_data);
+
+    // 300 and -1 are out of range of uint8
+    ASSERT_FALSE(yvar_packed_from_array(packed, arr, YVAR_TYPE_UINT8));
+
+    yvar_t list = YVAR_EMPTY();
+    yvar_list(list);
+
+    for (int i = 0; i < 100; i++) {
+        yvar_int32(value, i);
+        ASSERT_TRUE(yvar_list_push_back(list, value));
+    }
+
+    ASSERT_TRUE(yvar_packed_from_array(packed, list, YVAR_TYPE_UINT8));
+    ASSERT_EQ(100u, yvar_count(packed));
+    ASSERT_EQ(99, yvar_packed_data(packed, uint8)[99]);
+
+    yvar_int64(value, 42);
+    ASSERT_TRUE(yvar_packed_find(packed, value, index));
+    ASSERT_EQ(42u, index);
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, PackedKernels) {
+    yuki_init(YUKI_CFG_FILE);
+
+    // lengths around lanes of vectors
+    const ysize_t sizes[] = {0, 1, 3, 4, 5, 15, 31, 32, 33, 63, 100, 1000};
+    yvar_t packed = YVAR_EMPTY();
+    yvar_t sum = YVAR_EMPTY();
+    yvar_t min = YVAR_EMPTY();
+    yvar_t max = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    ysize_t i, j, index;
+
+    for (i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+        ysize_t size = sizes[i];
+        yint64_t * int64s = (yint64_t*)ybuffer_simple_alloc(size * sizeof(yint64_t) + 1);
+        yuint32_t * uint32s = (yuint32_t*)ybuffer_simple_alloc(size * sizeof(yuint32_t) + 1);
+        yint8_t * int8s = (yint8_t*)ybuffer_simple_alloc(size + 1);
+        yint64_t expected_sum = 0, expected_min = 0, expected_max = 0;
+        yuint64_t expected_usum = 0;
+
+        for (j = 0; j < size; j++) {
+            int64s[j] = (yint64_t)((j * 7919) % 1009) - 500;
+            uint32s[j] = (yuint32_t)(4000000000u - j * 13);
+            int8s[j] = (yint8_t)(j * 37);
+            expected_sum += int64s[j];
+            expected_usum += uint32s[j];
+            expected_min = !j || int64s[j] < expected_min? int64s[j]: expected_min;
+            expected_max = !j || int64s[j] > expected_max? int64s[j]: expected_max;
+        }
+
+        yvar_packed(packed, YVAR_TYPE_INT64, int64s, size);
+        ASSERT_TRUE(yvar_packed_sum(packed, sum));
+        ASSERT_EQ(YVAR_TYPE_INT64, sum.type);
+        ASSERT_EQ(expected_sum, sum.data.yint64_data) << "size " << size;
+
+        if (!size) {
+            ASSERT_FALSE(yvar_packed_min_max(packed, min, max));
+            continue;
+        }
+
+        ASSERT_TRUE(yvar_packed_min_max(packed, min, max));
+        ASSERT_EQ(expected_min, min.data.yint64_data) << "size " << size;
+        ASSERT_EQ(expected_max, max.data.yint64_data) << "size " << size;
+
+        // last element is found in tail or in the last vector
+        yvar_int64(value, int64s[size - 1]);
+        ASSERT_TRUE(yvar_packed_find(packed, value, index));
+        ASSERT_EQ(int64s[size - 1], int64s[index]);
+
+        for (j = 0; j < index; j++) {
+            ASSERT_NE(int64s[index], int64s[j]);
+        }
+
+        yvar_int64(value, 10000);
+        ASSERT_FALSE(yvar_packed_find(packed, value, index));
+
+        yvar_packed(packed, YVAR_TYPE_UINT32, uint32s, size);
+        ASSERT_TRUE(yvar_packed_sum(packed, sum));
+        ASSERT_EQ(YVAR_TYPE_UINT64, sum.type);
+        ASSERT_EQ(expected_usum, sum.data.yuint64_data);
+        ASSERT_TRUE(yvar_packed_min_max(packed, min, max));
+        ASSERT_EQ(uint32s[size - 1], min.data.yuint32_data);
+        ASSERT_EQ(4000000000u, max.data.yuint32_data);
+        yvar_uint32(value, uint32s[size - 1]);
+        ASSERT_TRUE(yvar_packed_find(packed, value, index));
+        ASSERT_EQ(size - 1, index);
+
+        // negative value cannot be found in unsigned array
+        yvar_int32(value, -1);
+        ASSERT_FALSE(yvar_packed_find(packed, value, index));
+
+        yvar_packed(packed, YVAR_TYPE_INT8, int8s, size);
+        yint8_t int8_min = int8s[0], int8_max = int8s[0];
+        yint64_t int8_sum = 0;
+
+        for (j = 0; j < size; j++) {
+            int8_min = int8s[j] < int8_min? int8s[j]: int8_min;
+            int8_max = int8s[j] > int8_max? int8s[j]: int8_max;
+            int8_sum += int8s[j];
+        }
+
+        ASSERT_TRUE(yvar_packed_sum(packed, sum));
+        ASSERT_EQ(int8_sum, sum.data.yint64_data);
+        ASSERT_TRUE(yvar_packed_min_max(packed, min, max));
+        ASSERT_EQ(YVAR_TYPE_INT8, min.type);
+        ASSERT_EQ(int8_min, min.data.yint8_data) << "size " << size;
+        ASSERT_EQ(int8_max, max.data.yint8_data) << "size " << size;
+    }
+
+    // sum of bools counts true
+    ybool_t bools[40] = {0};
+    bools[3] = bools[35] = bools[39] = ytrue;
+    yvar_packed(packed, YVAR_TYPE_BOOL, bools, 40);
+    ASSERT_TRUE(yvar_packed_sum(packed, sum));
+    ASSERT_EQ(3u, sum.data.yuint64_data);
+    yvar_bool(value, ytrue);
+    ASSERT_TRUE(yvar_packed_find(packed, value, index));
+    ASSERT_EQ(3u, index);
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, ArrayExtract) {
+    yuki_init(YUKI_CFG_FILE);
+
+    const ysize_t rows = 50;
+    yvar_t raw_keys[3];
+    yvar_t keys = YVAR_EMPTY();
+    yvar_t values[rows][3];
+    yvar_t value_arrays[rows];
+    yvar_t maps[rows];
+    yvar_t key = YVAR_EMPTY();
+    yvar_t result = YVAR_EMPTY();
+    yint64_t ids[rows];
+    yuint64_t cashes[rows];
+    ycstr_t names[rows];
+    ysize_t i;
+
+    yvar_cstr(raw_keys[0], "uid");
+    yvar_cstr(raw_keys[1], "name");
+    yvar_cstr(raw_keys[2], "cash");
+    yvar_array(keys, raw_keys);
+
+    for (i = 0; i < rows; i++) {
+        yvar_int64(values[i][0], i * 10);
+        yvar_cstr(values[i][1], "huandu");
+        // value types can be different in rows
+        if (i % 2) {
+            yvar_uint32(values[i][2], i);
+        } else {
+            yvar_uint64(values[i][2], i);
+        }
+
+        yvar_array(value_arrays[i], values[i]);
+        yvar_map(maps[i], keys, value_arrays[i]);
+    }
+
+    yvar_array_with_size(result, maps, rows);
+
+    yvar_cstr(key, "uid");
+    ASSERT_TRUE(yvar_array_extract_int64(result, key, ids, rows));
+    yvar_cstr(key, "cash");
+    ASSERT_TRUE(yvar_array_extract_uint64(result, key, cashes, rows));
+    yvar_cstr(key, "name");
+    ASSERT_TRUE(yvar_array_extract_cstr(result, key, names, rows));
+
+    for (i = 0; i < rows; i++) {
+        ASSERT_EQ((yint64_t)i * 10, ids[i]);
+        ASSERT_EQ(i, cashes[i]);
+        ASSERT_EQ(6u, names[i].size);
+        ASSERT_STREQ("huandu", names[i].str);
+    }
+
+    // keys of cloned rows are compared instead of shared
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, result));
+    yvar_cstr(key, "cash");
+    memset(cashes, 0, sizeof(cashes));
+    ASSERT_TRUE(yvar_array_extract_uint64(*cloned, key, cashes, rows));
+    ASSERT_EQ(rows - 1, cashes[rows - 1]);
+
+    // keys in different order
+    yvar_t reversed_raw_keys[3];
+    yvar_t reversed_keys = YVAR_EMPTY();
+    yvar_t reversed_values[3];
+    yvar_t reversed_value_array = YVAR_EMPTY();
+    reversed_raw_keys[0] = raw_keys[2];
+    reversed_raw_keys[1] = raw_keys[1];
+    reversed_raw_keys[2] = raw_keys[0];
+    reversed_values[0] = values[rows - 1][2];
+    reversed_values[1] = values[rows - 1][1];
+    yvar_int64(reversed_values[2], -1);
+    yvar_array(reversed_keys, reversed_raw_keys);
+    yvar_array(reversed_value_array, reversed_values);
+    yvar_map(maps[rows - 1], reversed_keys, reversed_value_array);
+    yvar_cstr(key, "uid");
+    ASSERT_TRUE(yvar_array_extract_int64(result, key, ids, rows));
+    ASSERT_EQ(-1, ids[rows - 1]);
+    ASSERT_EQ(10, ids[1]);
+
+    // fewer rows than required
+    ASSERT_FALSE(yvar_array_extract_int64(result, key, ids, rows + 1));
+    ASSERT_TRUE(yvar_array_extract_int64(result, key, ids, 0));
+
+    // key is not found or value type is wrong
+    yvar_cstr(key, "not_found");
+    ASSERT_FALSE(yvar_array_extract_int64(result, key, ids, rows));
+    yvar_cstr(key, "name");
+    ASSERT_FALSE(yvar_array_extract_int64(result, key, ids, rows));
+    yvar_cstr(key, "uid");
+    ASSERT_FALSE(yvar_array_extract_cstr(result, key, names, rows));
+
+    // a negative int64 cannot be an uint64
+    ASSERT_FALSE(yvar_array_extract_uint64(result, key, cashes, rows));
+
+    // undefined key extracts rows themselves
+    yvar_t raw_ints[100];
+    yvar_t ints = YVAR_EMPTY();
+    yint64_t int_values[100];
+
+    for (i = 0; i < 100; i++) {
+        yvar_int64(raw_ints[i], (yint64_t)i - 50);
+    }
+
+    yvar_array(ints, raw_ints);
+    yvar_undefined(key);
+    ASSERT_TRUE(yvar_array_extract_int64(ints, key, int_values, 100));
+    ASSERT_EQ(-50, int_values[0]);
+    ASSERT_EQ(49, int_values[99]);
+
+    yvar_int8(raw_ints[10], 7);
+    ASSERT_TRUE(yvar_array_extract_int64(ints, key, int_values, 100));
+    ASSERT_EQ(7, int_values[10]);
+    ASSERT_EQ(-39, int_values[11]);
+
+    yvar_cstr(raw_ints[10], "7");
+    ASSERT_FALSE(yvar_array_extract_int64(ints, key, int_values, 100));
+
+    yuki_shutdown();
+}
+
+TEST(YukiVarTest, Walk) {
+    yuki_init(YUKI_CFG_FILE);
+
+    yvar_t raw_ints[5];
+    yvar_t raw_keys[1];
+    yvar_t raw_values[1];
+    yvar_t raw_arr[4];
+    yvar_t keys = YVAR_EMPTY();
+    yvar_t values = YVAR_EMPTY();
+    yvar_t arr = YVAR_EMPTY();
+    ysize_t i;
+
+    for (i = 0; i < 5; i++) {
+        yvar_int32(raw_ints[i], (yint32_t)i + 1);
+    }
+
+    yvar_cstr(raw_keys[0], "a");
+    yvar_int32(raw_values[0], 6);
+    yvar_array(keys, raw_keys);
+    yvar_array(values, raw_values);
+    raw_arr[0] = raw_ints[0];
+    yvar_array_with_size(raw_arr[1], raw_ints + 1, 2);
+    yvar_list(raw_arr[2]);
+    ASSERT_TRUE(yvar_list_push_back(raw_arr[2], raw_ints[3]));
+    ASSERT_TRUE(yvar_list_push_back(raw_arr[2], raw_ints[4]));
+    yvar_map(raw_arr[3], keys, values);
+    yvar_array(arr, raw_arr);
+
+    // post is called with index of the var in its parent
+    test_walk_ctx_t ctx = {"", 0, 0, 0};
+    ASSERT_TRUE(yvar_walk(arr, &_test_walk_enter, &_test_walk_leave, &ctx));
+    ASSERT_EQ("[1[23]1[45]2M]0", ctx.trace);
+    ASSERT_EQ(2u, ctx.max_depth);
+
+    // stop at the 3rd int
+    test_walk_ctx_t stop_ctx = {"", 0, 3, 0};
+    ASSERT_FALSE(yvar_walk(arr, &_test_walk_enter, &_test_walk_leave, &stop_ctx));
+    ASSERT_EQ("[1[23", stop_ctx.trace);
+
+    // peer is walked in step
+    yvar_t * cloned = NULL;
+    yvar_t element = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    ASSERT_TRUE(yvar_clone(cloned, arr));
+    ASSERT_TRUE(yvar_walk_with_peer(arr, *cloned, &_test_walk_add_one, NULL, NULL));
+
+    test_walk_ctx_t peer_ctx = {"", 0, 0, 0};
+    ASSERT_TRUE(yvar_walk(*cloned, &_test_walk_enter, &_test_walk_leave, &peer_ctx));
+    ASSERT_EQ("[2[34]1[56]2M]0", peer_ctx.trace);
+    ASSERT_TRUE(yvar_array_get(*cloned, 3, element));
+    ASSERT_TRUE(yvar_map_get(element, raw_keys[0], value));
+    ASSERT_EQ(7, value.data.yint32_data);
+    ASSERT_FALSE(yvar_equal(arr, *cloned));
+
+    // shapes are different
+    ASSERT_FALSE(yvar_walk_with_peer(arr, raw_arr[1], &_test_walk_add_one, NULL, NULL));
+
+    // nested far deeper than stack of walk
+    const ysize_t depth = 1000;
+    yvar_t * nested = (yvar_t*)ybuffer_simple_alloc(depth * sizeof(yvar_t));
+
+    for (i = 0; i < depth - 1; i++) {
+        yvar_array_with_size(nested[i], nested + i + 1, 1);
+    }
+
+    yvar_int32(nested[depth - 1], 1);
+
+    test_walk_ctx_t deep_ctx = {"", 0, 0, 0};
+    ASSERT_TRUE(yvar_walk(nested[0], &_test_walk_enter, NULL, &deep_ctx));
+    ASSERT_EQ(depth - 1, deep_ctx.max_depth);
+    ASSERT_EQ(1u, deep_ctx.ints);
+
+    yvar_t * pinned = NULL;
+    ASSERT_TRUE(yvar_pin(pinned, nested[0]));
+    ASSERT_TRUE(yvar_equal(*pinned, nested[0]));
+    ASSERT_TRUE(yvar_freeze(*pinned));
+
+    ASSERT_TRUE(yvar_clone(cloned, nested[0]));
+    ASSERT_TRUE(yvar_equal(*cloned, nested[0]));
+    yvar_int32(nested[depth - 1], 2);
+    ASSERT_FALSE(yvar_equal(*cloned, nested[0]));
+    ASSERT_FALSE(yvar_equal(*pinned, nested[0]));
+
+    ASSERT_TRUE(yvar_unpin(pinned));
+    yuki_clean_up();
+}
+
+TEST(YukiVarTest, MapRows) {
+    yuki_init(YUKI_CFG_FILE);
+
+    // enough keys to build an index
+    const ysize_t fields = YVAR_MAP_INDEX_THRESHOLD + 2;
+    const ysize_t rows = 100;
+    char names[fields][8];
+    char texts[rows][64];
+    yvar_t raw_keys[fields];
+    yvar_t keys = YVAR_EMPTY();
+    yvar_t values = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    ysize_t i, j;
+
+    for (i = 0; i < fields; i++) {
+        snprintf(names[i], sizeof(names[i]), "f%lu", (unsigned long)i);
+        yvar_cstr_with_size(raw_keys[i], names[i], strlen(names[i]));
+    }
+
+    yvar_array(keys, raw_keys);
+    yvar_array_with_size(values, NULL, 0);
+
+    for (i = 0; i < rows; i++) {
+        snprintf(texts[i], sizeof(texts[i]), "row %lu has a string longer than inline one", (unsigned long)i);
+
+        for (j = 0; j < fields; j++) {
+            if (j % 2) {
+                yvar_cstr_with_size(value, texts[i], strlen(texts[i]));
+            } else {
+                yvar_int64(value, (yint64_t)(i * fields + j));
+            }
+
+            ASSERT_TRUE(yvar_array_push(values, value));
+        }
+    }
+
+    yvar_t * result = NULL;
+    ASSERT_TRUE(yvar_map_rows(result, keys, values));
+    ASSERT_EQ(rows, yvar_count(*result));
+
+    // result doesn't refer to strings of caller any more
+    memset(names, 'x', sizeof(names));
+    memset(texts, 'x', sizeof(texts));
+
+    yvar_t row = YVAR_EMPTY();
+    yvar_t key = YVAR_EMPTY();
+    yint64_t int_value = 0;
+    ASSERT_TRUE(yvar_array_get(*result, 42, row));
+    ASSERT_TRUE(yvar_is_map(row));
+    ASSERT_TRUE(yvar_has_option(row, YVAR_OPTION_INDEXED));
+    ASSERT_EQ(fields, yvar_count(row));
+
+    yvar_cstr(key, "f4");
+    ASSERT_TRUE(yvar_map_get(row, key, value));
+    ASSERT_TRUE(yvar_get_int64(value, int_value));
+    ASSERT_EQ((yint64_t)(42 * fields + 4), int_value);
+
+    yvar_cstr(key, "f9");
+    ASSERT_TRUE(yvar_map_get(row, key, value));
+    ASSERT_STREQ("row 42 has a string longer than inline one", yvar_cstr_buffer(value));
+
+    // result can be cloned like any other var
+    yvar_t * cloned = NULL;
+    ASSERT_TRUE(yvar_clone(cloned, *result));
+    ASSERT_TRUE(yvar_equal(*cloned, *result));
+
+    // values must be split into rows evenly
+    ASSERT_TRUE(yvar_array_push(values, value));
+    ASSERT_FALSE(yvar_map_rows(result, keys, values));
+
+    yuki_clean_up();
+}
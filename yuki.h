@@ -7,10 +7,13 @@
 #include "yuki_toolkit.h"
 
 #include "yuki_init.h"
+#include "yuki_thread.h"
 #include "yuki_log.h"
 #include "yuki_buffer.h"
 
 #include "yuki_var.h"
+#include "yuki_serialize.h"
+#include "yuki_json.h"
 #include "yuki_table.h"
 
 #endif
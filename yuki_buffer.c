@@ -1,25 +1,58 @@
 #include <errno.h>
 #include <stdlib.h>
+#include <string.h>
 #include <pthread.h>
 #include <assert.h>
+#include <unistd.h>
+#include <sys/mman.h>
 
 #include "libconfig.h"
 #include "yuki.h"
 
-static pthread_key_t g_ybuffer_thread_key;
-static pthread_mutex_t g_ybuffer_global_buffer_mutex = PTHREAD_MUTEX_INITIALIZER;
-static ybool_t g_ybuffer_global_buffer_inited = yfalse;
+#define YBUFFER_CONFIG_PATH_RETAIN_BYTES YUKI_CONFIG_SECTION_YBUFFER "/retain_bytes"
+#define YBUFFER_CONFIG_PATH_MMAP_THRESHOLD YUKI_CONFIG_SECTION_YBUFFER "/mmap_threshold"
+#define YBUFFER_CONFIG_PATH_HUGE_PAGE YUKI_CONFIG_SECTION_YBUFFER "/huge_page"
+#define YBUFFER_CONFIG_PATH_THREAD_BUDGET YUKI_CONFIG_SECTION_YBUFFER "/thread_budget"
+
+// offset of a dedicated block mapped by mmap. malloc-ed block has offset equal to size.
+#define YBUFFER_BLOCK_MAPPED ((ysize_t)-1)
+
+/**
+ * global buffers are spread over shards to avoid contention.
+ * each thread picks a shard in round robin and sticks to it.
+ * shard is padded to its own cache line.
+ */
+typedef struct _ybuffer_shard_t {
+    pthread_mutex_t mutex;
+    ybuffer_t * chain;
+    ysize_t bytes; /**< memory held by chain */
+} __attribute__((aligned(64))) ybuffer_shard_t;
+
+static ybuffer_shard_t g_ybuffer_shards[YBUFFER_GLOBAL_SHARD_COUNT];
+static pthread_once_t g_ybuffer_shards_once = PTHREAD_ONCE_INIT;
+static yuint32_t g_ybuffer_next_shard = 0;
+static volatile ybool_t g_ybuffer_global_buffer_inited = yfalse;
 static ybool_t g_ybuffer_inited = yfalse;
-static ybuffer_t * g_ybuffer_global_chain = NULL;
+static ysize_t g_ybuffer_retain_bytes = YBUFFER_RETAIN_BYTES;
+static ysize_t g_ybuffer_mmap_threshold = YBUFFER_MMAP_THRESHOLD;
+static ybool_t g_ybuffer_huge_page = ytrue;
+static ysize_t g_ybuffer_thread_budget = 0;
+static ybuffer_budget_func g_ybuffer_budget_callback = NULL;
+static void * g_ybuffer_budget_callback_data = NULL;
 
-static void _ybuffer_thread_clean_up(void * head)
-{
-    if (!head) {
-        YUKI_LOG_DEBUG("buffer chain is empty");
-        return;
-    }
+// counters of exited threads. guarded by thread context registry lock.
+static ybuffer_stats_t g_ybuffer_retired_stats;
 
-    ybuffer_t * buffer = (ybuffer_t*)head;
+// thread counters are only written by their owner and read by ybuffer_stats() in any thread.
+// owner reads them without atomic as no one else writes.
+#define YBUFFER_STATS_SET(counter, value) __atomic_store_n(&(counter), (value), __ATOMIC_RELAXED)
+#define YBUFFER_STATS_ADD(counter, n) YBUFFER_STATS_SET((counter), (counter) + (n))
+#define YBUFFER_STATS_SUB(counter, n) YBUFFER_STATS_SET((counter), (counter) - (n))
+
+static void _ybuffer_pool_thread_flush(yuki_thread_ctx_t * ctx);
+
+static void _ybuffer_free_chain(ybuffer_t * buffer)
+{
     ybuffer_t * next = NULL;
 
     while (buffer) {
@@ -29,35 +62,244 @@ static void _ybuffer_thread_clean_up(void * head)
     }
 }
 
-static void _ybuffer_global_clean_up()
+/**
+ * map a dedicated block for big memory.
+ * cached mapping of this thread is reused if it's large enough.
+ */
+static ybuffer_t * _ybuffer_block_map(ybuffer_arena_t * arena, ysize_t size)
+{
+    ybuffer_t * block = arena->mapped;
+
+    if (block && block->size >= size) {
+        arena->mapped = NULL;
+        return block;
+    }
+
+    ysize_t page_size = (ysize_t)sysconf(_SC_PAGESIZE);
+    ysize_t align = page_size;
+
+    // huge page can only back memory aligned to huge page size
+    if (g_ybuffer_huge_page && sizeof(ybuffer_t) + size >= YBUFFER_HUGE_PAGE_SIZE) {
+        align = YBUFFER_HUGE_PAGE_SIZE;
+    }
+
+    ysize_t length = (sizeof(ybuffer_t) + size + align - 1) & ~(align - 1);
+    ysize_t extra = align > page_size? align: 0;
+    char * addr = (char*)mmap(NULL, length + extra, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+    if (MAP_FAILED == addr) {
+        YUKI_LOG_FATAL("cannot map memory. [size: %lu] [length: %lu] [err: %d]", size, length + extra, errno);
+        return NULL;
+    }
+
+    if (extra) {
+        char * aligned = (char*)(((ysize_t)addr + align - 1) & ~(align - 1));
+
+        if (aligned != addr) {
+            munmap(addr, aligned - addr);
+        }
+
+        if (aligned + length != addr + length + extra) {
+            munmap(aligned + length, addr + extra - aligned);
+        }
+
+        addr = aligned;
+
+#ifdef MADV_HUGEPAGE
+        // it's only a hint. kernel may not support it.
+        madvise(addr, length, MADV_HUGEPAGE);
+#endif
+    }
+
+    block = (ybuffer_t*)addr;
+    block->size = length - sizeof(ybuffer_t);
+    block->offset = YBUFFER_BLOCK_MAPPED;
+    block->next = NULL;
+    return block;
+}
+
+/**
+ * release a dedicated block.
+ * if `retain` is not 0, one mapped block is cached by arena for reuse.
+ * its pages are dropped unless the whole mapping fits in `retain`.
+ */
+static void _ybuffer_block_release(ybuffer_arena_t * arena, ybuffer_t * block, ysize_t retain)
 {
-    if (!g_ybuffer_global_chain) {
-        YUKI_LOG_DEBUG("global buffer chain is empty");
+    if (YBUFFER_BLOCK_MAPPED != block->offset) {
+        free(block);
+        return;
+    }
+
+    ysize_t length = sizeof(ybuffer_t) + block->size;
+
+    if (retain && !arena->mapped) {
+        ysize_t page_size = (ysize_t)sysconf(_SC_PAGESIZE);
+
+        // header page stays. the rest is given back to system but address is kept.
+        if (length > retain && length > page_size) {
+            madvise((char*)block + page_size, length - page_size, MADV_DONTNEED);
+        }
+
+        block->next = NULL;
+        arena->mapped = block;
         return;
     }
 
+    munmap(block, length);
+}
+
+static void _ybuffer_block_release_chain(ybuffer_arena_t * arena, ybuffer_t * block, ysize_t retain)
+{
+    ybuffer_t * next = NULL;
+
+    while (block) {
+        next = block->next;
+        _ybuffer_block_release(arena, block, retain);
+        block = next;
+    }
+}
+
+/**
+ * release arena memory but keep at most `retain` bytes of chunks as spare.
+ * spare chunks are reused by later allocation in the same thread.
+ */
+static void _ybuffer_chunks_retain(ybuffer_t * chunk, ybuffer_t ** spare, ysize_t * kept, ysize_t retain)
+{
+    ybuffer_t * next = NULL;
+
+    for (; chunk; chunk = next) {
+        next = chunk->next;
+
+        if (*kept + chunk->size > retain) {
+            free(chunk);
+            continue;
+        }
+
+        *kept += chunk->size;
+        chunk->offset = 0;
+        chunk->next = *spare;
+        *spare = chunk;
+    }
+}
+
+static void _ybuffer_arena_reset(ybuffer_arena_t * arena, ysize_t retain)
+{
+    ybuffer_t * spare = NULL;
+    ybuffer_chain_t * chain = NULL;
+    ybuffer_chain_t * next = NULL;
+    ysize_t kept = 0;
+
+    _ybuffer_chunks_retain(arena->chunks, &spare, &kept, retain);
+
+    for (chain = arena->adopted; chain; chain = next) {
+        // chain is freed with its own chunks
+        ybuffer_t * chunks = chain->chunks;
+        ybuffer_t * blocks = chain->blocks;
+        next = chain->next;
+
+        _ybuffer_block_release_chain(arena, blocks, retain);
+        _ybuffer_chunks_retain(chunks, &spare, &kept, retain);
+    }
+
+    _ybuffer_chunks_retain(arena->spare, &spare, &kept, retain);
+    _ybuffer_block_release_chain(arena, arena->blocks, retain);
+    _ybuffer_free_chain(arena->retired);
+
+    if (!retain && arena->mapped) {
+        _ybuffer_block_release(arena, arena->mapped, 0);
+        arena->mapped = NULL;
+    }
+
+    arena->chunks = NULL;
+    arena->blocks = NULL;
+    arena->retired = NULL;
+    arena->adopted = NULL;
+    arena->spare = spare;
+    arena->next_chunk_size = YBUFFER_CHUNK_MIN_SIZE;
+}
+
+/**
+ * reset arena and its counters. peak is kept.
+ */
+static void _ybuffer_thread_reset(yuki_thread_ctx_t * ctx, ysize_t retain)
+{
+    _ybuffer_arena_reset(&ctx->arena, retain);
+    YBUFFER_STATS_SET(ctx->stats.live_bytes, 0);
+    YBUFFER_STATS_SET(ctx->stats.chunk_count, 0);
+    YBUFFER_STATS_SET(ctx->stats.wasted_bytes, 0);
+    ctx->over_budget = yfalse;
+}
+
+/**
+ * called by thread destructor.
+ */
+void _ybuffer_thread_clean_up(yuki_thread_ctx_t * ctx)
+{
+    _ybuffer_pool_thread_flush(ctx);
+    _ybuffer_thread_reset(ctx, 0);
+}
+
+/**
+ * called by thread destructor with context registry locked.
+ * move counters of exiting thread to global totals.
+ */
+void _ybuffer_thread_retire(yuki_thread_ctx_t * ctx)
+{
+    ysize_t i;
+
+    for (i = 0; i < YBUFFER_SITE_MAX; i++) {
+        g_ybuffer_retired_stats.alloc_count[i] += ctx->stats.alloc_count[i];
+    }
+
+    g_ybuffer_retired_stats.refused_count += ctx->stats.refused_count;
+
+    memset(&ctx->stats, 0, sizeof(ctx->stats));
+}
+
+static void _ybuffer_shards_init()
+{
+    ysize_t i;
+
+    for (i = 0; i < YBUFFER_GLOBAL_SHARD_COUNT; i++) {
+        pthread_mutex_init(&g_ybuffer_shards[i].mutex, NULL);
+        g_ybuffer_shards[i].chain = NULL;
+        g_ybuffer_shards[i].bytes = 0;
+    }
+}
+
+static void _ybuffer_global_clean_up()
+{
     // no matter sucess or not, clean up global buffer
-    pthread_mutex_lock(&g_ybuffer_global_buffer_mutex);
     g_ybuffer_global_buffer_inited = yfalse;
-    pthread_mutex_unlock(&g_ybuffer_global_buffer_mutex);
+    __sync_synchronize();
 
-    ybuffer_t * buffer = g_ybuffer_global_chain;
+    ybuffer_t * buffer = NULL;
     ybuffer_t * next = NULL;
     ybuffer_cookie_t * cookie = NULL;
+    ysize_t i;
 
-    while (buffer) {
-        next = buffer->next;
+    for (i = 0; i < YBUFFER_GLOBAL_SHARD_COUNT; i++) {
+        ybuffer_shard_t * shard = g_ybuffer_shards + i;
 
-        // destroy padding
-        YUKI_ASSERT(buffer->size >= ybuffer_round_up(sizeof(ybuffer_cookie_t)));
-        cookie = (ybuffer_cookie_t*)buffer->buffer;
-        cookie->padding = 0;
+        // any creator holding the lock finishes linking before sweep
+        pthread_mutex_lock(&shard->mutex);
+        buffer = shard->chain;
+        shard->chain = NULL;
+        shard->bytes = 0;
+        pthread_mutex_unlock(&shard->mutex);
 
-        free(buffer);
-        buffer = next;
-    }
+        while (buffer) {
+            next = buffer->next;
 
-    g_ybuffer_global_chain = NULL;
+            // destroy padding
+            YUKI_ASSERT(buffer->size >= ybuffer_round_up(sizeof(ybuffer_cookie_t)));
+            cookie = (ybuffer_cookie_t*)buffer->buffer;
+            cookie->padding = 0;
+
+            free(buffer);
+            buffer = next;
+        }
+    }
 }
 
 static inline ybool_t ybuffer_inited()
@@ -65,35 +307,234 @@ static inline ybool_t ybuffer_inited()
     return g_ybuffer_inited;
 }
 
-static void _ybuffer_thread_chain_add(ybuffer_t * buffer)
+/**
+ * shard of current thread.
+ */
+static inline yuint32_t _ybuffer_shard_index()
+{
+    yuki_thread_ctx_t * ctx = yuki_thread_ctx();
+
+    // 0 means not assigned yet
+    if (!ctx->shard) {
+        ctx->shard = __sync_fetch_and_add(&g_ybuffer_next_shard, 1) % YBUFFER_GLOBAL_SHARD_COUNT + 1;
+    }
+
+    return ctx->shard - 1;
+}
+
+static inline yuki_thread_ctx_t * _ybuffer_thread_ctx_get()
 {
-    // add memory to free list
-    ybuffer_t * head = (ybuffer_t*)pthread_getspecific(g_ybuffer_thread_key);
+    yuki_thread_ctx_t * ctx = yuki_thread_ctx();
+
+    if (!ctx->registered && !_ythread_ctx_register(ctx)) {
+        YUKI_LOG_FATAL("cannot register thread context for arena");
+        return NULL;
+    }
+
+    // arena is zero-filled before first use in this thread
+    if (!ctx->arena.next_chunk_size) {
+        ctx->arena.next_chunk_size = YBUFFER_CHUNK_MIN_SIZE;
+    }
+
+    return ctx;
+}
 
-    if (head) {
-        buffer->next = head->next;
-        head->next = buffer;
+static inline ybuffer_arena_t * _ybuffer_arena_get()
+{
+    yuki_thread_ctx_t * ctx = _ybuffer_thread_ctx_get();
+    return ctx? &ctx->arena: NULL;
+}
+
+/**
+ * slow path when live bytes cross thread budget.
+ */
+static ybool_t _ybuffer_budget_allow(yuki_thread_ctx_t * ctx, ysize_t size, ysize_t budget)
+{
+    ybuffer_budget_func callback = g_ybuffer_budget_callback;
+
+    if (callback && callback(ctx->stats.live_bytes, size, budget, g_ybuffer_budget_callback_data)) {
+        return ytrue;
+    }
+
+    YBUFFER_STATS_ADD(ctx->stats.refused_count, 1);
+
+    // warn once until next clean up. an over budget thread may keep trying.
+    if (ctx->over_budget) {
+        YUKI_LOG_DEBUG("thread memory budget is exceeded. [live: %lu] [size: %lu] [budget: %lu]",
+            ctx->stats.live_bytes, size, budget);
+        return yfalse;
+    }
+
+    ctx->over_budget = ytrue;
+    YUKI_LOG_WARNING("thread memory budget is exceeded. [live: %lu] [size: %lu] [budget: %lu]",
+        ctx->stats.live_bytes, size, budget);
+    return yfalse;
+}
+
+static inline void _ybuffer_stats_add_live(ybuffer_stats_t * stats, ysize_t size)
+{
+    YBUFFER_STATS_ADD(stats->live_bytes, size);
+
+    if (stats->live_bytes > stats->peak_bytes) {
+        YBUFFER_STATS_SET(stats->peak_bytes, stats->live_bytes);
+    }
+}
+
+/**
+ * carve memory from current thread arena.
+ * size must be rounded up.
+ */
+static void * _ybuffer_arena_alloc(ysize_t size, ybuffer_site_t site)
+{
+    yuki_thread_ctx_t * ctx = _ybuffer_thread_ctx_get();
+
+    if (!ctx) {
+        return NULL;
+    }
+
+    ybuffer_arena_t * arena = &ctx->arena;
+    ybuffer_stats_t * stats = &ctx->stats;
+    ybuffer_t * chunk = arena->chunks;
+    char * ret = NULL;
+
+    ysize_t budget = ctx->budget? ctx->budget: g_ybuffer_thread_budget;
+
+    if (budget && stats->live_bytes + size > budget && !_ybuffer_budget_allow(ctx, size, budget)) {
+        return NULL;
+    }
+
+    YBUFFER_STATS_ADD(stats->alloc_count[site], 1);
+
+    if (chunk && chunk->offset + size <= chunk->size) {
+        ret = chunk->buffer + chunk->offset;
+        chunk->offset += size;
+        _ybuffer_stats_add_live(stats, size);
+        return ret;
+    }
+
+    ybool_t mapped = g_ybuffer_mmap_threshold && size >= g_ybuffer_mmap_threshold;
+
+    // big memory goes to a dedicated block to avoid wasting chunk tail
+    if (mapped || size > arena->next_chunk_size / 4) {
+        if (mapped) {
+            chunk = _ybuffer_block_map(arena, size);
+        } else {
+            chunk = (ybuffer_t*)malloc(sizeof(ybuffer_t) + size);
+
+            if (!chunk) {
+                YUKI_LOG_FATAL("out of memory. [size: %lu] [actual: %lu]", size, sizeof(ybuffer_t) + size);
+                return NULL;
+            }
+
+            chunk->size = size;
+            chunk->offset = size;
+        }
+
+        if (!chunk) {
+            return NULL;
+        }
+
+        chunk->next = arena->blocks;
+        arena->blocks = chunk;
+        YBUFFER_STATS_ADD(stats->chunk_count, 1);
+        _ybuffer_stats_add_live(stats, chunk->size);
+        return chunk->buffer;
+    }
+
+    ysize_t chunk_size = arena->next_chunk_size;
+
+    // reuse retained chunk before asking system for more
+    if (arena->spare && arena->spare->size >= size) {
+        chunk = arena->spare;
+        arena->spare = chunk->next;
+        chunk_size = chunk->size;
     } else {
-        buffer->next = NULL;
-        pthread_setspecific(g_ybuffer_thread_key, buffer);
+        chunk = (ybuffer_t*)malloc(sizeof(ybuffer_t) + chunk_size);
+
+        if (!chunk) {
+            YUKI_LOG_FATAL("out of memory. [size: %lu] [actual: %lu]", size, sizeof(ybuffer_t) + chunk_size);
+            return NULL;
+        }
+
+        chunk->size = chunk_size;
+    }
+
+    // tail of previous chunk will never be used
+    if (arena->chunks) {
+        YBUFFER_STATS_ADD(stats->wasted_bytes, arena->chunks->size - arena->chunks->offset);
+    }
+
+    chunk->offset = size;
+    chunk->next = arena->chunks;
+    arena->chunks = chunk;
+    YBUFFER_STATS_ADD(stats->chunk_count, 1);
+    _ybuffer_stats_add_live(stats, size);
+
+    if (chunk_size >= arena->next_chunk_size && chunk_size < YBUFFER_CHUNK_MAX_SIZE) {
+        arena->next_chunk_size = chunk_size * 2;
     }
+
+    return chunk->buffer;
 }
 
-ybool_t _ybuffer_init(config_t * config)
+/**
+ * hand over a malloc-ed buffer to current thread arena.
+ * it will be freed in next clean up.
+ */
+static void _ybuffer_arena_retire(ybuffer_t * buffer)
 {
-    (void)config;
+    ybuffer_arena_t * arena = _ybuffer_arena_get();
+
+    if (!arena) {
+        YUKI_LOG_WARNING("cannot retire buffer to thread arena. leak it");
+        return;
+    }
 
+    buffer->next = arena->retired;
+    arena->retired = buffer;
+}
+
+ybool_t _ybuffer_init(config_t * config)
+{
     if (ybuffer_inited()) {
         return ytrue;
     }
 
-    int error = pthread_key_create(&g_ybuffer_thread_key, &_ybuffer_thread_clean_up);
+    yint32_t retain_bytes;
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_RETAIN_BYTES, retain_bytes, (yint32_t)YBUFFER_RETAIN_BYTES);
+
+    if (retain_bytes < 0) {
+        YUKI_LOG_FATAL("'%s' must not be negative", YBUFFER_CONFIG_PATH_RETAIN_BYTES);
+        return yfalse;
+    }
+
+    g_ybuffer_retain_bytes = retain_bytes;
 
-    if (error) {
-        YUKI_LOG_FATAL("cannot create thread key for ybuffer. [err: %d]", error);
+    yint32_t mmap_threshold;
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_MMAP_THRESHOLD, mmap_threshold, (yint32_t)YBUFFER_MMAP_THRESHOLD);
+
+    if (mmap_threshold < 0) {
+        YUKI_LOG_FATAL("'%s' must not be negative", YBUFFER_CONFIG_PATH_MMAP_THRESHOLD);
+        return yfalse;
+    }
+
+    g_ybuffer_mmap_threshold = mmap_threshold;
+
+    yint32_t huge_page;
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_HUGE_PAGE, huge_page, 1);
+    g_ybuffer_huge_page = huge_page? ytrue: yfalse;
+
+    yint32_t thread_budget;
+    _YTABLE_CONFIG_INT_OPTIONAL(config, YBUFFER_CONFIG_PATH_THREAD_BUDGET, thread_budget, 0);
+
+    if (thread_budget < 0) {
+        YUKI_LOG_FATAL("'%s' must not be negative", YBUFFER_CONFIG_PATH_THREAD_BUDGET);
         return yfalse;
     }
 
+    g_ybuffer_thread_budget = thread_budget;
+
+    pthread_once(&g_ybuffer_shards_once, &_ybuffer_shards_init);
     g_ybuffer_global_buffer_inited = ytrue;
     g_ybuffer_inited = ytrue;
     return ytrue;
@@ -101,24 +542,38 @@ ybool_t _ybuffer_init(config_t * config)
 
 void _ybuffer_clean_up()
 {
-    ybuffer_t * head = (ybuffer_t*)pthread_getspecific(g_ybuffer_thread_key);
-    pthread_setspecific(g_ybuffer_thread_key, NULL);
-    _ybuffer_thread_clean_up(head);
+    if (!g_ybuffer_inited) {
+        return;
+    }
+
+    _ybuffer_thread_reset(yuki_thread_ctx(), g_ybuffer_retain_bytes);
 }
 
 void _ybuffer_shutdown()
 {
+    if (g_ybuffer_inited) {
+        _ybuffer_thread_reset(yuki_thread_ctx(), 0);
+    }
+
     _ybuffer_global_clean_up();
     g_ybuffer_inited = yfalse;
 }
 
 /**
- * create a managed buffer.
+ * create a managed buffer carved from thread arena.
  * @note
  * this buffer is available in current thread.
  * do NEVER use it cross thread.
  */
 ybuffer_t * ybuffer_create(ysize_t size)
+{
+    return ybuffer_site_create(size, YBUFFER_SITE_OTHER);
+}
+
+/**
+ * same as ybuffer_create(). allocation is counted for `site`.
+ */
+ybuffer_t * ybuffer_site_create(ysize_t size, ybuffer_site_t site)
 {
     if (!g_ybuffer_inited) {
         YUKI_LOG_FATAL("ybuffer is not init-ed");
@@ -126,17 +581,15 @@ ybuffer_t * ybuffer_create(ysize_t size)
     }
 
     ysize_t rounded = ybuffer_round_up(size);
-    ybuffer_t * ptr = (ybuffer_t*)malloc(sizeof(ybuffer_t) + rounded);
+    ybuffer_t * ptr = (ybuffer_t*)_ybuffer_arena_alloc(sizeof(ybuffer_t) + rounded, site);
 
     if (!ptr) {
-        YUKI_LOG_FATAL("out of memory. [size: %lu] [actual: %lu]", size, sizeof(ybuffer_t) + rounded);
         return NULL;
     }
 
     ptr->size = rounded;
     ptr->offset = 0;
-
-    _ybuffer_thread_chain_add(ptr);
+    ptr->next = NULL;
 
     return ptr;
 }
@@ -150,6 +603,14 @@ ybuffer_t * ybuffer_create(ysize_t size)
  * global buffer will be auto freed when _ybuffer_shutdown() is called.
  */
 ybuffer_t * ybuffer_create_global(ysize_t size)
+{
+    return ybuffer_site_create_global(size, YBUFFER_SITE_OTHER);
+}
+
+/**
+ * same as ybuffer_create_global(). allocation is counted for `site`.
+ */
+ybuffer_t * ybuffer_site_create_global(ysize_t size, ybuffer_site_t site)
 {
     if (!g_ybuffer_inited) {
         YUKI_LOG_FATAL("ybuffer is not init-ed");
@@ -158,6 +619,12 @@ ybuffer_t * ybuffer_create_global(ysize_t size)
 
     ysize_t rounded = ybuffer_round_up(size);
     ysize_t cookie_size = ybuffer_round_up(sizeof(ybuffer_cookie_t));
+    yuki_thread_ctx_t * ctx = _ybuffer_thread_ctx_get();
+
+    if (!ctx) {
+        return NULL;
+    }
+
     ybuffer_t * ptr = (ybuffer_t*)malloc(sizeof(ybuffer_t) + cookie_size + rounded);
 
     if (!ptr) {
@@ -170,8 +637,11 @@ ybuffer_t * ybuffer_create_global(ysize_t size)
     ptr->offset = cookie_size;
     ybuffer_cookie_t * cookie = (ybuffer_cookie_t*)ptr->buffer;
     cookie->padding = YBUFFER_COOKIE_PADDING;
+    cookie->shard = _ybuffer_shard_index();
+    cookie->prev = NULL;
 
-    int ret = pthread_mutex_lock(&g_ybuffer_global_buffer_mutex);
+    ybuffer_shard_t * shard = g_ybuffer_shards + cookie->shard;
+    int ret = pthread_mutex_lock(&shard->mutex);
 
     if (ret) {
         YUKI_LOG_FATAL("cannot wait global buffer mutex. [err: %d]", ret);
@@ -180,29 +650,25 @@ ybuffer_t * ybuffer_create_global(ysize_t size)
     }
 
     if (!g_ybuffer_global_buffer_inited) {
+        pthread_mutex_unlock(&shard->mutex);
         YUKI_LOG_TRACE("cannot create global buffer as ybuffer is shutting down");
         free(ptr);
         return NULL;
     }
 
-    // add memory to global free list
-    if (g_ybuffer_global_chain) {
-        ptr->next = g_ybuffer_global_chain->next;
+    // add memory to shard chain
+    ptr->next = shard->chain;
 
-        if (ptr->next) {
-            ((ybuffer_cookie_t*)ptr->next->buffer)->prev = ptr;
-        }
-
-        g_ybuffer_global_chain->next = ptr;
-        cookie->prev = g_ybuffer_global_chain;
-    } else {
-        ptr->next = NULL;
-        cookie->prev = NULL;
-        g_ybuffer_global_chain = ptr;
+    if (ptr->next) {
+        ((ybuffer_cookie_t*)ptr->next->buffer)->prev = ptr;
     }
 
-    pthread_mutex_unlock(&g_ybuffer_global_buffer_mutex);
+    shard->chain = ptr;
+    shard->bytes += sizeof(ybuffer_t) + ptr->size;
 
+    pthread_mutex_unlock(&shard->mutex);
+
+    YBUFFER_STATS_ADD(ctx->stats.alloc_count[site], 1);
     return ptr;
 }
 
@@ -226,10 +692,26 @@ void * ybuffer_alloc(ybuffer_t * buffer, ysize_t size)
     return (void *)ret;
 }
 
+/**
+ * alloc memory from thread arena directly.
+ * the memory is available until next clean up.
+ */
 void * ybuffer_simple_alloc(ysize_t size)
 {
-    ybuffer_t * buffer = ybuffer_create(size);
-    return ybuffer_alloc(buffer, size);
+    return ybuffer_site_simple_alloc(size, YBUFFER_SITE_OTHER);
+}
+
+/**
+ * same as ybuffer_simple_alloc(). allocation is counted for `site`.
+ */
+void * ybuffer_site_simple_alloc(ysize_t size, ybuffer_site_t site)
+{
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return NULL;
+    }
+
+    return _ybuffer_arena_alloc(ybuffer_round_up(size), site);
 }
 
 ysize_t ybuffer_available_size(const ybuffer_t * buffer)
@@ -242,9 +724,101 @@ ysize_t ybuffer_available_size(const ybuffer_t * buffer)
     return buffer->size - buffer->offset;
 }
 
+/**
+ * get current position of thread arena.
+ * memory allocated after this call can be released by ybuffer_rewind().
+ */
+ybuffer_mark_t ybuffer_mark()
+{
+    ybuffer_mark_t mark = {NULL, 0, NULL};
+
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return mark;
+    }
+
+    ybuffer_arena_t * arena = &yuki_thread_ctx()->arena;
+    mark.chunk = arena->chunks;
+    mark.offset = arena->chunks? arena->chunks->offset: 0;
+    mark.block = arena->blocks;
+    return mark;
+}
+
+/**
+ * release all thread memory allocated after the mark.
+ * @note
+ * marks must be rewound in LIFO order.
+ * a mark is invalid after yuki_clean_up().
+ * global buffers destroyed after the mark are not affected.
+ */
+ybool_t ybuffer_rewind(ybuffer_mark_t mark)
+{
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    yuki_thread_ctx_t * ctx = yuki_thread_ctx();
+    ybuffer_arena_t * arena = &ctx->arena;
+    ybuffer_stats_t * stats = &ctx->stats;
+    ybuffer_t * chunk = arena->chunks;
+    ybuffer_t * block = arena->blocks;
+    ybuffer_t * next = NULL;
+
+    // validate mark before touching anything
+    while (chunk && chunk != mark.chunk) {
+        chunk = chunk->next;
+    }
+
+    while (block && block != mark.block) {
+        block = block->next;
+    }
+
+    if (chunk != mark.chunk || block != mark.block || (chunk && chunk->offset < mark.offset)) {
+        YUKI_LOG_WARNING("invalid buffer mark");
+        return yfalse;
+    }
+
+    // chunks after mark become spare so that next allocation can reuse them
+    for (chunk = arena->chunks; chunk != mark.chunk; chunk = next) {
+        next = chunk->next;
+        YBUFFER_STATS_SUB(stats->live_bytes, chunk->offset);
+        YBUFFER_STATS_SUB(stats->chunk_count, 1);
+        chunk->offset = 0;
+        chunk->next = arena->spare;
+        arena->spare = chunk;
+    }
+
+    for (block = arena->blocks; block != mark.block; block = next) {
+        next = block->next;
+        YBUFFER_STATS_SUB(stats->live_bytes, block->size);
+        YBUFFER_STATS_SUB(stats->chunk_count, 1);
+        _ybuffer_block_release(arena, block, g_ybuffer_retain_bytes);
+    }
+
+    arena->chunks = mark.chunk;
+    arena->blocks = mark.block;
+
+    ysize_t wasted_bytes = 0;
+
+    if (mark.chunk) {
+        YBUFFER_STATS_SUB(stats->live_bytes, mark.chunk->offset - mark.offset);
+        mark.chunk->offset = mark.offset;
+
+        // mark chunk is current again. only older chunks waste their tails.
+        for (chunk = mark.chunk->next; chunk; chunk = chunk->next) {
+            wasted_bytes += chunk->size - chunk->offset;
+        }
+    }
+
+    YBUFFER_STATS_SET(stats->wasted_bytes, wasted_bytes);
+
+    return ytrue;
+}
+
 /**
  * remove a global buffer from global chain
- * and add it to thread chain.
+ * and add it to thread arena.
  */
 ybool_t ybuffer_destroy_global(ybuffer_t * buffer)
 {
@@ -260,7 +834,13 @@ ybool_t ybuffer_destroy_global(ybuffer_t * buffer)
         return yfalse;
     }
 
-    int ret = pthread_mutex_lock(&g_ybuffer_global_buffer_mutex);
+    if (cookie->shard >= YBUFFER_GLOBAL_SHARD_COUNT) {
+        YUKI_LOG_WARNING("try to destroy a global buffer with invalid shard");
+        return yfalse;
+    }
+
+    ybuffer_shard_t * shard = g_ybuffer_shards + cookie->shard;
+    int ret = pthread_mutex_lock(&shard->mutex);
 
     if (ret) {
         YUKI_LOG_FATAL("cannot lock global buffer mutex. [err: %d]", ret);
@@ -269,11 +849,12 @@ ybool_t ybuffer_destroy_global(ybuffer_t * buffer)
 
     if (YBUFFER_COOKIE_PADDING != cookie->padding) {
         YUKI_LOG_DEBUG("current buffer is destroyed by other thread");
-        pthread_mutex_unlock(&g_ybuffer_global_buffer_mutex);
+        pthread_mutex_unlock(&shard->mutex);
         return ytrue;
     }
 
     if (!g_ybuffer_global_buffer_inited) {
+        pthread_mutex_unlock(&shard->mutex);
         YUKI_LOG_TRACE("cannot destroy buffer as ybuffer is shutting down");
         return yfalse;
     }
@@ -281,6 +862,7 @@ ybool_t ybuffer_destroy_global(ybuffer_t * buffer)
     ybuffer_t * prev = cookie->prev;
     ybuffer_t * next = buffer->next;
     cookie->padding = 0;
+    shard->bytes -= sizeof(ybuffer_t) + buffer->size;
 
     if (next) {
         ((ybuffer_cookie_t*)next->buffer)->prev = prev;
@@ -289,12 +871,11 @@ ybool_t ybuffer_destroy_global(ybuffer_t * buffer)
     if (prev) {
         prev->next = next;
     } else {
-        g_ybuffer_global_chain = next;
+        shard->chain = next;
     }
 
-    pthread_mutex_unlock(&g_ybuffer_global_buffer_mutex);
-
-    _ybuffer_thread_chain_add(buffer);
+    pthread_mutex_unlock(&shard->mutex);
+    _ybuffer_arena_retire(buffer);
     return ytrue;
 }
 
@@ -312,3 +893,457 @@ ybool_t ybuffer_destroy_global_pointer(void * pointer)
     ybuffer_t * buffer = (ybuffer_t*)((char*)pointer - ybuffer_round_up(sizeof(ybuffer_cookie_t)) - sizeof(ybuffer_t));
     return ybuffer_destroy_global(buffer);
 }
+
+static pthread_mutex_t g_ybuffer_pools_mutex = PTHREAD_MUTEX_INITIALIZER;
+static ybuffer_pool_t * g_ybuffer_pools[YBUFFER_POOL_MAX];
+static yuint32_t g_ybuffer_pool_next_id = 0;
+
+/**
+ * init a pool for objects of the same size.
+ * pool must be destroyed by ybuffer_pool_destroy() before ybuffer is shut down.
+ */
+ybool_t ybuffer_pool_init(ybuffer_pool_t * pool, ysize_t object_size)
+{
+    if (!pool || !object_size) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    pthread_mutex_lock(&g_ybuffer_pools_mutex);
+
+    yuint32_t slot;
+    for (slot = 0; slot < YBUFFER_POOL_MAX && g_ybuffer_pools[slot]; slot++) {
+        // find a free slot
+    }
+
+    if (slot == YBUFFER_POOL_MAX) {
+        pthread_mutex_unlock(&g_ybuffer_pools_mutex);
+        YUKI_LOG_FATAL("too many pools. [max: %d]", YBUFFER_POOL_MAX);
+        return yfalse;
+    }
+
+    pthread_mutex_init(&pool->mutex, NULL);
+    pool->depot = NULL;
+    pool->depot_count = 0;
+    pool->slabs = NULL;
+    pool->object_size = ybuffer_round_up(object_size < sizeof(void*)? sizeof(void*): object_size);
+    pool->id = ++g_ybuffer_pool_next_id;
+    pool->slot = slot;
+    g_ybuffer_pools[slot] = pool;
+
+    pthread_mutex_unlock(&g_ybuffer_pools_mutex);
+    return ytrue;
+}
+
+/**
+ * free all memory of a pool.
+ * objects allocated from pool are invalid after this call.
+ */
+void ybuffer_pool_destroy(ybuffer_pool_t * pool)
+{
+    if (!pool || !pool->id) {
+        return;
+    }
+
+    pthread_mutex_lock(&g_ybuffer_pools_mutex);
+    g_ybuffer_pools[pool->slot] = NULL;
+    pthread_mutex_unlock(&g_ybuffer_pools_mutex);
+
+    // magazines of other threads are dropped lazily by id check
+    ybuffer_magazine_t * magazine = yuki_thread_ctx()->magazines + pool->slot;
+
+    if (magazine->pool_id == pool->id) {
+        magazine->head = NULL;
+        magazine->count = 0;
+        magazine->pool_id = 0;
+    }
+
+    _ybuffer_free_chain(pool->slabs);
+    pthread_mutex_destroy(&pool->mutex);
+    pool->depot = NULL;
+    pool->depot_count = 0;
+    pool->slabs = NULL;
+    pool->id = 0;
+}
+
+/**
+ * move objects from pool depot to magazine.
+ * a new slab is allocated if depot is empty.
+ */
+static ybool_t _ybuffer_pool_refill(ybuffer_pool_t * pool, ybuffer_magazine_t * magazine)
+{
+    pthread_mutex_lock(&pool->mutex);
+
+    if (!pool->depot) {
+        ysize_t slab_size = pool->object_size * YBUFFER_POOL_SLAB_OBJECTS;
+        ybuffer_t * slab = (ybuffer_t*)malloc(sizeof(ybuffer_t) + slab_size);
+
+        if (!slab) {
+            pthread_mutex_unlock(&pool->mutex);
+            YUKI_LOG_FATAL("out of memory. [size: %lu]", sizeof(ybuffer_t) + slab_size);
+            return yfalse;
+        }
+
+        slab->size = slab_size;
+        slab->offset = slab_size;
+        slab->next = pool->slabs;
+        pool->slabs = slab;
+
+        char * object = slab->buffer + slab_size;
+
+        while (object != slab->buffer) {
+            object -= pool->object_size;
+            *(void**)object = pool->depot;
+            pool->depot = object;
+        }
+
+        pool->depot_count += YBUFFER_POOL_SLAB_OBJECTS;
+    }
+
+    void * head = pool->depot;
+    void * tail = head;
+    ysize_t count = 1;
+
+    while (count < YBUFFER_POOL_MAGAZINE_SIZE && *(void**)tail) {
+        tail = *(void**)tail;
+        count++;
+    }
+
+    pool->depot = *(void**)tail;
+    pool->depot_count -= count;
+
+    pthread_mutex_unlock(&pool->mutex);
+
+    *(void**)tail = magazine->head;
+    magazine->head = head;
+    magazine->count += count;
+    return ytrue;
+}
+
+/**
+ * move `count` objects from magazine back to pool depot.
+ */
+static void _ybuffer_pool_flush(ybuffer_pool_t * pool, ybuffer_magazine_t * magazine, ysize_t count)
+{
+    if (!count || !magazine->head) {
+        return;
+    }
+
+    void * head = magazine->head;
+    void * tail = head;
+    ysize_t moved = 1;
+
+    while (moved < count && *(void**)tail) {
+        tail = *(void**)tail;
+        moved++;
+    }
+
+    magazine->head = *(void**)tail;
+    magazine->count -= moved;
+
+    pthread_mutex_lock(&pool->mutex);
+    *(void**)tail = pool->depot;
+    pool->depot = head;
+    pool->depot_count += moved;
+    pthread_mutex_unlock(&pool->mutex);
+}
+
+static inline ybuffer_magazine_t * _ybuffer_pool_magazine(ybuffer_pool_t * pool)
+{
+    yuki_thread_ctx_t * ctx = yuki_thread_ctx();
+    ybuffer_magazine_t * magazine = ctx->magazines + pool->slot;
+
+    if (magazine->pool_id != pool->id) {
+        if (!ctx->registered && !_ythread_ctx_register(ctx)) {
+            YUKI_LOG_FATAL("cannot register thread context for pool");
+            return NULL;
+        }
+
+        // objects left in magazine belong to a destroyed pool
+        magazine->head = NULL;
+        magazine->count = 0;
+        magazine->pool_id = pool->id;
+    }
+
+    return magazine;
+}
+
+/**
+ * get an object from pool.
+ * the object is available in every thread until it's freed.
+ */
+void * ybuffer_pool_alloc(ybuffer_pool_t * pool)
+{
+    if (!pool || !pool->id) {
+        YUKI_LOG_FATAL("invalid pool");
+        return NULL;
+    }
+
+    ybuffer_magazine_t * magazine = _ybuffer_pool_magazine(pool);
+
+    if (!magazine) {
+        return NULL;
+    }
+
+    if (!magazine->head && !_ybuffer_pool_refill(pool, magazine)) {
+        return NULL;
+    }
+
+    void * object = magazine->head;
+    magazine->head = *(void**)object;
+    magazine->count--;
+    return object;
+}
+
+/**
+ * return an object to pool. any thread can free it.
+ */
+void ybuffer_pool_free(ybuffer_pool_t * pool, void * object)
+{
+    if (!pool || !pool->id || !object) {
+        YUKI_LOG_FATAL("invalid param");
+        return;
+    }
+
+    ybuffer_magazine_t * magazine = _ybuffer_pool_magazine(pool);
+
+    if (!magazine) {
+        return;
+    }
+
+    *(void**)object = magazine->head;
+    magazine->head = object;
+    magazine->count++;
+
+    // keep magazine bounded so that objects flow back to other threads
+    if (magazine->count >= YBUFFER_POOL_MAGAZINE_SIZE * 2) {
+        _ybuffer_pool_flush(pool, magazine, YBUFFER_POOL_MAGAZINE_SIZE);
+    }
+}
+
+/**
+ * return all magazines of a thread to their pools.
+ */
+static void _ybuffer_pool_thread_flush(yuki_thread_ctx_t * ctx)
+{
+    yuint32_t slot;
+
+    pthread_mutex_lock(&g_ybuffer_pools_mutex);
+
+    for (slot = 0; slot < YBUFFER_POOL_MAX; slot++) {
+        ybuffer_pool_t * pool = g_ybuffer_pools[slot];
+        ybuffer_magazine_t * magazine = ctx->magazines + slot;
+
+        if (pool && pool->id == magazine->pool_id) {
+            _ybuffer_pool_flush(pool, magazine, magazine->count);
+        }
+
+        magazine->head = NULL;
+        magazine->count = 0;
+        magazine->pool_id = 0;
+    }
+
+    pthread_mutex_unlock(&g_ybuffer_pools_mutex);
+}
+
+typedef struct _ybuffer_stats_sum_t {
+    yuki_thread_ctx_t * self;
+    ybuffer_stats_t * stats;
+} ybuffer_stats_sum_t;
+
+static void _ybuffer_stats_sum(yuki_thread_ctx_t * ctx, void * data)
+{
+    ybuffer_stats_sum_t * sum = (ybuffer_stats_sum_t*)data;
+    ybuffer_stats_t * stats = sum->stats;
+    ysize_t i;
+
+    // counters of other threads may be in the middle of update. it's fine for stats.
+    stats->live_bytes += __atomic_load_n(&ctx->stats.live_bytes, __ATOMIC_RELAXED);
+    stats->peak_bytes += __atomic_load_n(&ctx->stats.peak_bytes, __ATOMIC_RELAXED);
+    stats->chunk_count += __atomic_load_n(&ctx->stats.chunk_count, __ATOMIC_RELAXED);
+    stats->wasted_bytes += __atomic_load_n(&ctx->stats.wasted_bytes, __ATOMIC_RELAXED);
+
+    for (i = 0; i < YBUFFER_SITE_MAX; i++) {
+        stats->alloc_count[i] += __atomic_load_n(ctx->stats.alloc_count + i, __ATOMIC_RELAXED);
+    }
+
+    stats->refused_count += __atomic_load_n(&ctx->stats.refused_count, __ATOMIC_RELAXED);
+
+    // current thread is always registered. add exited threads once.
+    if (ctx == sum->self) {
+        for (i = 0; i < YBUFFER_SITE_MAX; i++) {
+            stats->alloc_count[i] += g_ybuffer_retired_stats.alloc_count[i];
+        }
+
+        stats->refused_count += g_ybuffer_retired_stats.refused_count;
+    }
+}
+
+/**
+ * get memory usage of current thread and of the whole process.
+ * either of thread_stats and global_stats can be NULL.
+ * @note
+ * thread counters are updated without lock. global stats just sums them up on demand.
+ * global peak_bytes is the sum of peak of live threads, an upper bound of real peak.
+ * global_bytes is memory held by all global buffers. it's only set in global stats as a global buffer
+ * can be destroyed by any thread.
+ */
+ybool_t ybuffer_stats(ybuffer_stats_t * thread_stats, ybuffer_stats_t * global_stats)
+{
+    yuki_thread_ctx_t * ctx = _ybuffer_thread_ctx_get();
+
+    if (!ctx) {
+        return yfalse;
+    }
+
+    if (thread_stats) {
+        *thread_stats = ctx->stats;
+    }
+
+    if (!global_stats) {
+        return ytrue;
+    }
+
+    ybuffer_stats_sum_t sum = {ctx, global_stats};
+    ysize_t i;
+
+    memset(global_stats, 0, sizeof(*global_stats));
+    _ythread_ctx_foreach(&_ybuffer_stats_sum, &sum);
+
+    pthread_once(&g_ybuffer_shards_once, &_ybuffer_shards_init);
+
+    for (i = 0; i < YBUFFER_GLOBAL_SHARD_COUNT; i++) {
+        pthread_mutex_lock(&g_ybuffer_shards[i].mutex);
+        global_stats->global_bytes += g_ybuffer_shards[i].bytes;
+        pthread_mutex_unlock(&g_ybuffer_shards[i].mutex);
+    }
+
+    return ytrue;
+}
+
+/**
+ * set arena byte budget of current thread.
+ * 0 means the default set by config. use YBUFFER_BUDGET_UNLIMITED to disable it.
+ * @note
+ * global buffers are not limited by budget.
+ */
+void ybuffer_set_thread_budget(ysize_t budget)
+{
+    yuki_thread_ctx()->budget = budget;
+}
+
+/**
+ * set the callback called when an allocation crosses thread budget.
+ * allocation fails if there is no callback or callback returns yfalse.
+ * it's shared by all threads and should be set before any thread starts.
+ */
+void ybuffer_set_budget_callback(ybuffer_budget_func callback, void * data)
+{
+    g_ybuffer_budget_callback_data = data;
+    g_ybuffer_budget_callback = callback;
+}
+
+/**
+ * check whether any allocation in current thread is refused by budget
+ * since last clean up.
+ */
+ybool_t ybuffer_over_budget()
+{
+    return yuki_thread_ctx()->over_budget;
+}
+
+/**
+ * get count of allocations refused by budget in current thread.
+ * compare two counts to know whether any allocation is refused in between.
+ */
+yuint64_t ybuffer_refused_count()
+{
+    return yuki_thread_ctx()->stats.refused_count;
+}
+
+/**
+ * detach all arena memory of current thread, including every var in it.
+ * the chain can be handed over to another thread and adopted by ybuffer_adopt().
+ * @note
+ * chain must be adopted by some thread, otherwise memory leaks.
+ * marks taken before detaching cannot be rewound except for those taken on empty arena.
+ * global buffers are not affected.
+ */
+ybuffer_chain_t * ybuffer_detach()
+{
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return NULL;
+    }
+
+    // chain header travels with the memory
+    ybuffer_chain_t * chain = (ybuffer_chain_t*)_ybuffer_arena_alloc(ybuffer_round_up(sizeof(ybuffer_chain_t)), YBUFFER_SITE_OTHER);
+
+    if (!chain) {
+        return NULL;
+    }
+
+    yuki_thread_ctx_t * ctx = yuki_thread_ctx();
+    ybuffer_arena_t * arena = &ctx->arena;
+    ybuffer_stats_t * stats = &ctx->stats;
+
+    // chains adopted before travel with this one. counters of them are already in stats.
+    chain->chunks = arena->chunks;
+    chain->blocks = arena->blocks;
+    chain->next = arena->adopted;
+    chain->live_bytes = stats->live_bytes;
+    chain->chunk_count = stats->chunk_count;
+    chain->wasted_bytes = stats->wasted_bytes;
+
+    // current chunk will not be carved any more
+    if (arena->chunks) {
+        chain->wasted_bytes += arena->chunks->size - arena->chunks->offset;
+    }
+
+    arena->chunks = NULL;
+    arena->blocks = NULL;
+    arena->adopted = NULL;
+    YBUFFER_STATS_SET(stats->live_bytes, 0);
+    YBUFFER_STATS_SET(stats->chunk_count, 0);
+    YBUFFER_STATS_SET(stats->wasted_bytes, 0);
+    return chain;
+}
+
+/**
+ * take over a chain detached by ybuffer_detach() in O(1).
+ * memory in chain is available in current thread until next clean up.
+ * @note
+ * adopted memory is not limited by thread budget.
+ */
+ybool_t ybuffer_adopt(ybuffer_chain_t * chain)
+{
+    if (!chain) {
+        YUKI_LOG_FATAL("invalid chain");
+        return yfalse;
+    }
+
+    if (!g_ybuffer_inited) {
+        YUKI_LOG_FATAL("ybuffer is not init-ed");
+        return yfalse;
+    }
+
+    yuki_thread_ctx_t * ctx = _ybuffer_thread_ctx_get();
+
+    if (!ctx) {
+        return yfalse;
+    }
+
+    ybuffer_chain_t * last = chain;
+
+    // a chain detached from a thread which adopted others carries them in its list
+    while (last->next) {
+        last = last->next;
+    }
+
+    last->next = ctx->arena.adopted;
+    ctx->arena.adopted = chain;
+    YBUFFER_STATS_ADD(ctx->stats.chunk_count, chain->chunk_count);
+    YBUFFER_STATS_ADD(ctx->stats.wasted_bytes, chain->wasted_bytes);
+    _ybuffer_stats_add_live(&ctx->stats, chain->live_bytes);
+    return ytrue;
+}
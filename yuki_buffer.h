@@ -7,6 +7,42 @@ extern "C" {
 
 #define _YBUFFER_ALLOC_ALIGN 8
 
+/**
+ * thread arena chunk grows from min size to max size geometrically.
+ * buffer larger than a quarter of next chunk gets a dedicated block.
+ */
+#define YBUFFER_CHUNK_MIN_SIZE ((ysize_t)64 * 1024)
+#define YBUFFER_CHUNK_MAX_SIZE ((ysize_t)4 * 1024 * 1024)
+
+/**
+ * default chunk bytes kept by each thread across clean up.
+ */
+#define YBUFFER_RETAIN_BYTES ((ysize_t)256 * 1024)
+
+/**
+ * buffer no smaller than threshold is mapped by mmap. 0 disables it.
+ * mapping larger than huge page size is aligned to use transparent huge page.
+ */
+#define YBUFFER_MMAP_THRESHOLD ((ysize_t)2 * 1024 * 1024)
+#define YBUFFER_HUGE_PAGE_SIZE ((ysize_t)2 * 1024 * 1024)
+
+/**
+ * budget meaning no limit. see ybuffer_set_thread_budget().
+ */
+#define YBUFFER_BUDGET_UNLIMITED ((ysize_t)-1)
+
+/**
+ * number of global buffer shards. a power of 2 no less than worker count works best.
+ */
+#define YBUFFER_GLOBAL_SHARD_COUNT 64
+
+/**
+ * objects moved between pool and thread magazine at a time,
+ * and objects allocated in one pool slab.
+ */
+#define YBUFFER_POOL_MAGAZINE_SIZE 32
+#define YBUFFER_POOL_SLAB_OBJECTS 64
+
 #define YBUFFER_COOKIE_PADDING ((yuint64_t)0xF3C18304DC21A5B7ULL)
 
 #define ybuffer_smart_alloc(b, t) (t*)ybuffer_alloc((b), sizeof(t))
@@ -14,11 +50,28 @@ extern "C" {
 
 ybuffer_t * ybuffer_create(ysize_t size);
 ybuffer_t * ybuffer_create_global(ysize_t size);
+ybuffer_t * ybuffer_site_create(ysize_t size, ybuffer_site_t site);
+ybuffer_t * ybuffer_site_create_global(ysize_t size, ybuffer_site_t site);
 void * ybuffer_alloc(ybuffer_t * buffer, ysize_t size);
 void * ybuffer_simple_alloc(ysize_t size);
+void * ybuffer_site_simple_alloc(ysize_t size, ybuffer_site_t site);
 ysize_t ybuffer_available_size(const ybuffer_t * buffer);
+ybuffer_mark_t ybuffer_mark();
+ybool_t ybuffer_rewind(ybuffer_mark_t mark);
+ybuffer_chain_t * ybuffer_detach();
+ybool_t ybuffer_adopt(ybuffer_chain_t * chain);
 ybool_t ybuffer_destroy_global(ybuffer_t * buffer);
 ybool_t ybuffer_destroy_global_pointer(void * pointer);
+ybool_t ybuffer_stats(ybuffer_stats_t * thread_stats, ybuffer_stats_t * global_stats);
+void ybuffer_set_thread_budget(ysize_t budget);
+void ybuffer_set_budget_callback(ybuffer_budget_func callback, void * data);
+ybool_t ybuffer_over_budget();
+yuint64_t ybuffer_refused_count();
+
+ybool_t ybuffer_pool_init(ybuffer_pool_t * pool, ysize_t object_size);
+void ybuffer_pool_destroy(ybuffer_pool_t * pool);
+void * ybuffer_pool_alloc(ybuffer_pool_t * pool);
+void ybuffer_pool_free(ybuffer_pool_t * pool, void * object);
 
 #ifdef __cplusplus
 }
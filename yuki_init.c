@@ -1,13 +1,17 @@
 #include "libconfig.h"
 #include "yuki.h"
 
+YUKI_COMPONENT_DECLARE(ythread)
 YUKI_COMPONENT_DECLARE(ylog)
 YUKI_COMPONENT_DECLARE(ybuffer)
+YUKI_COMPONENT_DECLARE(yvar)
 YUKI_COMPONENT_DECLARE(ytable)
 
 YUKI_COMPONENT_BEGIN()
+    YUKI_COMPONENT_REGISTER(ythread)
     YUKI_COMPONENT_REGISTER(ylog)
     YUKI_COMPONENT_REGISTER(ybuffer)
+    YUKI_COMPONENT_REGISTER(yvar)
     YUKI_COMPONENT_REGISTER(ytable)
 YUKI_COMPONENT_END()
 
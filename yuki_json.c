@@ -0,0 +1,1142 @@
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "yuki.h"
+
+#define YJSON_WRITER_MIN_CAPACITY 256
+#define YJSON_STACK_MIN_CAPACITY 64
+
+// chars are classified 64 at a time by indexer
+#define YJSON_BLOCK_SIZE 64
+
+typedef struct _yjson_writer_t {
+    char * buffer;
+    ysize_t size;
+    ysize_t capacity;
+} yjson_writer_t;
+
+/**
+ * bit masks of a 64-byte block. bit i is set if char i is of the class.
+ */
+typedef struct _yjson_block_t {
+    yuint64_t quote;
+    yuint64_t backslash;
+    yuint64_t structural; /**< one of {}[]:, */
+    yuint64_t whitespace;
+} yjson_block_t;
+
+typedef enum _yjson_state_t {
+    YJSON_STATE_VALUE,
+    YJSON_STATE_KEY,
+    YJSON_STATE_NEXT, /**< after a value, expect ',' or end of container */
+} yjson_state_t;
+
+typedef struct _yjson_frame_t {
+    ysize_t start; /**< first value of container in stack */
+    char close;
+} yjson_frame_t;
+
+typedef struct _yjson_parser_t {
+    const char * json;
+    ysize_t size;
+    yuint32_t * indexes; /**< offsets of structural chars and starts of strings and scalars */
+    ysize_t count;
+    ysize_t next;
+    yvar_t * stack; /**< parsed values not yet put in a container */
+    ysize_t stack_size;
+    ysize_t stack_capacity;
+} yjson_parser_t;
+
+static inline ybool_t _yjson_need_escape(char c)
+{
+    return '"' == c || '\\' == c || (unsigned char)c < 0x20;
+}
+
+#if defined(__SSE2__)
+/**
+ * find the first char which must be escaped in json string. 16 chars a step.
+ * @return end if not found.
+ */
+static inline const char * _yjson_find_escape(const char * str, const char * end)
+{
+    const __m128i quote = _mm_set1_epi8('"');
+    const __m128i backslash = _mm_set1_epi8('\\');
+    const __m128i control = _mm_set1_epi8(0x1F);
+
+    for (; end - str >= 16; str += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)str);
+        // unsigned chunk <= 0x1F
+        __m128i mask = _mm_cmpeq_epi8(_mm_min_epu8(chunk, control), chunk);
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, quote));
+        mask = _mm_or_si128(mask, _mm_cmpeq_epi8(chunk, backslash));
+        int bits = _mm_movemask_epi8(mask);
+
+        if (bits) {
+            return str + __builtin_ctz(bits);
+        }
+    }
+
+    for (; str < end; str++) {
+        if (_yjson_need_escape(*str)) {
+            return str;
+        }
+    }
+
+    return end;
+}
+
+static inline yuint64_t _yjson_movemask(const char * block, const __m128i * targets, int count)
+{
+    yuint64_t mask = 0;
+    int i, j;
+
+    for (i = 0; i < YJSON_BLOCK_SIZE; i += 16) {
+        __m128i chunk = _mm_loadu_si128((const __m128i*)(block + i));
+        __m128i matched = _mm_cmpeq_epi8(chunk, targets[0]);
+
+        for (j = 1; j < count; j++) {
+            matched = _mm_or_si128(matched, _mm_cmpeq_epi8(chunk, targets[j]));
+        }
+
+        mask |= (yuint64_t)(yuint16_t)_mm_movemask_epi8(matched) << i;
+    }
+
+    return mask;
+}
+
+static inline void _yjson_classify(const char * block, yjson_block_t * masks)
+{
+    const __m128i quote[] = {_mm_set1_epi8('"')};
+    const __m128i backslash[] = {_mm_set1_epi8('\\')};
+    const __m128i structural[] = {
+        _mm_set1_epi8('{'), _mm_set1_epi8('}'), _mm_set1_epi8('['),
+        _mm_set1_epi8(']'), _mm_set1_epi8(':'), _mm_set1_epi8(','),
+    };
+    const __m128i whitespace[] = {
+        _mm_set1_epi8(' '), _mm_set1_epi8('\t'), _mm_set1_epi8('\n'), _mm_set1_epi8('\r'),
+    };
+
+    masks->quote = _yjson_movemask(block, quote, 1);
+    masks->backslash = _yjson_movemask(block, backslash, 1);
+    masks->structural = _yjson_movemask(block, structural, 6);
+    masks->whitespace = _yjson_movemask(block, whitespace, 4);
+}
+#else
+/**
+ * find the first char which must be escaped in json string. 8 chars a step.
+ * @return end if not found.
+ */
+static inline const char * _yjson_find_escape(const char * str, const char * end)
+{
+    yuint64_t value;
+
+    // a word has a byte < n if ((value - n) & ~value & 0x80) is not 0 for all bytes
+    #define _YJSON_HAS_LESS(v, n) (((v) - 0x0101010101010101ULL * (n)) & ~(v) & 0x8080808080808080ULL)
+
+    for (; end - str >= 8; str += 8) {
+        memcpy(&value, str, sizeof(value));
+
+        if (_YJSON_HAS_LESS(value, 0x20)
+                || _YJSON_HAS_LESS(value ^ 0x2222222222222222ULL, 1)
+                || _YJSON_HAS_LESS(value ^ 0x5C5C5C5C5C5C5C5CULL, 1)) {
+            break;
+        }
+    }
+
+    #undef _YJSON_HAS_LESS
+
+    for (; str < end; str++) {
+        if (_yjson_need_escape(*str)) {
+            return str;
+        }
+    }
+
+    return end;
+}
+
+static inline void _yjson_classify(const char * block, yjson_block_t * masks)
+{
+    yuint64_t bit;
+    int i;
+
+    memset(masks, 0, sizeof(yjson_block_t));
+
+    for (i = 0; i < YJSON_BLOCK_SIZE; i++) {
+        bit = 1ULL << i;
+
+        switch (block[i]) {
+            case '"':
+                masks->quote |= bit;
+                break;
+            case '\\':
+                masks->backslash |= bit;
+                break;
+            case '{':
+            case '}':
+            case '[':
+            case ']':
+            case ':':
+            case ',':
+                masks->structural |= bit;
+                break;
+            case ' ':
+            case '\t':
+            case '\n':
+            case '\r':
+                masks->whitespace |= bit;
+                break;
+        }
+    }
+}
+#endif
+
+static ybool_t _yjson_writer_reserve(yjson_writer_t * writer, ysize_t size)
+{
+    if (writer->capacity - writer->size >= size) {
+        return ytrue;
+    }
+
+    ysize_t capacity = writer->capacity? writer->capacity * 2: YJSON_WRITER_MIN_CAPACITY;
+
+    if (capacity - writer->size < size) {
+        capacity = writer->size + size;
+    }
+
+    // old buffer is left in arena and released by yuki_clean_up()
+    char * buffer = (char*)ybuffer_site_simple_alloc(capacity, YBUFFER_SITE_JSON);
+
+    if (!buffer) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    if (writer->size) {
+        memcpy(buffer, writer->buffer, writer->size);
+    }
+
+    writer->buffer = buffer;
+    writer->capacity = capacity;
+    return ytrue;
+}
+
+static inline ybool_t _yjson_write_raw(yjson_writer_t * writer, const char * str, ysize_t size)
+{
+    if (!_yjson_writer_reserve(writer, size)) {
+        return yfalse;
+    }
+
+    memcpy(writer->buffer + writer->size, str, size);
+    writer->size += size;
+    return ytrue;
+}
+
+static ybool_t _yjson_write_string(yjson_writer_t * writer, const char * str, ysize_t size)
+{
+    static const char hex[] = "0123456789abcdef";
+    const char * end = str + size;
+
+    // enough for string without escaped char
+    if (!_yjson_writer_reserve(writer, size + 2)) {
+        return yfalse;
+    }
+
+    writer->buffer[writer->size++] = '"';
+
+    while (str < end) {
+        const char * next = _yjson_find_escape(str, end);
+        memcpy(writer->buffer + writer->size, str, next - str);
+        writer->size += next - str;
+
+        if (next == end) {
+            break;
+        }
+
+        // an escaped char takes at most 6 chars
+        if (!_yjson_writer_reserve(writer, 6 + (end - next - 1) + 1)) {
+            return yfalse;
+        }
+
+        char * output = writer->buffer + writer->size;
+        output[0] = '\\';
+
+        switch (*next) {
+            case '"':
+            case '\\':
+                output[1] = *next;
+                writer->size += 2;
+                break;
+            case '\b':
+                output[1] = 'b';
+                writer->size += 2;
+                break;
+            case '\f':
+                output[1] = 'f';
+                writer->size += 2;
+                break;
+            case '\n':
+                output[1] = 'n';
+                writer->size += 2;
+                break;
+            case '\r':
+                output[1] = 'r';
+                writer->size += 2;
+                break;
+            case '\t':
+                output[1] = 't';
+                writer->size += 2;
+                break;
+            default:
+                output[1] = 'u';
+                output[2] = '0';
+                output[3] = '0';
+                output[4] = hex[(unsigned char)*next >> 4];
+                output[5] = hex[(unsigned char)*next & 0xF];
+                writer->size += 6;
+                break;
+        }
+
+        str = next + 1;
+    }
+
+    writer->buffer[writer->size++] = '"';
+    return ytrue;
+}
+
+static ybool_t _yjson_write_int(yjson_writer_t * writer, const yvar_t * yvar, ybool_t quoted)
+{
+    if (!_yjson_writer_reserve(writer, YSTRING_INT_MAX_LENGTH + 3)) {
+        return yfalse;
+    }
+
+    if (quoted) {
+        writer->buffer[writer->size++] = '"';
+    }
+
+    char * output = writer->buffer + writer->size;
+
+    if (YVAR_TYPE_UINT64 == yvar->type) {
+        writer->size += ystring_from_uint64(yvar->data.yuint64_data, output);
+    } else {
+        yint64_t value = 0;
+        yvar_get_int64(*yvar, value);
+        writer->size += ystring_from_int64(value, output);
+    }
+
+    if (quoted) {
+        writer->buffer[writer->size++] = '"';
+    }
+
+    return ytrue;
+}
+
+static ybool_t _yjson_write(yjson_writer_t * writer, const yvar_t * yvar, ysize_t depth);
+
+/**
+ * object key must be a string. int key is written as a string.
+ */
+static ybool_t _yjson_write_key(yjson_writer_t * writer, const yvar_t * key)
+{
+    switch (key->type) {
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+            return _yjson_write_string(writer, yvar_cstr_buffer(*key), yvar_cstr_strlen(*key));
+        case YVAR_TYPE_INT8:
+        case YVAR_TYPE_UINT8:
+        case YVAR_TYPE_INT16:
+        case YVAR_TYPE_UINT16:
+        case YVAR_TYPE_INT32:
+        case YVAR_TYPE_UINT32:
+        case YVAR_TYPE_INT64:
+        case YVAR_TYPE_UINT64:
+            return _yjson_write_int(writer, key, ytrue);
+        default:
+            YUKI_LOG_WARNING("map key of type %d cannot be written in json", key->type);
+            return yfalse;
+    }
+}
+
+static ybool_t _yjson_write(yjson_writer_t * writer, const yvar_t * yvar, ysize_t depth)
+{
+    // same limit as decoder, so that every encoded json can be decoded
+    if (depth >= YJSON_MAX_DEPTH && (YVAR_TYPE_ARRAY == yvar->type || YVAR_TYPE_LIST == yvar->type
+            || YVAR_TYPE_MAP == yvar->type || YVAR_TYPE_PACKED == yvar->type)) {
+        YUKI_LOG_WARNING("var is nested too deep");
+        return yfalse;
+    }
+
+    switch (yvar->type) {
+        case YVAR_TYPE_UNDEFINED:
+            return _yjson_write_raw(writer, "null", 4);
+        case YVAR_TYPE_BOOL:
+            return yvar->data.ybool_data? _yjson_write_raw(writer, "true", 4): _yjson_write_raw(writer, "false", 5);
+        case YVAR_TYPE_INT8:
+        case YVAR_TYPE_UINT8:
+        case YVAR_TYPE_INT16:
+        case YVAR_TYPE_UINT16:
+        case YVAR_TYPE_INT32:
+        case YVAR_TYPE_UINT32:
+        case YVAR_TYPE_INT64:
+        case YVAR_TYPE_UINT64:
+            return _yjson_write_int(writer, yvar, yfalse);
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+            return _yjson_write_string(writer, yvar_cstr_buffer(*yvar), yvar_cstr_strlen(*yvar));
+        case YVAR_TYPE_ARRAY:
+        {
+            ysize_t size = yvar->data.yarray_data.size;
+            ysize_t i;
+
+            if (!_yjson_write_raw(writer, "[", 1)) {
+                return yfalse;
+            }
+
+            for (i = 0; i < size; i++) {
+                if ((i && !_yjson_write_raw(writer, ",", 1))
+                        || !_yjson_write(writer, yvar->data.yarray_data.yvars + i, depth + 1)) {
+                    return yfalse;
+                }
+            }
+
+            return _yjson_write_raw(writer, "]", 1);
+        }
+        case YVAR_TYPE_LIST:
+        {
+            ybool_t first = ytrue;
+
+            if (!_yjson_write_raw(writer, "[", 1)) {
+                return yfalse;
+            }
+
+            FOREACH_YVAR_LIST(*yvar, value) {
+                if ((!first && !_yjson_write_raw(writer, ",", 1)) || !_yjson_write(writer, value, depth + 1)) {
+                    return yfalse;
+                }
+
+                first = yfalse;
+            }
+
+            return _yjson_write_raw(writer, "]", 1);
+        }
+        case YVAR_TYPE_PACKED:
+        {
+            yvar_t value = YVAR_EMPTY();
+            ysize_t i;
+
+            if (!_yjson_write_raw(writer, "[", 1)) {
+                return yfalse;
+            }
+
+            for (i = 0; i < yvar->data.ypacked_data.size; i++) {
+                if ((i && !_yjson_write_raw(writer, ",", 1))
+                        || !yvar_packed_get(*yvar, i, value) || !_yjson_write(writer, &value, depth + 1)) {
+                    return yfalse;
+                }
+            }
+
+            return _yjson_write_raw(writer, "]", 1);
+        }
+        case YVAR_TYPE_MAP:
+        {
+            const yvar_t * keys = yvar->data.ymap_data.keys;
+            const yvar_t * values = yvar->data.ymap_data.values;
+            ysize_t i;
+
+            if (!yvar_is_array(*keys) || !yvar_is_array(*values)
+                    || keys->data.yarray_data.size != values->data.yarray_data.size) {
+                YUKI_LOG_WARNING("map keys and values must be arrays of the same size");
+                return yfalse;
+            }
+
+            if (!_yjson_write_raw(writer, "{", 1)) {
+                return yfalse;
+            }
+
+            for (i = 0; i < keys->data.yarray_data.size; i++) {
+                if ((i && !_yjson_write_raw(writer, ",", 1))
+                        || !_yjson_write_key(writer, keys->data.yarray_data.yvars + i)
+                        || !_yjson_write_raw(writer, ":", 1)
+                        || !_yjson_write(writer, values->data.yarray_data.yvars + i, depth + 1)) {
+                    return yfalse;
+                }
+            }
+
+            return _yjson_write_raw(writer, "}", 1);
+        }
+        default:
+            YUKI_LOG_FATAL("impossible type value %d", yvar->type);
+            return yfalse;
+    }
+}
+
+/**
+ * encode a var in json. output is allocated in thread arena and terminated by '\0'.
+ * map key must be a string or an int.
+ * @code
+ * ycstr_t json;
+ *
+ * if (yvar_to_json(result, json)) {
+ *     send(fd, json.str, json.size, 0);
+ * }
+ * @endcode
+ */
+ybool_t _yvar_to_json(const yvar_t * yvar, ycstr_t * json)
+{
+    if (!yvar || !json) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    ybuffer_mark_t mark = ybuffer_mark();
+    yjson_writer_t writer = {NULL, 0, 0};
+
+    if (!_yjson_write(&writer, yvar, 0) || !_yjson_writer_reserve(&writer, 1)) {
+        YUKI_LOG_WARNING("cannot encode var in json");
+        ybuffer_rewind(mark);
+        return yfalse;
+    }
+
+    writer.buffer[writer.size] = '\0';
+    json->size = writer.size;
+    json->str = writer.buffer;
+    return ytrue;
+}
+
+/**
+ * xor of all bits at or below each bit. bits between an opening quote and a closing quote are set.
+ */
+static inline yuint64_t _yjson_prefix_xor(yuint64_t bits)
+{
+    bits ^= bits << 1;
+    bits ^= bits << 2;
+    bits ^= bits << 4;
+    bits ^= bits << 8;
+    bits ^= bits << 16;
+    bits ^= bits << 32;
+    return bits;
+}
+
+/**
+ * find structural chars, opening quotes of strings and starts of other values.
+ * chars inside strings are skipped. it's the first stage of parsing.
+ */
+static ybool_t _yjson_index(yjson_parser_t * parser)
+{
+    const char * json = parser->json;
+    ysize_t size = parser->size;
+    yuint64_t prev_in_string = 0;
+    yuint64_t prev_escaped = 0;
+    yuint64_t prev_scalar = 0;
+    char padded[YJSON_BLOCK_SIZE];
+    yjson_block_t masks;
+    ysize_t offset;
+
+    for (offset = 0; offset < size; offset += YJSON_BLOCK_SIZE) {
+        const char * block = json + offset;
+
+        // last block is padded with spaces
+        if (size - offset < YJSON_BLOCK_SIZE) {
+            memset(padded, ' ', YJSON_BLOCK_SIZE);
+            memcpy(padded, block, size - offset);
+            block = padded;
+        }
+
+        _yjson_classify(block, &masks);
+
+        // a char is escaped if it follows a backslash which is not escaped.
+        // backslash is rare, so it's fine to check them one by one.
+        yuint64_t escaped = prev_escaped;
+        yuint64_t backslash = masks.backslash;
+        prev_escaped = 0;
+
+        while (backslash) {
+            yuint64_t bit = backslash & (0 - backslash);
+            backslash ^= bit;
+
+            if (escaped & bit) {
+                continue;
+            }
+
+            if (bit >> 63) {
+                prev_escaped = 1;
+            } else {
+                escaped |= bit << 1;
+            }
+        }
+
+        yuint64_t quote = masks.quote & ~escaped;
+        yuint64_t in_string = _yjson_prefix_xor(quote) ^ prev_in_string;
+        prev_in_string = (yuint64_t)((yint64_t)in_string >> 63);
+
+        yuint64_t scalar = ~(masks.structural | masks.whitespace | quote | in_string);
+        yuint64_t scalar_start = scalar & ~((scalar << 1) | prev_scalar);
+        prev_scalar = scalar >> 63;
+
+        yuint64_t bits = (masks.structural & ~in_string) | (quote & in_string) | scalar_start;
+
+        while (bits) {
+            parser->indexes[parser->count++] = (yuint32_t)(offset + __builtin_ctzll(bits));
+            bits &= bits - 1;
+        }
+    }
+
+    if (prev_in_string) {
+        YUKI_LOG_WARNING("string is not terminated");
+        return yfalse;
+    }
+
+    return ytrue;
+}
+
+static ybool_t _yjson_push(yjson_parser_t * parser, const yvar_t * value)
+{
+    if (parser->stack_size == parser->stack_capacity) {
+        ysize_t capacity = parser->stack_capacity? parser->stack_capacity * 2: YJSON_STACK_MIN_CAPACITY;
+
+        // old stack is left in arena and released by yuki_clean_up()
+        yvar_t * stack = (yvar_t*)ybuffer_site_simple_alloc(capacity * sizeof(yvar_t), YBUFFER_SITE_JSON);
+
+        if (!stack) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+
+        if (parser->stack_size) {
+            memcpy(stack, parser->stack, parser->stack_size * sizeof(yvar_t));
+        }
+
+        parser->stack = stack;
+        parser->stack_capacity = capacity;
+    }
+
+    parser->stack[parser->stack_size++] = *value;
+    return ytrue;
+}
+
+static inline ybool_t _yjson_is_whitespace(char c)
+{
+    return ' ' == c || '\t' == c || '\n' == c || '\r' == c;
+}
+
+static inline int _yjson_hex(char c)
+{
+    if (c >= '0' && c <= '9') {
+        return c - '0';
+    }
+
+    if (c >= 'a' && c <= 'f') {
+        return c - 'a' + 10;
+    }
+
+    if (c >= 'A' && c <= 'F') {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+}
+
+static ybool_t _yjson_parse_hex4(const char * str, const char * end, yuint32_t * output)
+{
+    yuint32_t value = 0;
+    int i;
+
+    if (end - str < 4) {
+        return yfalse;
+    }
+
+    for (i = 0; i < 4; i++) {
+        int digit = _yjson_hex(str[i]);
+
+        if (digit < 0) {
+            return yfalse;
+        }
+
+        value = (value << 4) | digit;
+    }
+
+    *output = value;
+    return ytrue;
+}
+
+/**
+ * decode escaped string in [str, end). end is the closing quote.
+ * output must have (end - str + 1) bytes. escaped string is never longer than raw one.
+ * @return size of decoded string.
+ */
+static ybool_t _yjson_unescape(const char * str, const char * end, char * output, ysize_t * size)
+{
+    char * begin = output;
+
+    while (str < end) {
+        const char * next = _yjson_find_escape(str, end);
+        memcpy(output, str, next - str);
+        output += next - str;
+        str = next;
+
+        if (str == end) {
+            break;
+        }
+
+        if ('\\' != *str || end - str < 2) {
+            YUKI_LOG_WARNING("invalid char in string. [char: 0x%02x]", (unsigned char)*str);
+            return yfalse;
+        }
+
+        switch (str[1]) {
+            case '"':
+            case '\\':
+            case '/':
+                *output++ = str[1];
+                break;
+            case 'b':
+                *output++ = '\b';
+                break;
+            case 'f':
+                *output++ = '\f';
+                break;
+            case 'n':
+                *output++ = '\n';
+                break;
+            case 'r':
+                *output++ = '\r';
+                break;
+            case 't':
+                *output++ = '\t';
+                break;
+            case 'u':
+            {
+                yuint32_t code, low;
+
+                if (!_yjson_parse_hex4(str + 2, end, &code)) {
+                    YUKI_LOG_WARNING("invalid unicode escape");
+                    return yfalse;
+                }
+
+                str += 4;
+
+                // surrogate pair
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    if (end - str < 8 || '\\' != str[2] || 'u' != str[3]
+                            || !_yjson_parse_hex4(str + 4, end, &low) || low < 0xDC00 || low > 0xDFFF) {
+                        YUKI_LOG_WARNING("invalid surrogate pair");
+                        return yfalse;
+                    }
+
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    str += 6;
+                } else if (code >= 0xDC00 && code <= 0xDFFF) {
+                    YUKI_LOG_WARNING("invalid surrogate pair");
+                    return yfalse;
+                }
+
+                if (code < 0x80) {
+                    *output++ = (char)code;
+                } else if (code < 0x800) {
+                    *output++ = (char)(0xC0 | (code >> 6));
+                    *output++ = (char)(0x80 | (code & 0x3F));
+                } else if (code < 0x10000) {
+                    *output++ = (char)(0xE0 | (code >> 12));
+                    *output++ = (char)(0x80 | ((code >> 6) & 0x3F));
+                    *output++ = (char)(0x80 | (code & 0x3F));
+                } else {
+                    *output++ = (char)(0xF0 | (code >> 18));
+                    *output++ = (char)(0x80 | ((code >> 12) & 0x3F));
+                    *output++ = (char)(0x80 | ((code >> 6) & 0x3F));
+                    *output++ = (char)(0x80 | (code & 0x3F));
+                }
+
+                break;
+            }
+            default:
+                YUKI_LOG_WARNING("invalid escape char '%c'", str[1]);
+                return yfalse;
+        }
+
+        str += 2;
+    }
+
+    *output = '\0';
+    *size = output - begin;
+    return ytrue;
+}
+
+/**
+ * parse string starting at opening quote.
+ * string without escaped char points to json directly.
+ */
+static ybool_t _yjson_parse_string(yjson_parser_t * parser, ysize_t offset, yvar_t * output)
+{
+    const char * begin = parser->json + offset + 1;
+    const char * end = parser->json + parser->size;
+    const char * str = begin;
+    ybool_t escaped = yfalse;
+
+    for (;;) {
+        str = _yjson_find_escape(str, end);
+
+        if (str == end) {
+            YUKI_LOG_WARNING("string is not terminated");
+            return yfalse;
+        }
+
+        if ('"' == *str) {
+            break;
+        }
+
+        if ('\\' != *str || end - str < 2) {
+            YUKI_LOG_WARNING("invalid char in string. [char: 0x%02x]", (unsigned char)*str);
+            return yfalse;
+        }
+
+        escaped = ytrue;
+        str += 2;
+    }
+
+    ysize_t size = str - begin;
+
+    if (!escaped) {
+        yvar_cstr_with_size(*output, begin, size);
+        return ytrue;
+    }
+
+    char * buffer = (char*)ybuffer_site_simple_alloc(size + 1, YBUFFER_SITE_JSON);
+
+    if (!buffer) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    if (!_yjson_unescape(begin, str, buffer, &size)) {
+        return yfalse;
+    }
+
+    yvar_cstr_with_size(*output, buffer, size);
+    return ytrue;
+}
+
+/**
+ * parse int in [str, end). json number grammar is checked before converted.
+ * fraction and exponent are not supported as var has no floating point type.
+ */
+static ybool_t _yjson_parse_number(const char * str, const char * end, yvar_t * output)
+{
+    const char * digits = '-' == *str? str + 1: str;
+    const char * p = digits;
+
+    while (p < end && *p >= '0' && *p <= '9') {
+        p++;
+    }
+
+    if (p == digits || ('0' == *digits && p - digits > 1)) {
+        YUKI_LOG_WARNING("invalid number");
+        return yfalse;
+    }
+
+    if (p != end) {
+        if ('.' == *p || 'e' == *p || 'E' == *p) {
+            YUKI_LOG_WARNING("floating point number is not supported");
+        } else {
+            YUKI_LOG_WARNING("invalid number");
+        }
+
+        return yfalse;
+    }
+
+    yint64_t signed_value;
+    yuint64_t unsigned_value;
+
+    if (ystring_to_int64(str, end - str, &signed_value)) {
+        yvar_int64(*output, signed_value);
+        return ytrue;
+    }
+
+    if (str == digits && ystring_to_uint64(str, end - str, &unsigned_value)) {
+        yvar_uint64(*output, unsigned_value);
+        return ytrue;
+    }
+
+    YUKI_LOG_WARNING("number is out of range");
+    return yfalse;
+}
+
+/**
+ * parse a scalar or string starting at json[offset].
+ */
+static ybool_t _yjson_parse_scalar(yjson_parser_t * parser, ysize_t offset, yvar_t * output)
+{
+    const char * str = parser->json + offset;
+
+    if ('"' == *str) {
+        return _yjson_parse_string(parser, offset, output);
+    }
+
+    // token ends at next indexed char. trailing spaces are not part of it.
+    const char * end = parser->json + (parser->next < parser->count? parser->indexes[parser->next]: parser->size);
+
+    while (end > str && _yjson_is_whitespace(end[-1])) {
+        end--;
+    }
+
+    switch (*str) {
+        case 't':
+            if (4 == end - str && !memcmp(str, "true", 4)) {
+                yvar_bool(*output, ytrue);
+                return ytrue;
+            }
+
+            break;
+        case 'f':
+            if (5 == end - str && !memcmp(str, "false", 5)) {
+                yvar_bool(*output, yfalse);
+                return ytrue;
+            }
+
+            break;
+        case 'n':
+            if (4 == end - str && !memcmp(str, "null", 4)) {
+                yvar_undefined(*output);
+                return ytrue;
+            }
+
+            break;
+        case '-':
+        case '0':
+        case '1':
+        case '2':
+        case '3':
+        case '4':
+        case '5':
+        case '6':
+        case '7':
+        case '8':
+        case '9':
+            return _yjson_parse_number(str, end, output);
+    }
+
+    YUKI_LOG_WARNING("unexpected token at %lu", offset);
+    return yfalse;
+}
+
+/**
+ * build array or map from values on top of stack. values of map are key value pairs.
+ */
+static ybool_t _yjson_close(yjson_parser_t * parser, const yjson_frame_t * frame)
+{
+    ysize_t count = parser->stack_size - frame->start;
+    yvar_t * values = parser->stack + frame->start;
+    yvar_t container;
+    ysize_t i;
+
+    if (']' == frame->close) {
+        yvar_t * yvars = NULL;
+
+        if (count && !(yvars = (yvar_t*)ybuffer_site_simple_alloc(count * sizeof(yvar_t), YBUFFER_SITE_JSON))) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+
+        if (count) {
+            memcpy(yvars, values, count * sizeof(yvar_t));
+        }
+
+        yvar_array_with_size(container, yvars, count);
+    } else {
+        // layout is [keys][values][key vars][value vars]
+        ysize_t var_size = ybuffer_round_up(sizeof(yvar_t));
+        ysize_t pairs = count / 2;
+        char * block = (char*)ybuffer_site_simple_alloc(var_size * 2 + count * sizeof(yvar_t), YBUFFER_SITE_JSON);
+
+        if (!block) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+
+        yvar_t * keys = (yvar_t*)block;
+        yvar_t * map_values = (yvar_t*)(block + var_size);
+        yvar_t * yvars = (yvar_t*)(block + var_size * 2);
+
+        for (i = 0; i < pairs; i++) {
+            yvars[i] = values[i * 2];
+            yvars[pairs + i] = values[i * 2 + 1];
+        }
+
+        yvar_array_with_size(*keys, yvars, pairs);
+        yvar_array_with_size(*map_values, yvars + pairs, pairs);
+        yvar_map(container, *keys, *map_values);
+    }
+
+    parser->stack_size = frame->start;
+    return _yjson_push(parser, &container);
+}
+
+/**
+ * build vars from indexed tokens. it's the second stage of parsing.
+ */
+static ybool_t _yjson_parse(yjson_parser_t * parser)
+{
+    yjson_frame_t frames[YJSON_MAX_DEPTH];
+    yjson_state_t state = YJSON_STATE_VALUE;
+    ysize_t depth = 0;
+    yvar_t value;
+
+    for (;;) {
+        if (YJSON_STATE_NEXT == state && !depth) {
+            break;
+        }
+
+        if (parser->next >= parser->count) {
+            YUKI_LOG_WARNING("unexpected end of json");
+            return yfalse;
+        }
+
+        ysize_t offset = parser->indexes[parser->next++];
+        char c = parser->json[offset];
+
+        switch (state) {
+            case YJSON_STATE_VALUE:
+                if ('{' == c || '[' == c) {
+                    if (depth >= YJSON_MAX_DEPTH) {
+                        YUKI_LOG_WARNING("json is nested too deep");
+                        return yfalse;
+                    }
+
+                    frames[depth].start = parser->stack_size;
+                    frames[depth].close = '{' == c? '}': ']';
+                    depth++;
+                    state = '{' == c? YJSON_STATE_KEY: YJSON_STATE_VALUE;
+
+                    // empty container
+                    if (parser->next < parser->count && parser->json[parser->indexes[parser->next]] == frames[depth - 1].close) {
+                        parser->next++;
+                        depth--;
+
+                        if (!_yjson_close(parser, frames + depth)) {
+                            return yfalse;
+                        }
+
+                        state = YJSON_STATE_NEXT;
+                    }
+
+                    break;
+                }
+
+                if (!_yjson_parse_scalar(parser, offset, &value) || !_yjson_push(parser, &value)) {
+                    return yfalse;
+                }
+
+                state = YJSON_STATE_NEXT;
+                break;
+            case YJSON_STATE_KEY:
+                if ('"' != c) {
+                    YUKI_LOG_WARNING("object key must be a string at %lu", offset);
+                    return yfalse;
+                }
+
+                if (!_yjson_parse_string(parser, offset, &value) || !_yjson_push(parser, &value)) {
+                    return yfalse;
+                }
+
+                if (parser->next >= parser->count || ':' != parser->json[parser->indexes[parser->next]]) {
+                    YUKI_LOG_WARNING("expect ':' after object key at %lu", offset);
+                    return yfalse;
+                }
+
+                parser->next++;
+                state = YJSON_STATE_VALUE;
+                break;
+            case YJSON_STATE_NEXT:
+                if (',' == c) {
+                    state = '}' == frames[depth - 1].close? YJSON_STATE_KEY: YJSON_STATE_VALUE;
+                    break;
+                }
+
+                if (c != frames[depth - 1].close) {
+                    YUKI_LOG_WARNING("unexpected token at %lu", offset);
+                    return yfalse;
+                }
+
+                depth--;
+
+                if (!_yjson_close(parser, frames + depth)) {
+                    return yfalse;
+                }
+
+                break;
+        }
+    }
+
+    if (parser->next != parser->count) {
+        YUKI_LOG_WARNING("unexpected token after json at %u", parser->indexes[parser->next]);
+        return yfalse;
+    }
+
+    return ytrue;
+}
+
+/**
+ * decode json to vars in thread arena.
+ * json is scanned in blocks to find structure first. then vars are built from structure.
+ *
+ * strings without escaped char point to json and are not terminated by '\0'.
+ * json must outlive output. use yvar_cstr_strlen() to get string size.
+ * number is decoded as int64 or uint64 if it's too large. floating point number is not supported.
+ * object is decoded as a map. duplicated keys are kept as is.
+ * @code
+ * yvar_t * request = NULL;
+ *
+ * if (yvar_from_json(body, body_size, request)) {
+ *     ...
+ * }
+ * @endcode
+ */
+ybool_t _yvar_from_json(const char * json, ysize_t size, yvar_t ** yvar)
+{
+    if (!json || !yvar) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (size >= (yuint32_t)-1) {
+        YUKI_LOG_WARNING("json is too large. [size: %lu]", size);
+        return yfalse;
+    }
+
+    ybuffer_mark_t mark = ybuffer_mark();
+    yjson_parser_t parser;
+    ybool_t success = yfalse;
+    memset(&parser, 0, sizeof(parser));
+    parser.json = json;
+    parser.size = size;
+
+    // indexes and stack are scratch in arena. they are rewound on failure or released by yuki_clean_up().
+    parser.indexes = (yuint32_t*)ybuffer_site_simple_alloc((size + 1) * sizeof(yuint32_t), YBUFFER_SITE_JSON);
+
+    if (!parser.indexes) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    if (_yjson_index(&parser) && _yjson_parse(&parser)) {
+        yvar_t * root = (yvar_t*)ybuffer_site_simple_alloc(sizeof(yvar_t), YBUFFER_SITE_JSON);
+
+        if (root) {
+            *root = parser.stack[0];
+            yvar_set_option(*root, YVAR_OPTION_HOLD_RESOURCE);
+            *yvar = root;
+            success = ytrue;
+        } else {
+            YUKI_LOG_WARNING("out of memory");
+        }
+    }
+
+    if (!success) {
+        YUKI_LOG_WARNING("cannot decode json");
+        ybuffer_rewind(mark);
+    }
+
+    return success;
+}
@@ -0,0 +1,23 @@
+#ifndef _YUKI_JSON_H_
+#define _YUKI_JSON_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * max nesting of arrays and objects accepted by yvar_from_json().
+ */
+#define YJSON_MAX_DEPTH 512
+
+#define yvar_to_json(yvar, json) _yvar_to_json(&(yvar), &(json))
+#define yvar_from_json(json, size, yvar) _yvar_from_json((json), (size), &(yvar))
+
+ybool_t _yvar_to_json(const yvar_t * yvar, ycstr_t * json);
+ybool_t _yvar_from_json(const char * json, ysize_t size, yvar_t ** yvar);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
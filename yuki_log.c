@@ -36,7 +36,6 @@ static FILE *       g_ylog_files[YLOG_LEVEL_MAX] = {NULL};
 static char         g_ylog_real_files[YLOG_LEVEL_MAX][YLOG_MAX_PATH_LENGTH];
 ysize_t             g_ylog_max_type;
 
-static pthread_key_t g_ylog_thread_key;
 
 static inline ybool_t ylog_inited()
 {
@@ -129,13 +128,6 @@ ybool_t _ylog_init(config_t * config)
         }
     }
 
-    int error = pthread_key_create(&g_ylog_thread_key, NULL);
-
-    if (error) {
-        YUKI_LOG_FATAL("cannot create thread key for ylog. [err: %d]", error);
-        return yfalse;
-    }
-
     g_ylog_inited = ytrue;
 
     return ytrue;
@@ -163,12 +155,6 @@ void _ylog_shutdown()
         g_ylog_file = NULL;
     }
 
-    int error = pthread_key_delete(g_ylog_thread_key);
-    if (error)
-    {
-        YUKI_LOG_FATAL("cannot clean g_ylog_thread_key. [err: %d]", error);
-    }
-
     g_ylog_inited = yfalse;
 }
 
@@ -269,21 +255,24 @@ void ylog_rotate()
 }
 
 
+/**
+ * get log id of current thread.
+ * log id is kept in thread context. no pthread key is involved.
+ */
 yint32_t ylog_get_pthread_key()
 {
-    intptr_t value = (intptr_t)pthread_getspecific(g_ylog_thread_key);
+    yint32_t value = yuki_thread_ctx()->logid;
     if (value == 0)
     {
-        ylog_set_pthread_key();
-        value = (intptr_t)pthread_getspecific(g_ylog_thread_key);
+        value = ylog_set_pthread_key();
     }
     return value;
 }
 
 yint32_t ylog_set_pthread_key()
 {
-    intptr_t value=(intptr_t)rand();
-    pthread_setspecific(g_ylog_thread_key,(void*)value);
+    yint32_t value = (yint32_t)rand();
+    yuki_thread_ctx()->logid = value;
     return value;
 }
 
@@ -0,0 +1,849 @@
+#include <string.h>
+#include <assert.h>
+
+#include "yuki.h"
+
+/**
+ * layout of serialized buffer. numbers are in host byte order.
+ *
+ * [header][root][data referenced by offset...]
+ *
+ * every var is written as a 24-byte record. scalar value is stored in record itself.
+ * string, array, list and map store size and offset of their data.
+ *   - string: `size` bytes followed by '\0'.
+ *   - array and list: `size` records.
+ *   - map: `size` key records followed by `size` value records.
+ *   - packed array: `size` elements of `element_type` as they are in memory.
+ * offset is counted from start of buffer. all data is aligned to 8 bytes.
+ */
+typedef struct _yvar_record_t {
+    yuint8_t type;
+    yuint8_t flags;
+    yuint8_t element_type; /**< element type of packed array */
+    yuint8_t reserved[5];
+    yuint64_t size; /**< length of string or number of elements */
+    yuint64_t value; /**< scalar value or offset of data */
+} yvar_record_t;
+
+typedef struct _yvar_record_header_t {
+    yuint32_t magic;
+    yuint32_t version;
+    yuint64_t size; /**< size of whole buffer */
+    yvar_record_t root;
+} yvar_record_header_t;
+
+// "YVAR" in little endian. buffer written by a host of different byte order is rejected.
+#define YVAR_RECORD_MAGIC 0x52415659U
+#define YVAR_RECORD_FLAG_SORTED 0x1 /**< array or map keys are sorted */
+
+// nesting of vars loaded from buffer. buffer is not trusted.
+#define YVAR_VIEW_MAX_DEPTH 256
+
+#define _YVAR_RECORD_ROUND_UP(s) (((s) + YVAR_SERIALIZE_ALIGNMENT - 1) & ~((ysize_t)YVAR_SERIALIZE_ALIGNMENT - 1))
+
+typedef struct _yvar_record_writer_t {
+    char * base;
+    ysize_t offset;
+} yvar_record_writer_t;
+
+static ybool_t _yvar_record_data_size(const yvar_t * yvar, ysize_t * size);
+
+static ybool_t _yvar_record_elements_size(const yvar_t * yvars, ysize_t count, ysize_t * size)
+{
+    ysize_t i;
+
+    for (i = 0; i < count; i++) {
+        if (!_yvar_record_data_size(yvars + i, size)) {
+            return yfalse;
+        }
+    }
+
+    return ytrue;
+}
+
+/**
+ * count size of data referenced by a record. record itself is not counted.
+ */
+static ybool_t _yvar_record_data_size(const yvar_t * yvar, ysize_t * size)
+{
+    switch (yvar->type) {
+        case YVAR_TYPE_UNDEFINED:
+        case YVAR_TYPE_BOOL:
+        case YVAR_TYPE_INT8:
+        case YVAR_TYPE_UINT8:
+        case YVAR_TYPE_INT16:
+        case YVAR_TYPE_UINT16:
+        case YVAR_TYPE_INT32:
+        case YVAR_TYPE_UINT32:
+        case YVAR_TYPE_INT64:
+        case YVAR_TYPE_UINT64:
+            return ytrue;
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+            *size += _YVAR_RECORD_ROUND_UP(yvar_cstr_strlen(*yvar) + 1);
+            return ytrue;
+        case YVAR_TYPE_PACKED:
+            *size += _YVAR_RECORD_ROUND_UP(yvar->data.ypacked_data.size * _yvar_packed_element_size(yvar_packed_type(*yvar)));
+            return ytrue;
+        case YVAR_TYPE_ARRAY:
+            *size += yvar->data.yarray_data.size * sizeof(yvar_record_t);
+            return _yvar_record_elements_size(yvar->data.yarray_data.yvars, yvar->data.yarray_data.size, size);
+        case YVAR_TYPE_LIST:
+        {
+            *size += yvar_count(*yvar) * sizeof(yvar_record_t);
+
+            FOREACH_YVAR_LIST(*yvar, value) {
+                if (!_yvar_record_data_size(value, size)) {
+                    return yfalse;
+                }
+            }
+
+            return ytrue;
+        }
+        case YVAR_TYPE_MAP:
+        {
+            const yvar_t * keys = yvar->data.ymap_data.keys;
+            const yvar_t * values = yvar->data.ymap_data.values;
+
+            if (!yvar_is_array(*keys) || !yvar_is_array(*values)
+                    || keys->data.yarray_data.size != values->data.yarray_data.size) {
+                YUKI_LOG_WARNING("map keys and values must be arrays of the same size");
+                return yfalse;
+            }
+
+            *size += keys->data.yarray_data.size * sizeof(yvar_record_t) * 2;
+            return _yvar_record_elements_size(keys->data.yarray_data.yvars, keys->data.yarray_data.size, size)
+                && _yvar_record_elements_size(values->data.yarray_data.yvars, values->data.yarray_data.size, size);
+        }
+        default:
+            YUKI_LOG_FATAL("impossible type value %d", yvar->type);
+            return yfalse;
+    }
+}
+
+static yvar_record_t * _yvar_record_alloc(yvar_record_writer_t * writer, ysize_t count)
+{
+    yvar_record_t * record = (yvar_record_t*)(writer->base + writer->offset);
+    writer->offset += count * sizeof(yvar_record_t);
+    return record;
+}
+
+static void _yvar_record_write(yvar_record_writer_t * writer, yvar_record_t * record, const yvar_t * yvar);
+
+static void _yvar_record_write_elements(yvar_record_writer_t * writer, yvar_record_t * records,
+    const yvar_t * yvars, ysize_t count)
+{
+    ysize_t i;
+
+    for (i = 0; i < count; i++) {
+        _yvar_record_write(writer, records + i, yvars + i);
+    }
+}
+
+/**
+ * write a var and its data as a record. data is appended to buffer in depth-first order.
+ * size of buffer must be checked by _yvar_record_data_size() before.
+ */
+static void _yvar_record_write(yvar_record_writer_t * writer, yvar_record_t * record, const yvar_t * yvar)
+{
+    memset(record, 0, sizeof(yvar_record_t));
+    record->type = yvar->type;
+
+    switch (yvar->type) {
+        case YVAR_TYPE_BOOL:
+            record->value = yvar->data.ybool_data? 1: 0;
+            break;
+        case YVAR_TYPE_INT8:
+            record->value = (yuint64_t)(yint64_t)yvar->data.yint8_data;
+            break;
+        case YVAR_TYPE_UINT8:
+            record->value = yvar->data.yuint8_data;
+            break;
+        case YVAR_TYPE_INT16:
+            record->value = (yuint64_t)(yint64_t)yvar->data.yint16_data;
+            break;
+        case YVAR_TYPE_UINT16:
+            record->value = yvar->data.yuint16_data;
+            break;
+        case YVAR_TYPE_INT32:
+            record->value = (yuint64_t)(yint64_t)yvar->data.yint32_data;
+            break;
+        case YVAR_TYPE_UINT32:
+            record->value = yvar->data.yuint32_data;
+            break;
+        case YVAR_TYPE_INT64:
+            record->value = (yuint64_t)yvar->data.yint64_data;
+            break;
+        case YVAR_TYPE_UINT64:
+            record->value = yvar->data.yuint64_data;
+            break;
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+        {
+            ysize_t len = yvar_cstr_strlen(*yvar);
+            ysize_t size = _YVAR_RECORD_ROUND_UP(len + 1);
+            char * dest = writer->base + writer->offset;
+
+            if (len) {
+                memcpy(dest, yvar_cstr_buffer(*yvar), len);
+            }
+
+            // padding is zeroed so that same var is always serialized to same bytes
+            memset(dest + len, 0, size - len);
+            record->size = len;
+            record->value = writer->offset;
+            writer->offset += size;
+            break;
+        }
+        case YVAR_TYPE_PACKED:
+        {
+            ysize_t len = yvar->data.ypacked_data.size * _yvar_packed_element_size(yvar_packed_type(*yvar));
+            ysize_t size = _YVAR_RECORD_ROUND_UP(len);
+            char * dest = writer->base + writer->offset;
+
+            if (len) {
+                memcpy(dest, yvar->data.ypacked_data.data, len);
+            }
+
+            memset(dest + len, 0, size - len);
+            record->element_type = yvar_packed_type(*yvar);
+            record->size = yvar->data.ypacked_data.size;
+            record->value = writer->offset;
+            writer->offset += size;
+            break;
+        }
+        case YVAR_TYPE_ARRAY:
+        {
+            ysize_t count = yvar->data.yarray_data.size;
+            record->size = count;
+            record->value = writer->offset;
+
+            if (yvar->options & YVAR_OPTION_SORTED) {
+                record->flags |= YVAR_RECORD_FLAG_SORTED;
+            }
+
+            _yvar_record_write_elements(writer, _yvar_record_alloc(writer, count), yvar->data.yarray_data.yvars, count);
+            break;
+        }
+        case YVAR_TYPE_LIST:
+        {
+            ysize_t count = yvar_count(*yvar);
+            record->size = count;
+            record->value = writer->offset;
+
+            yvar_record_t * elements = _yvar_record_alloc(writer, count);
+
+            FOREACH_YVAR_LIST(*yvar, value) {
+                _yvar_record_write(writer, elements++, value);
+            }
+
+            break;
+        }
+        case YVAR_TYPE_MAP:
+        {
+            const yvar_t * keys = yvar->data.ymap_data.keys;
+            const yvar_t * values = yvar->data.ymap_data.values;
+            ysize_t count = keys->data.yarray_data.size;
+            record->size = count;
+            record->value = writer->offset;
+
+            if (keys->options & YVAR_OPTION_SORTED) {
+                record->flags |= YVAR_RECORD_FLAG_SORTED;
+            }
+
+            yvar_record_t * elements = _yvar_record_alloc(writer, count * 2);
+            _yvar_record_write_elements(writer, elements, keys->data.yarray_data.yvars, count);
+            _yvar_record_write_elements(writer, elements + count, values->data.yarray_data.yvars, count);
+            break;
+        }
+    }
+}
+
+/**
+ * get size of buffer to serialize a var.
+ * @return 0 if var cannot be serialized.
+ */
+ysize_t _yvar_serialized_size(const yvar_t * yvar)
+{
+    if (!yvar) {
+        YUKI_LOG_FATAL("invalid param");
+        return 0;
+    }
+
+    ysize_t size = sizeof(yvar_record_header_t);
+
+    if (!_yvar_record_data_size(yvar, &size)) {
+        YUKI_LOG_WARNING("var cannot be serialized");
+        return 0;
+    }
+
+    return size;
+}
+
+/**
+ * serialize a var to a self-describing buffer.
+ * buffer can be sent to other process or saved to file, then read by yvar_view_open().
+ * strings are copied. pointers are replaced by offsets in buffer.
+ * @code
+ * ysize_t size = yvar_serialized_size(yvar);
+ * void * buffer = malloc(size);
+ *
+ * if (size && yvar_serialize(yvar, buffer, size)) {
+ *     write(fd, buffer, size);
+ * }
+ * @endcode
+ */
+ybool_t _yvar_serialize(const yvar_t * yvar, void * buffer, ysize_t size)
+{
+    if (!yvar || !buffer) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if ((ysize_t)buffer % YVAR_SERIALIZE_ALIGNMENT) {
+        YUKI_LOG_FATAL("buffer must be aligned to %d bytes", YVAR_SERIALIZE_ALIGNMENT);
+        return yfalse;
+    }
+
+    ysize_t total = _yvar_serialized_size(yvar);
+
+    if (!total) {
+        return yfalse;
+    }
+
+    if (size < total) {
+        YUKI_LOG_WARNING("buffer is too small. [size: %lu] [expected: %lu]", size, total);
+        return yfalse;
+    }
+
+    yvar_record_header_t * header = (yvar_record_header_t*)buffer;
+    yvar_record_writer_t writer = {(char*)buffer, sizeof(yvar_record_header_t)};
+    header->magic = YVAR_RECORD_MAGIC;
+    header->version = YVAR_SERIALIZE_VERSION;
+    header->size = total;
+    _yvar_record_write(&writer, &header->root, yvar);
+
+    YUKI_ASSERT(writer.offset == total);
+    return ytrue;
+}
+
+/**
+ * get data of a record. buffer is not trusted, so every offset is checked.
+ * @return NULL if data is out of buffer.
+ */
+static const char * _yvar_view_data(const yvar_view_t * view, ysize_t unit, ysize_t extra)
+{
+    const yvar_record_t * record = view->record;
+    yuint64_t offset = record->value;
+
+    if (offset < sizeof(yvar_record_header_t) || offset % YVAR_SERIALIZE_ALIGNMENT
+            || offset > view->size || view->size - offset < extra
+            || record->size > (view->size - offset - extra) / unit) {
+        YUKI_LOG_WARNING("data is out of buffer. [offset: %lu] [size: %lu]", offset, record->size);
+        return NULL;
+    }
+
+    return view->base + offset;
+}
+
+static const char * _yvar_view_string(const yvar_view_t * view)
+{
+    const char * str = _yvar_view_data(view, 1, 1);
+
+    if (str && str[view->record->size]) {
+        YUKI_LOG_WARNING("string is not terminated by '\\0'");
+        return NULL;
+    }
+
+    return str;
+}
+
+static inline void _yvar_view_child(const yvar_view_t * view, const yvar_record_t * record, yvar_view_t * child)
+{
+    child->base = view->base;
+    child->size = view->size;
+    child->record = record;
+}
+
+/**
+ * open a view on serialized buffer. nothing is copied.
+ * buffer can be memory mapped from a file. it must outlive view and vars read from view.
+ * @code
+ * yvar_view_t view;
+ * void * buffer = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+ *
+ * if (yvar_view_open(view, buffer, size)) {
+ *     yvar_view_t uid;
+ *     yvar_t key = YVAR_CSTR("uid");
+ *     yvar_view_map_get(view, key, uid);
+ * }
+ * @endcode
+ */
+ybool_t _yvar_view_open(yvar_view_t * view, const void * buffer, ysize_t size)
+{
+    if (!view || !buffer) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if ((ysize_t)buffer % YVAR_SERIALIZE_ALIGNMENT) {
+        YUKI_LOG_WARNING("buffer must be aligned to %d bytes", YVAR_SERIALIZE_ALIGNMENT);
+        return yfalse;
+    }
+
+    const yvar_record_header_t * header = (const yvar_record_header_t*)buffer;
+
+    if (size < sizeof(yvar_record_header_t)) {
+        YUKI_LOG_WARNING("buffer is too small. [size: %lu]", size);
+        return yfalse;
+    }
+
+    if (YVAR_RECORD_MAGIC != header->magic) {
+        YUKI_LOG_WARNING("not a serialized var or it's serialized in different byte order");
+        return yfalse;
+    }
+
+    if (YVAR_SERIALIZE_VERSION != header->version) {
+        YUKI_LOG_WARNING("unsupported version. [version: %u]", header->version);
+        return yfalse;
+    }
+
+    if (header->size < sizeof(yvar_record_header_t) || header->size > size) {
+        YUKI_LOG_WARNING("buffer is truncated. [size: %lu] [expected: %lu]", size, header->size);
+        return yfalse;
+    }
+
+    view->base = (const char*)buffer;
+    view->size = header->size;
+    view->record = &header->root;
+    return ytrue;
+}
+
+yuint8_t _yvar_view_type(const yvar_view_t * view)
+{
+    if (!view || !view->record) {
+        YUKI_LOG_FATAL("invalid param");
+        return YVAR_TYPE_UNDEFINED;
+    }
+
+    return view->record->type;
+}
+
+/**
+ * count elements of a var in view. it's the same as yvar_count().
+ */
+ysize_t _yvar_view_count(const yvar_view_t * view)
+{
+    if (!view || !view->record) {
+        YUKI_LOG_FATAL("invalid param");
+        return 0;
+    }
+
+    switch (view->record->type) {
+        case YVAR_TYPE_UNDEFINED:
+            return 0;
+        case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_LIST:
+        case YVAR_TYPE_MAP:
+        case YVAR_TYPE_PACKED:
+            return view->record->size;
+        default:
+            return 1;
+    }
+}
+
+/**
+ * read a scalar, string or packed array var in place.
+ * string and packed array in output point to buffer. str var and packed array are readonly.
+ * use yvar_view_load() to read array, list or map as a var.
+ */
+ybool_t _yvar_view_get(const yvar_view_t * view, yvar_t * output)
+{
+    if (!view || !view->record || !output) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    const yvar_record_t * record = view->record;
+
+    switch (record->type) {
+        case YVAR_TYPE_UNDEFINED:
+            yvar_undefined(*output);
+            break;
+        case YVAR_TYPE_BOOL:
+            yvar_bool(*output, record->value? ytrue: yfalse);
+            break;
+        case YVAR_TYPE_INT8:
+            yvar_int8(*output, (yint8_t)record->value);
+            break;
+        case YVAR_TYPE_UINT8:
+            yvar_uint8(*output, (yuint8_t)record->value);
+            break;
+        case YVAR_TYPE_INT16:
+            yvar_int16(*output, (yint16_t)record->value);
+            break;
+        case YVAR_TYPE_UINT16:
+            yvar_uint16(*output, (yuint16_t)record->value);
+            break;
+        case YVAR_TYPE_INT32:
+            yvar_int32(*output, (yint32_t)record->value);
+            break;
+        case YVAR_TYPE_UINT32:
+            yvar_uint32(*output, (yuint32_t)record->value);
+            break;
+        case YVAR_TYPE_INT64:
+            yvar_int64(*output, (yint64_t)record->value);
+            break;
+        case YVAR_TYPE_UINT64:
+            yvar_uint64(*output, record->value);
+            break;
+        case YVAR_TYPE_CSTR:
+        {
+            const char * data = _yvar_view_string(view);
+
+            if (!data) {
+                return yfalse;
+            }
+
+            yvar_cstr_with_size(*output, data, record->size);
+            break;
+        }
+        case YVAR_TYPE_STR:
+        {
+            const char * data = _yvar_view_string(view);
+
+            if (!data) {
+                return yfalse;
+            }
+
+            yvar_str(*output);
+            output->data.ystr_data.size = record->size;
+            output->data.ystr_data.str = (char*)data;
+            break;
+        }
+        case YVAR_TYPE_PACKED:
+        {
+            ysize_t element_size = _yvar_packed_element_size(record->element_type);
+            const char * data;
+
+            if (!element_size || record->size > YUKI_MAX_UINT32_VALUE) {
+                YUKI_LOG_WARNING("invalid packed array. [type: %d] [size: %lu]", record->element_type, record->size);
+                return yfalse;
+            }
+
+            if (!(data = _yvar_view_data(view, element_size, 0))) {
+                return yfalse;
+            }
+
+            yvar_packed(*output, record->element_type, (void*)data, record->size);
+            output->options |= YVAR_OPTION_READONLY;
+            break;
+        }
+        case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_LIST:
+        case YVAR_TYPE_MAP:
+            YUKI_LOG_DEBUG("var is not a scalar or string");
+            return yfalse;
+        default:
+            YUKI_LOG_WARNING("invalid type value %d", record->type);
+            return yfalse;
+    }
+
+    return ytrue;
+}
+
+/**
+ * get an element of array or list in view.
+ */
+ybool_t _yvar_view_array_get(const yvar_view_t * view, ysize_t index, yvar_view_t * output)
+{
+    if (!view || !view->record || !output) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (YVAR_TYPE_ARRAY != view->record->type && YVAR_TYPE_LIST != view->record->type) {
+        YUKI_LOG_DEBUG("var is not an array or list");
+        return yfalse;
+    }
+
+    if (index >= view->record->size) {
+        YUKI_LOG_DEBUG("index is out of range. [index: %lu] [size: %lu]", index, view->record->size);
+        return yfalse;
+    }
+
+    const yvar_record_t * elements = (const yvar_record_t*)_yvar_view_data(view, sizeof(yvar_record_t), 0);
+
+    if (!elements) {
+        return yfalse;
+    }
+
+    _yvar_view_child(view, elements + index, output);
+    return ytrue;
+}
+
+/**
+ * get key and value at index of a map in view.
+ */
+ybool_t _yvar_view_map_entry(const yvar_view_t * view, ysize_t index, yvar_view_t * key, yvar_view_t * value)
+{
+    if (!view || !view->record || !key || !value) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (YVAR_TYPE_MAP != view->record->type) {
+        YUKI_LOG_DEBUG("var is not a map");
+        return yfalse;
+    }
+
+    if (index >= view->record->size) {
+        YUKI_LOG_DEBUG("index is out of range. [index: %lu] [size: %lu]", index, view->record->size);
+        return yfalse;
+    }
+
+    const yvar_record_t * elements = (const yvar_record_t*)_yvar_view_data(view, sizeof(yvar_record_t) * 2, 0);
+
+    if (!elements) {
+        return yfalse;
+    }
+
+    _yvar_view_child(view, elements + index, key);
+    _yvar_view_child(view, elements + view->record->size + index, value);
+    return ytrue;
+}
+
+/**
+ * find value by key in a map in view.
+ * keys are compared in place. if keys were sorted when serialized, binary search is used.
+ */
+ybool_t _yvar_view_map_get(const yvar_view_t * view, const yvar_t * key, yvar_view_t * value)
+{
+    if (!view || !view->record || !key || !value) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (YVAR_TYPE_MAP != view->record->type) {
+        YUKI_LOG_DEBUG("var is not a map");
+        return yfalse;
+    }
+
+    const yvar_record_t * elements = (const yvar_record_t*)_yvar_view_data(view, sizeof(yvar_record_t) * 2, 0);
+    ysize_t count = view->record->size;
+    yvar_view_t element;
+    yvar_t element_key;
+    ysize_t i;
+
+    if (!elements) {
+        return yfalse;
+    }
+
+    if (view->record->flags & YVAR_RECORD_FLAG_SORTED) {
+        ysize_t low = 0;
+        ysize_t high = count;
+
+        while (low < high) {
+            ysize_t mid = low + (high - low) / 2;
+            _yvar_view_child(view, elements + mid, &element);
+
+            // keys which cannot be read in place are compared one by one later
+            if (!_yvar_view_get(&element, &element_key)) {
+                break;
+            }
+
+            yint8_t ret = yvar_compare(element_key, *key);
+
+            if (!ret) {
+                _yvar_view_child(view, elements + count + mid, value);
+                return ytrue;
+            }
+
+            if (ret < 0) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        if (low >= high) {
+            YUKI_LOG_DEBUG("key is not found");
+            return yfalse;
+        }
+    }
+
+    for (i = 0; i < count; i++) {
+        _yvar_view_child(view, elements + i, &element);
+
+        if (_yvar_view_get(&element, &element_key) && yvar_equal(element_key, *key)) {
+            _yvar_view_child(view, elements + count + i, value);
+            return ytrue;
+        }
+    }
+
+    YUKI_LOG_DEBUG("key is not found");
+    return yfalse;
+}
+
+static ybool_t _yvar_view_load_internal(const yvar_view_t * view, yvar_t * yvar, ysize_t depth, ysize_t * budget);
+
+static ybool_t _yvar_view_load_elements(const yvar_view_t * view, const yvar_record_t * elements, ysize_t count,
+    yvar_t * yvars, ysize_t depth, ysize_t * budget)
+{
+    yvar_view_t element;
+    ysize_t i;
+
+    // a valid buffer has no more records than its size allows.
+    // it stops buffers whose offsets point to the same data again and again.
+    if (count > *budget) {
+        YUKI_LOG_WARNING("buffer has more vars than its size");
+        return yfalse;
+    }
+
+    *budget -= count;
+
+    for (i = 0; i < count; i++) {
+        _yvar_view_child(view, elements + i, &element);
+
+        if (!_yvar_view_load_internal(&element, yvars + i, depth + 1, budget)) {
+            return yfalse;
+        }
+    }
+
+    return ytrue;
+}
+
+static ybool_t _yvar_view_load_internal(const yvar_view_t * view, yvar_t * yvar, ysize_t depth, ysize_t * budget)
+{
+    const yvar_record_t * record = view->record;
+    ysize_t count = record->size;
+
+    yvar_memzero(*yvar);
+
+    if (depth > YVAR_VIEW_MAX_DEPTH) {
+        YUKI_LOG_WARNING("vars are nested too deep");
+        return yfalse;
+    }
+
+    switch (record->type) {
+        case YVAR_TYPE_ARRAY:
+        {
+            const yvar_record_t * elements = (const yvar_record_t*)_yvar_view_data(view, sizeof(yvar_record_t), 0);
+            yvar_t * yvars = NULL;
+
+            if (!elements) {
+                return yfalse;
+            }
+
+            if (count && !(yvars = (yvar_t*)ybuffer_site_simple_alloc(count * sizeof(yvar_t), YBUFFER_SITE_CLONE))) {
+                YUKI_LOG_WARNING("out of memory");
+                return yfalse;
+            }
+
+            yvar_array_with_size(*yvar, yvars, count);
+
+            if (record->flags & YVAR_RECORD_FLAG_SORTED) {
+                yvar->options |= YVAR_OPTION_SORTED;
+            }
+
+            return _yvar_view_load_elements(view, elements, count, yvars, depth, budget);
+        }
+        case YVAR_TYPE_LIST:
+        {
+            const yvar_record_t * elements = (const yvar_record_t*)_yvar_view_data(view, sizeof(yvar_record_t), 0);
+            ylist_node_t * node = NULL;
+
+            if (!elements) {
+                return yfalse;
+            }
+
+            yvar_list(*yvar);
+
+            if (!count) {
+                return ytrue;
+            }
+
+            // all vars are in one node as a cloned list
+            node = (ylist_node_t*)ybuffer_site_simple_alloc(sizeof(ylist_node_t) + count * sizeof(yvar_t), YBUFFER_SITE_CLONE);
+
+            if (!node) {
+                YUKI_LOG_WARNING("out of memory");
+                return yfalse;
+            }
+
+            node->prev = NULL;
+            node->next = NULL;
+            node->offset = 0;
+            node->size = count;
+            node->capacity = count;
+            yvar->data.ylist_data.head = node;
+            yvar->data.ylist_data.tail = node;
+            return _yvar_view_load_elements(view, elements, count, node->yvars, depth, budget);
+        }
+        case YVAR_TYPE_MAP:
+        {
+            const yvar_record_t * elements = (const yvar_record_t*)_yvar_view_data(view, sizeof(yvar_record_t) * 2, 0);
+            ysize_t var_size = ybuffer_round_up(sizeof(yvar_t));
+
+            if (!elements) {
+                return yfalse;
+            }
+
+            // layout is [keys][values][key vars][value vars]
+            char * block = (char*)ybuffer_site_simple_alloc(var_size * 2 + count * 2 * sizeof(yvar_t), YBUFFER_SITE_CLONE);
+
+            if (!block) {
+                YUKI_LOG_WARNING("out of memory");
+                return yfalse;
+            }
+
+            yvar_t * keys = (yvar_t*)block;
+            yvar_t * values = (yvar_t*)(block + var_size);
+            yvar_t * yvars = (yvar_t*)(block + var_size * 2);
+
+            yvar_array_with_size(*keys, yvars, count);
+            yvar_array_with_size(*values, yvars + count, count);
+            yvar_map(*yvar, *keys, *values);
+
+            if (record->flags & YVAR_RECORD_FLAG_SORTED) {
+                keys->options |= YVAR_OPTION_SORTED;
+            }
+
+            return _yvar_view_load_elements(view, elements, count * 2, yvars, depth, budget);
+        }
+        default:
+            return _yvar_view_get(view, yvar);
+    }
+}
+
+/**
+ * load a var in view as a var tree in thread arena.
+ * strings are not copied. they point to the buffer.
+ * use yvar_clone() if var must be independent of buffer.
+ */
+ybool_t _yvar_view_load(const yvar_view_t * view, yvar_t ** yvar)
+{
+    if (!view || !view->record || !yvar) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    ybuffer_mark_t mark = ybuffer_mark();
+    ysize_t budget = view->size / sizeof(yvar_record_t);
+    yvar_t * root = (yvar_t*)ybuffer_site_simple_alloc(sizeof(yvar_t), YBUFFER_SITE_CLONE);
+
+    if (!root) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    if (!_yvar_view_load_internal(view, root, 0, &budget)) {
+        YUKI_LOG_WARNING("cannot load var from buffer");
+        ybuffer_rewind(mark);
+        return yfalse;
+    }
+
+    yvar_set_option(*root, YVAR_OPTION_HOLD_RESOURCE);
+    *yvar = root;
+    return ytrue;
+}
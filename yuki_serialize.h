@@ -0,0 +1,46 @@
+#ifndef _YUKI_SERIALIZE_H_
+#define _YUKI_SERIALIZE_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * version of serialized buffer layout.
+ */
+#define YVAR_SERIALIZE_VERSION 1
+
+/**
+ * serialized buffer must be aligned to it. memory from malloc() or mmap() is aligned.
+ */
+#define YVAR_SERIALIZE_ALIGNMENT 8
+
+#define yvar_serialized_size(yvar) _yvar_serialized_size(&(yvar))
+#define yvar_serialize(yvar, buffer, size) _yvar_serialize(&(yvar), (buffer), (size))
+
+#define yvar_view_open(view, buffer, size) _yvar_view_open(&(view), (buffer), (size))
+#define yvar_view_type(view) _yvar_view_type(&(view))
+#define yvar_view_count(view) _yvar_view_count(&(view))
+#define yvar_view_get(view, output) _yvar_view_get(&(view), &(output))
+#define yvar_view_array_get(view, index, output) _yvar_view_array_get(&(view), (index), &(output))
+#define yvar_view_map_entry(view, index, key, value) _yvar_view_map_entry(&(view), (index), &(key), &(value))
+#define yvar_view_map_get(view, key, value) _yvar_view_map_get(&(view), &(key), &(value))
+#define yvar_view_load(view, yvar) _yvar_view_load(&(view), &(yvar))
+
+ysize_t _yvar_serialized_size(const yvar_t * yvar);
+ybool_t _yvar_serialize(const yvar_t * yvar, void * buffer, ysize_t size);
+
+ybool_t _yvar_view_open(yvar_view_t * view, const void * buffer, ysize_t size);
+yuint8_t _yvar_view_type(const yvar_view_t * view);
+ysize_t _yvar_view_count(const yvar_view_t * view);
+ybool_t _yvar_view_get(const yvar_view_t * view, yvar_t * output);
+ybool_t _yvar_view_array_get(const yvar_view_t * view, ysize_t index, yvar_view_t * output);
+ybool_t _yvar_view_map_entry(const yvar_view_t * view, ysize_t index, yvar_view_t * key, yvar_view_t * value);
+ybool_t _yvar_view_map_get(const yvar_view_t * view, const yvar_t * key, yvar_view_t * value);
+ybool_t _yvar_view_load(const yvar_view_t * view, yvar_t ** yvar);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
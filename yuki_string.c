@@ -0,0 +1,222 @@
+#include <string.h>
+#include <assert.h>
+
+#include "yuki.h"
+
+static const char g_ystring_digit_pairs[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+/**
+ * write digits of value backward from end. two digits a step.
+ */
+static inline char * _ystring_write_digits(yuint64_t value, char * end)
+{
+    const char * pair;
+
+    while (value >= 100) {
+        pair = g_ystring_digit_pairs + (value % 100) * 2;
+        value /= 100;
+        *--end = pair[1];
+        *--end = pair[0];
+    }
+
+    if (value >= 10) {
+        pair = g_ystring_digit_pairs + value * 2;
+        *--end = pair[1];
+        *--end = pair[0];
+    } else {
+        *--end = (char)('0' + value);
+    }
+
+    return end;
+}
+
+ysize_t ystring_from_uint64(yuint64_t value, char * output)
+{
+    YUKI_ASSERT(output);
+
+    char buf[YSTRING_INT_MAX_LENGTH];
+    char * end = buf + sizeof(buf);
+    char * begin = _ystring_write_digits(value, end);
+    ysize_t len = end - begin;
+
+    memcpy(output, begin, len);
+    output[len] = '\0';
+    return len;
+}
+
+ysize_t ystring_from_int64(yint64_t value, char * output)
+{
+    YUKI_ASSERT(output);
+
+    char buf[YSTRING_INT_MAX_LENGTH];
+    char * end = buf + sizeof(buf);
+    // negate in unsigned to handle min value
+    char * begin = _ystring_write_digits(value < 0? 0 - (yuint64_t)value: (yuint64_t)value, end);
+
+    if (value < 0) {
+        *--begin = '-';
+    }
+
+    ysize_t len = end - begin;
+    memcpy(output, begin, len);
+    output[len] = '\0';
+    return len;
+}
+
+#if (defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__)
+/**
+ * parse 8 digits in one go. the first char is in the lowest byte.
+ * @return yfalse if any byte is not a digit.
+ */
+static inline ybool_t _ystring_parse_8_digits(const char * str, yuint64_t * output)
+{
+    yuint64_t value;
+    memcpy(&value, str, sizeof(value));
+
+    // every byte must be in ['0', '9']
+    if ((value & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL
+            || ((value + 0x0606060606060606ULL) & 0xF0F0F0F0F0F0F0F0ULL) != 0x3030303030303030ULL) {
+        return yfalse;
+    }
+
+    value -= 0x3030303030303030ULL;
+    value = value * 10 + (value >> 8);
+    value = (((value & 0x000000FF000000FFULL) * (100 + (1000000ULL << 32)))
+        + (((value >> 16) & 0x000000FF000000FFULL) * (1 + (10000ULL << 32)))) >> 32;
+    *output = value;
+    return ytrue;
+}
+#else
+static inline ybool_t _ystring_parse_8_digits(const char * str, yuint64_t * output)
+{
+    yuint64_t value = 0;
+    ysize_t i;
+
+    for (i = 0; i < 8; i++) {
+        if (str[i] < '0' || str[i] > '9') {
+            return yfalse;
+        }
+
+        value = value * 10 + (str[i] - '0');
+    }
+
+    *output = value;
+    return ytrue;
+}
+#endif
+
+/**
+ * parse unsigned digits in str[0, size). size must not be 0.
+ */
+static ybool_t _ystring_parse_digits(const char * str, ysize_t size, yuint64_t * output)
+{
+    yuint64_t value = 0;
+    yuint64_t chunk;
+    ysize_t i;
+
+    // leading zeros don't count for overflow
+    while (size > 1 && '0' == *str) {
+        str++;
+        size--;
+    }
+
+    if (size > YSTRING_INT_MAX_LENGTH) {
+        return yfalse;
+    }
+
+    // 19 digits never overflow
+    ysize_t safe = size < YSTRING_INT_MAX_LENGTH? size: YSTRING_INT_MAX_LENGTH - 1;
+
+    for (i = 0; i + 8 <= safe; i += 8) {
+        if (!_ystring_parse_8_digits(str + i, &chunk)) {
+            return yfalse;
+        }
+
+        value = value * 100000000ULL + chunk;
+    }
+
+    for (; i < safe; i++) {
+        if (str[i] < '0' || str[i] > '9') {
+            return yfalse;
+        }
+
+        value = value * 10 + (str[i] - '0');
+    }
+
+    if (safe < size) {
+        if (str[safe] < '0' || str[safe] > '9') {
+            return yfalse;
+        }
+
+        chunk = str[safe] - '0';
+
+        if (value > (YUKI_MAX_UINT64_VALUE - chunk) / 10) {
+            return yfalse;
+        }
+
+        value = value * 10 + chunk;
+    }
+
+    *output = value;
+    return ytrue;
+}
+
+ybool_t ystring_to_uint64(const char * str, ysize_t size, yuint64_t * output)
+{
+    YUKI_ASSERT(str && output);
+
+    if (size && '+' == *str) {
+        str++;
+        size--;
+    }
+
+    if (!size) {
+        return yfalse;
+    }
+
+    return _ystring_parse_digits(str, size, output);
+}
+
+ybool_t ystring_to_int64(const char * str, ysize_t size, yint64_t * output)
+{
+    YUKI_ASSERT(str && output);
+
+    ybool_t negative = yfalse;
+    yuint64_t value;
+
+    if (size && ('+' == *str || '-' == *str)) {
+        negative = '-' == *str;
+        str++;
+        size--;
+    }
+
+    if (!size || !_ystring_parse_digits(str, size, &value)) {
+        return yfalse;
+    }
+
+    if (negative) {
+        if (value > (yuint64_t)YUKI_MAX_INT64_VALUE + 1) {
+            return yfalse;
+        }
+
+        *output = (yint64_t)(0 - value);
+    } else {
+        if (value > (yuint64_t)YUKI_MAX_INT64_VALUE) {
+            return yfalse;
+        }
+
+        *output = (yint64_t)value;
+    }
+
+    return ytrue;
+}
@@ -8,6 +8,26 @@ extern "C" {
 #define YCSTR(s) {sizeof((s)) - 1, s}
 #define YCSTR_WITH_SIZE(s, len) {(len), s}
 
+/**
+ * max length of a formatted 64-bit int, sign included. '\0' is not included.
+ */
+#define YSTRING_INT_MAX_LENGTH 20
+
+/**
+ * format int in decimal. output must have YSTRING_INT_MAX_LENGTH + 1 bytes.
+ * @return length of output without '\0'.
+ */
+ysize_t ystring_from_int64(yint64_t value, char * output);
+ysize_t ystring_from_uint64(yuint64_t value, char * output);
+
+/**
+ * parse decimal int in str[0, size).
+ * only an optional sign followed by digits is accepted.
+ * @return yfalse if str has any other char or value is out of range.
+ */
+ybool_t ystring_to_int64(const char * str, ysize_t size, yint64_t * output);
+ybool_t ystring_to_uint64(const char * str, ysize_t size, yuint64_t * output);
+
 #ifdef __cplusplus
 }
 #endif
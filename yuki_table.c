@@ -61,7 +61,8 @@ static ytable_connection_config_t *g_ytable_connection_configs = NULL;
 static ysize_t g_ytable_connection_configs_count = 0;
 
 static ybool_t g_ytable_inited = yfalse;
-static pthread_key_t g_ytable_connection_thread_key;
+static yuint32_t g_ytable_generation = 0;
+static ybuffer_pool_t g_ytable_pool;
 
 static yvar_t g_ytable_result_true = YVAR_BOOL(ytrue);
 static yvar_t g_ytable_result_false = YVAR_BOOL(yfalse);
@@ -76,6 +77,10 @@ static ybool_t _ytable_sql_update_builder(ytable_t * ytable);
 static ybool_t _ytable_sql_insert_builder(ytable_t * ytable);
 static ybool_t _ytable_sql_delete_builder(ytable_t * ytable);
 
+// IS_NUM() also matches decimal, float and year. they are not converted to int.
+#define _YTABLE_FIELD_IS_INT(t) (MYSQL_TYPE_TINY == (t) || MYSQL_TYPE_SHORT == (t) \
+    || MYSQL_TYPE_LONG == (t) || MYSQL_TYPE_INT24 == (t) || MYSQL_TYPE_LONGLONG == (t))
+
 static ybool_t _ytable_sql_select_result_parser(const ytable_t * ytable, ytable_mysql_res_t * mysql_res, yvar_t ** result);
 static ybool_t _ytable_sql_update_result_parser(const ytable_t * ytable, ytable_mysql_res_t * mysql_res, yvar_t ** result);
 static ybool_t _ytable_sql_insert_result_parser(const ytable_t * ytable, ytable_mysql_res_t * mysql_res, yvar_t ** result);
@@ -149,11 +154,25 @@ static inline ybool_t _ytable_inited()
     return g_ytable_inited;
 }
 
+static inline void _ytable_begin_call(ytable_t * ytable)
+{
+    ytable->refused_count = ybuffer_refused_count();
+}
+
 static inline void _ytable_set_last_error(ytable_t * ytable, ytable_error_t error)
 {
-    if (ytable) {
-        ytable->last_error = error;
+    if (!ytable) {
+        return;
+    }
+
+    // memory is refused by thread budget during current call rather than lost
+    if ((YTABLE_ERROR_CANNOT_CLONE_VAR == error || YTABLE_ERROR_CANNOT_BUILD_SQL == error
+            || YTABLE_ERROR_CANNOT_PARSE_RESULT == error)
+            && ybuffer_refused_count() != ytable->refused_count) {
+        error = YTABLE_ERROR_OUT_OF_BUDGET;
     }
+
+    ytable->last_error = error;
 }
 
 static inline ybool_t _ytable_sql_is_valid_verb(ytable_verb_t verb)
@@ -523,7 +542,7 @@ static ysize_t _ytable_get_hash_key(const yvar_t * key)
     return hash_key;
 }
 
-static ybool_t _ytable_fecth_hash_key(const ytable_t * ytable, yvar_t ** hash_key)
+static ybool_t _ytable_fecth_hash_key(const ytable_t * ytable, yvar_t * hash_key)
 {
     YUKI_ASSERT(ytable && hash_key);
 
@@ -575,7 +594,8 @@ static ybool_t _ytable_fecth_hash_key(const ytable_t * ytable, yvar_t ** hash_ke
                     return yfalse;
                 }
 
-                yvar_clone(*hash_key, the_value);
+                // value lives in conditions/fields. no need to clone it.
+                *hash_key = the_value;
                 return ytrue;
             }
         }
@@ -586,9 +606,9 @@ static ybool_t _ytable_fecth_hash_key(const ytable_t * ytable, yvar_t ** hash_ke
 
 static void _ytable_set_hash_key(ytable_t * ytable)
 {
-    yvar_t * hash_key;
+    yvar_t hash_key = YVAR_EMPTY();
     if (_ytable_fecth_hash_key(ytable, &hash_key)) {
-        ytable->hash_value = _ytable_get_hash_key(hash_key);
+        ytable->hash_value = _ytable_get_hash_key(&hash_key);
     }
     YUKI_LOG_DEBUG("table hash value = '%ld'",ytable->hash_value);
     return;
@@ -674,7 +694,7 @@ static ybool_t _ytable_sql_select_builder(ytable_t * ytable)
         return yfalse;
     }
 
-    char * buffer = ybuffer_simple_alloc(size);
+    char * buffer = ybuffer_site_simple_alloc(size, YBUFFER_SITE_SQL);
 
     if (!buffer) {
         YUKI_LOG_WARNING("out of memory");
@@ -766,7 +786,7 @@ static ybool_t _ytable_sql_update_builder(ytable_t * ytable)
         return yfalse;
     }
 
-    char * buffer = ybuffer_simple_alloc(size);
+    char * buffer = ybuffer_site_simple_alloc(size, YBUFFER_SITE_SQL);
 
     if (!buffer) {
         YUKI_LOG_WARNING("out of memory");
@@ -889,7 +909,7 @@ static ybool_t _ytable_sql_insert_builder(ytable_t * ytable)
     // a rough but quick estimate on max value buffer.
     ysize_t value_size = size - old_size;
 
-    char * buffer = ybuffer_simple_alloc(size);
+    char * buffer = ybuffer_site_simple_alloc(size, YBUFFER_SITE_SQL);
 
     if (!buffer) {
         YUKI_LOG_WARNING("out of memory");
@@ -969,7 +989,7 @@ static ybool_t _ytable_sql_delete_builder(ytable_t * ytable)
         return yfalse;
     }
 
-    char * buffer = ybuffer_simple_alloc(size);
+    char * buffer = ybuffer_site_simple_alloc(size, YBUFFER_SITE_SQL);
 
     if (!buffer) {
         YUKI_LOG_WARNING("out of memory");
@@ -997,6 +1017,78 @@ static ybool_t _ytable_sql_delete_builder(ytable_t * ytable)
     return ytrue;
 }
 
+/**
+ * convert a field in mysql row to var. string is not copied.
+ */
+static ybool_t _ytable_sql_field_to_var(const char * data, ysize_t size,
+    enum enum_field_types type, ybool_t is_unsigned, yvar_t * value)
+{
+    yint64_t temp_signed = 0;
+    yuint64_t temp_unsigned = 0;
+
+    if (_YTABLE_FIELD_IS_INT(type)) {
+        if (is_unsigned? !ystring_to_uint64(data, size, &temp_unsigned):
+                !ystring_to_int64(data, size, &temp_signed)) {
+            YUKI_LOG_WARNING("cannot convert numeric field to int. [value: %s]", data);
+            return yfalse;
+        }
+    }
+
+    switch (type) {
+        case MYSQL_TYPE_TINY:
+            if (is_unsigned) {
+                yvar_uint8(*value, temp_unsigned);
+            } else {
+                yvar_int8(*value, temp_signed);
+            }
+
+            break;
+        case MYSQL_TYPE_SHORT:
+            if (is_unsigned) {
+                yvar_uint16(*value, temp_unsigned);
+            } else {
+                yvar_int16(*value, temp_signed);
+            }
+
+            break;
+        case MYSQL_TYPE_LONG:
+        case MYSQL_TYPE_INT24:
+            if (is_unsigned) {
+                yvar_uint32(*value, temp_unsigned);
+            } else {
+                yvar_int32(*value, temp_signed);
+            }
+
+            break;
+        case MYSQL_TYPE_LONGLONG:
+            if (is_unsigned) {
+                yvar_uint64(*value, temp_unsigned);
+            } else {
+                yvar_int64(*value, temp_signed);
+            }
+
+            break;
+        case MYSQL_TYPE_STRING:
+        case MYSQL_TYPE_VAR_STRING:
+        case MYSQL_TYPE_BLOB:
+        // TODO: make special var type for timestamp and datetime
+        case MYSQL_TYPE_TIMESTAMP:
+        case MYSQL_TYPE_DATETIME:
+            yvar_cstr_with_size(*value, data, size);
+            break;
+        case MYSQL_TYPE_NULL:
+            YUKI_LOG_DEBUG("NULL type value");
+            yvar_undefined(*value);
+
+            break;
+        default:
+            YUKI_LOG_WARNING("unsupported type. [type: %lu]", type);
+            yvar_undefined(*value);
+    }
+
+    return ytrue;
+}
+
 static ybool_t _ytable_sql_select_result_parser(const ytable_t * ytable, ytable_mysql_res_t * mysql_res, yvar_t ** result)
 {
     // TODO: finish it
@@ -1017,124 +1109,68 @@ static ybool_t _ytable_sql_select_result_parser(const ytable_t * ytable, ytable_
         return yfalse;
     }
 
-    yvar_t local_result[ytable->affected_rows * field_cnt];
     enum enum_field_types field_types[field_cnt];
     yuint64_t field_flags[field_cnt];
     yvar_t field_raw_key[field_cnt];
     MYSQL_ROW row;
     MYSQL_FIELD * field = NULL;
     uint64_t * lengths = NULL;
-    ysize_t affected_rows = ytable->affected_rows;
     ysize_t cnt;
     ysize_t i;
 
-    yint64_t temp_signed = 0;
-    yuint64_t temp_unsigned = 0;
-    ybool_t is_unsigned = yfalse;
-
     for (cnt = 0; (field = mysql_fetch_field(res)) != NULL; cnt++) {
         YUKI_ASSERT(cnt < field_cnt);
 
         field_types[cnt] = field->type;
         field_flags[cnt] = field->flags;
-        yvar_cstr_with_size(field_raw_key[cnt], field->name, field->name_length);
+
+        // field names repeat in every row and every query. share one copy of them.
+        if (!yvar_intern_with_size(field_raw_key[cnt], field->name, field->name_length)) {
+            YUKI_LOG_WARNING("cannot intern field name. [name: %s]", field->name);
+            return yfalse;
+        }
     }
 
     yvar_t field_keys = YVAR_ARRAY_WITH_SIZE(field_raw_key, field_cnt);
 
-    for (cnt = 0; (row = mysql_fetch_row(res)) != NULL; cnt++) {
+    // all values are stored row by row in one array growing in arena.
+    // affected rows is only a hint of its size.
+    yvar_t values = YVAR_EMPTY();
+    yvar_t value = YVAR_EMPTY();
+    yvar_array_with_size(values, NULL, 0);
+
+    if (!yvar_array_reserve(values, ytable->affected_rows * field_cnt)) {
+        YUKI_LOG_WARNING("cannot reserve result values");
+        return yfalse;
+    }
+
+    while ((row = mysql_fetch_row(res)) != NULL) {
         YUKI_ASSERT(field_cnt == mysql_num_fields(res));
-        YUKI_ASSERT(cnt < affected_rows);
         lengths = mysql_fetch_lengths(res);
 
         for (i = 0; i < field_cnt; i++) {
             if (NULL == row[i]) {
                 YUKI_LOG_DEBUG("got a NULL value");
-                yvar_undefined(local_result[cnt * field_cnt + i]);
-                continue;
-            }
-
-            is_unsigned = field_flags[i] & UNSIGNED_FLAG;
-
-            if (IS_NUM(field_types[i])) {
-                errno = 0;
-
-                if (is_unsigned) {
-                    temp_unsigned = strtoull(row[i], NULL, 10);
-                } else {
-                    temp_signed = strtoll(row[i], NULL, 10);
-                }
-
-                if (errno) {
-                    YUKI_LOG_WARNING("cannot convert numeric field to int. [errno: %d]", errno);
-                    return yfalse;
-                }
+                yvar_undefined(value);
+            } else if (!_ytable_sql_field_to_var(row[i], lengths[i], field_types[i],
+                    field_flags[i] & UNSIGNED_FLAG, &value)) {
+                return yfalse;
             }
 
-            switch (field_types[i]) {
-                case MYSQL_TYPE_TINY:
-                    if (is_unsigned) {
-                        yvar_uint8(local_result[cnt * field_cnt + i], temp_unsigned);
-                    } else {
-                        yvar_int8(local_result[cnt * field_cnt + i], temp_signed);
-                    }
-
-                    break;
-                case MYSQL_TYPE_SHORT:
-                    if (is_unsigned) {
-                        yvar_uint16(local_result[cnt * field_cnt + i], temp_unsigned);
-                    } else {
-                        yvar_int16(local_result[cnt * field_cnt + i], temp_signed);
-                    }
-
-                    break;
-                case MYSQL_TYPE_LONG:
-                case MYSQL_TYPE_INT24:
-                    if (is_unsigned) {
-                        yvar_uint32(local_result[cnt * field_cnt + i], temp_unsigned);
-                    } else {
-                        yvar_int32(local_result[cnt * field_cnt + i],temp_signed);
-                    }
-
-                    break;
-                case MYSQL_TYPE_LONGLONG:
-                    if (is_unsigned) {
-                        yvar_uint64(local_result[cnt * field_cnt + i], temp_unsigned);
-                    } else {
-                        yvar_int64(local_result[cnt * field_cnt + i], temp_signed);
-                    }
-
-                    break;
-                case MYSQL_TYPE_STRING:
-                case MYSQL_TYPE_VAR_STRING:
-                case MYSQL_TYPE_BLOB:
-                // TODO: make special var type for timestamp and datetime
-                case MYSQL_TYPE_TIMESTAMP:
-                case MYSQL_TYPE_DATETIME:
-                    yvar_cstr_with_size(local_result[cnt * field_cnt + i], row[i], lengths[i]);
-                    break;
-                case MYSQL_TYPE_NULL:
-                    YUKI_LOG_DEBUG("NULL type value");
-                    yvar_undefined(local_result[cnt * field_cnt + i]);
-
-                    break;
-                default:
-                    YUKI_LOG_WARNING("unsupported type. [type: %lu]", field_types[i]);
-                    yvar_undefined(local_result[cnt * field_cnt + i]);
+            if (!yvar_array_push(values, value)) {
+                YUKI_LOG_WARNING("cannot push result value");
+                return yfalse;
             }
         }
     }
 
-    yvar_t value_array[affected_rows];
-    yvar_t map_array[affected_rows];
-
-    for (i = 0; i < affected_rows; i++) {
-        yvar_array_with_size(value_array[i], local_result + i * field_cnt, field_cnt);
-        yvar_map(map_array[i], field_keys, value_array[i]);
+    // each row is a map of field keys and a slice of values. values are kept where they are.
+    if (!yvar_map_rows(*result, field_keys, values)) {
+        YUKI_LOG_WARNING("cannot build result rows");
+        return yfalse;
     }
 
-    yvar_t result_var = YVAR_ARRAY_WITH_SIZE(map_array, affected_rows);
-    return yvar_clone(*result, result_var);
+    return ytrue;
 }
 
 static ybool_t _ytable_sql_update_result_parser(const ytable_t * ytable, ytable_mysql_res_t * mysql_res, yvar_t ** result)
@@ -1202,12 +1238,25 @@ static ybool_t _ytable_build_sql(ytable_t * ytable)
 
 static ytable_connection_thread_data_t * _ytable_thread_get_connection()
 {
-    ytable_connection_thread_data_t * thread_data = pthread_getspecific(g_ytable_connection_thread_key);
+    yuki_thread_ctx_t * ctx = yuki_thread_ctx();
+    ytable_connection_thread_data_t * thread_data = ctx->connections;
+
+    // thread data created before ytable is re-init-ed has been freed in shutdown
+    if (thread_data && ctx->connections_generation != g_ytable_generation) {
+        YUKI_LOG_TRACE("drop connection thread data of previous init");
+        thread_data = NULL;
+        ctx->connections = NULL;
+    }
 
     if (!thread_data) {
         YUKI_LOG_TRACE("creating connection thread data...");
 
-        ybuffer_t * buffer = ybuffer_create_global(sizeof(ytable_connection_thread_data_t));
+        if (!_ythread_ctx_register(ctx)) {
+            YUKI_LOG_FATAL("cannot register thread context for connections");
+            return NULL;
+        }
+
+        ybuffer_t * buffer = ybuffer_site_create_global(sizeof(ytable_connection_thread_data_t), YBUFFER_SITE_CONFIG);
 
         if (!buffer) {
             YUKI_LOG_WARNING("out of memory");
@@ -1224,7 +1273,7 @@ static ytable_connection_thread_data_t * _ytable_thread_get_connection()
         thread_data->size = g_ytable_connection_configs_count;
 
         ysize_t conn_size = sizeof(ytable_connection_t) * g_ytable_connection_configs_count;
-        buffer = ybuffer_create_global(conn_size);
+        buffer = ybuffer_site_create_global(conn_size, YBUFFER_SITE_CONFIG);
 
         if (!buffer) {
             YUKI_LOG_WARNING("out of memory");
@@ -1252,7 +1301,8 @@ static ytable_connection_thread_data_t * _ytable_thread_get_connection()
 
         thread_data->connections = connections;
 
-        pthread_setspecific(g_ytable_connection_thread_key, thread_data);
+        ctx->connections = thread_data;
+        ctx->connections_generation = g_ytable_generation;
     }
 
     return thread_data;
@@ -1344,14 +1394,20 @@ static ybool_t _ytable_execute(ytable_t * ytable, ytable_connection_t * conn)
     return ytrue;
 }
 
-static void _ytable_connection_thread_clean_up(void * thread_data)
+/**
+ * close connections of a thread.
+ * called by thread destructor and shutdown.
+ */
+void _ytable_thread_clean_up(yuki_thread_ctx_t * ctx)
 {
-    if (!thread_data) {
+    ytable_connection_thread_data_t * data = ctx->connections;
+
+    if (!data || ctx->connections_generation != g_ytable_generation) {
         YUKI_LOG_TRACE("no thread data needs to be cleaned up");
+        ctx->connections = NULL;
         return;
     }
 
-    ytable_connection_thread_data_t * data = (ytable_connection_thread_data_t*)thread_data;
     ysize_t index;
 
     for (index = 0; index < data->size; index++) {
@@ -1359,6 +1415,8 @@ static void _ytable_connection_thread_clean_up(void * thread_data)
             mysql_close(&data->connections[index].mysql);
         }
     }
+
+    ctx->connections = NULL;
 }
 
 static ybool_t _ytable_fetch_internal(ytable_t * ytable, yvar_t ** result, yint32_t expected_rows)
@@ -1369,6 +1427,8 @@ static ybool_t _ytable_fetch_internal(ytable_t * ytable, yvar_t ** result, yint3
         return yfalse;
     }
 
+    _ytable_begin_call(ytable);
+
     ytable_t local_table = *ytable;
 
     if (expected_rows >= 0) {
@@ -1389,13 +1449,21 @@ static ybool_t _ytable_fetch_internal(ytable_t * ytable, yvar_t ** result, yint3
 
     _ytable_set_active_connection(&local_table, conn);
 
+    // sql text is scratch memory. release it as soon as query is sent.
+    ybuffer_mark_t mark = ybuffer_mark();
+
     if (!_ytable_build_sql(&local_table)) {
         YUKI_LOG_WARNING("unable to build sql");
+        ybuffer_rewind(mark);
         _ytable_set_last_error(ytable, YTABLE_ERROR_CANNOT_BUILD_SQL);
         return yfalse;
     }
 
-    if (!_ytable_execute(&local_table, conn)) {
+    ybool_t executed = _ytable_execute(&local_table, conn);
+    ybuffer_rewind(mark);
+    yvar_undefined(local_table.sql);
+
+    if (!executed) {
         YUKI_LOG_FATAL("fail to execute sql");
         _ytable_set_last_error(ytable, YTABLE_ERROR_CONNECTION);
         return yfalse;
@@ -1470,7 +1538,7 @@ static ybool_t _ytable_init_connection(config_t * config)
         return yfalse;
     }
 
-    ybuffer_t * buffer = ybuffer_create_global(sizeof(ytable_connection_config_t) * length);
+    ybuffer_t * buffer = ybuffer_site_create_global(sizeof(ytable_connection_config_t) * length, YBUFFER_SITE_CONFIG);
 
     if (!buffer) {
         YUKI_LOG_FATAL("cannot create global buffer for connection configs");
@@ -1519,7 +1587,7 @@ static ybool_t _ytable_init_connection(config_t * config)
         _YTABLE_CONFIG_ESTIMATE_STRING(size, cur->character_set);
     }
 
-    ybuffer_t * string_buffer = ybuffer_create_global(size);
+    ybuffer_t * string_buffer = ybuffer_site_create_global(size, YBUFFER_SITE_CONFIG);
 
     if (!string_buffer) {
         YUKI_LOG_FATAL("cannot create global buffer for connection strings");
@@ -1564,7 +1632,7 @@ static ybool_t _ytable_init_table(config_t * config)
         return yfalse;
     }
 
-    ybuffer_t * buffer = ybuffer_create_global(sizeof(ytable_table_config_t) * length);
+    ybuffer_t * buffer = ybuffer_site_create_global(sizeof(ytable_table_config_t) * length, YBUFFER_SITE_CONFIG);
 
     if (!buffer) {
         YUKI_LOG_FATAL("cannot create global buffer for table configs");
@@ -1664,7 +1732,7 @@ static ybool_t _ytable_init_table(config_t * config)
         _YTABLE_CONFIG_ESTIMATE_STRING(size, cur->hash_key);
     }
 
-    ybuffer_t * string_buffer = ybuffer_create_global(size);
+    ybuffer_t * string_buffer = ybuffer_site_create_global(size, YBUFFER_SITE_CONFIG);
 
     if (!string_buffer) {
         YUKI_LOG_FATAL("cannot create global buffer for table strings");
@@ -1702,10 +1770,8 @@ ybool_t _ytable_init(config_t * config)
         return yfalse;
     }
 
-    // init thread key
-    // TODO: use pthread_once
-    if (pthread_key_create(&g_ytable_connection_thread_key, &_ytable_connection_thread_clean_up)) {
-        YUKI_LOG_FATAL("cannot create thread key for ytable. [err: %d]", errno);
+    if (!ybuffer_pool_init(&g_ytable_pool, sizeof(ytable_t))) {
+        YUKI_LOG_FATAL("cannot init ytable pool");
         return yfalse;
     }
 
@@ -1721,7 +1787,11 @@ void _ytable_clean_up()
 void _ytable_shutdown()
 {
     // FIXME: once ytable is shut down, it cannot be turned on with different config.
-    // FIXME: thread data cannot be updated automatically after init ytable again.
+    // connections of other threads are dropped by generation check.
+    _ytable_thread_clean_up(yuki_thread_ctx());
+    g_ytable_generation++;
+    ybuffer_pool_destroy(&g_ytable_pool);
+
     g_ytable_table_configs = NULL;
     g_ytable_table_configs_count = 0;
     g_ytable_connection_configs = NULL;
@@ -1729,6 +1799,10 @@ void _ytable_shutdown()
     g_ytable_inited = yfalse;
 }
 
+/**
+ * get a ytable for table_name from pool.
+ * caller must return it by ytable_release().
+ */
 ytable_t * ytable_instance(const char * table_name)
 {
     if (!table_name) {
@@ -1746,14 +1820,7 @@ ytable_t * ytable_instance(const char * table_name)
         if (!strcmp(table_name, g_ytable_table_configs[index].name)) {
             YUKI_LOG_DEBUG("table is found. [name: %s] [index: %lu]", table_name, index);
 
-            ybuffer_t * buffer = ybuffer_create_global(sizeof(ytable_t));
-
-            if (!buffer) {
-                YUKI_LOG_WARNING("out of memory");
-                return NULL;
-            }
-
-            ytable_t * ytable = ybuffer_smart_alloc(buffer, ytable_t);
+            ytable_t * ytable = (ytable_t*)ybuffer_pool_alloc(&g_ytable_pool);
 
             if (!ytable) {
                 YUKI_LOG_WARNING("out of memory");
@@ -1770,6 +1837,29 @@ ytable_t * ytable_instance(const char * table_name)
     return NULL;
 }
 
+/**
+ * return a ytable got from ytable_instance() to pool.
+ * ytable must not be used after release.
+ * @note
+ * fields and conditions are cloned in thread arena and are not freed by release.
+ * a caller looping over many queries in one request can bracket each query with
+ * ybuffer_mark() and ybuffer_rewind() to keep arena from growing.
+ */
+void ytable_release(ytable_t * ytable)
+{
+    if (!ytable) {
+        YUKI_LOG_FATAL("invalid param");
+        return;
+    }
+
+    if (!_ytable_inited()) {
+        YUKI_LOG_WARNING("release ytable after ytable is shut down");
+        return;
+    }
+
+    ybuffer_pool_free(&g_ytable_pool, ytable);
+}
+
 ytable_t * ytable_reset(ytable_t * ytable)
 {
     ysize_t index = ytable->ytable_index;
@@ -1790,6 +1880,8 @@ ytable_t * _ytable_select(ytable_t * ytable, const yvar_t * fields)
         return ytable;
     }
 
+    _ytable_begin_call(ytable);
+
     if (!yvar_is_array(*fields)) {
         YUKI_LOG_DEBUG("fields must be array");
         _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_FIELD);
@@ -1823,6 +1915,8 @@ ytable_t * _ytable_insert(ytable_t * ytable, const yvar_t * values)
         return ytable;
     }
 
+    _ytable_begin_call(ytable);
+
     if (!yvar_is_map(*values)) {
         YUKI_LOG_DEBUG("values must be map");
         _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_PARAM);
@@ -1857,6 +1951,8 @@ ytable_t * _ytable_insert_using_map_kv(ytable_t * ytable, yvar_map_kv_t values,
         return ytable;
     }
 
+    _ytable_begin_call(ytable);
+
     if (!_ytable_check_verb(ytable)) {
         YUKI_LOG_DEBUG("verb is set before");
         _ytable_set_last_error(ytable, YTABLE_ERROR_CONFLICTED_VERB);
@@ -1886,6 +1982,8 @@ ytable_t * _ytable_update(ytable_t * ytable, const yvar_t * values)
         return ytable;
     }
 
+    _ytable_begin_call(ytable);
+
     if (!yvar_is_array(*values)) {
         YUKI_LOG_DEBUG("values must be map");
         _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_PARAM);
@@ -1920,6 +2018,8 @@ ytable_t * _ytable_update_using_triple_array(ytable_t * ytable, yvar_triple_arra
         return ytable;
     }
 
+    _ytable_begin_call(ytable);
+
     if (!_ytable_check_verb(ytable)) {
         YUKI_LOG_DEBUG("verb is set before");
         _ytable_set_last_error(ytable, YTABLE_ERROR_CONFLICTED_VERB);
@@ -1934,12 +2034,12 @@ ytable_t * _ytable_update_using_triple_array(ytable_t * ytable, yvar_triple_arra
     ysize_t index;
 
     for (index = 0; index < size; index++) {
-        yvar_array_with_size(fields[index], values[size], size);
+        yvar_array_with_size(fields[index], values[index], size);
     }
 
     yvar_t fields_var = YVAR_ARRAY_WITH_SIZE(fields, size);
 
-    if (yvar_clone(ytable->fields, fields_var)) {
+    if (!yvar_clone(ytable->fields, fields_var)) {
         YUKI_LOG_FATAL("cannot clone field");
         _ytable_set_last_error(ytable, YTABLE_ERROR_CANNOT_CLONE_VAR);
         return ytable;
@@ -1977,6 +2077,8 @@ ytable_t * _ytable_where(ytable_t * ytable, const yvar_t * conditions)
         return ytable;
     }
 
+    _ytable_begin_call(ytable);
+
     if (!_ytable_sql_is_valid_verb(ytable->verb)) {
         YUKI_LOG_FATAL("verb must be set before using where");
         _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_VERB);
@@ -1999,6 +2101,7 @@ ytable_t * _ytable_where(ytable_t * ytable, const yvar_t * conditions)
 
     // TODO: check conditions
 
+    // frozen conditions are shared instead of copied. see yvar_freeze().
     if (!yvar_clone(ytable->conditions, *conditions)) {
         YUKI_LOG_FATAL("cannot clone condition");
         _ytable_set_last_error(ytable, YTABLE_ERROR_CANNOT_CLONE_VAR);
@@ -2017,6 +2120,8 @@ ytable_t * _ytable_where_using_triple_array(ytable_t * ytable, yvar_triple_array
         return ytable;
     }
 
+    _ytable_begin_call(ytable);
+
     if (!_ytable_sql_is_valid_verb(ytable->verb)) {
         YUKI_LOG_FATAL("verb must be set before using where");
         _ytable_set_last_error(ytable, YTABLE_ERROR_INVALID_VERB);
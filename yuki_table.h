@@ -69,7 +69,11 @@ extern "C" {
 
 #define YTABLE_DELETE(ytable) _ytable_delete((ytable))
 
+/**
+ * get a ytable from pool. it must be returned by ytable_release() when done.
+ */
 ytable_t * ytable_instance(const char * table_name);
+void ytable_release(ytable_t * ytable);
 ytable_t * ytable_reset(ytable_t * ytable);
 ytable_t * _ytable_select(ytable_t * ytable, const yvar_t * fields);
 ytable_t * _ytable_insert(ytable_t * ytable, const yvar_t * values);
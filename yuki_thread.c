@@ -0,0 +1,140 @@
+#include <pthread.h>
+
+#include "libconfig.h"
+#include "yuki.h"
+
+extern void _ytable_thread_clean_up(yuki_thread_ctx_t * ctx);
+extern void _ybuffer_thread_clean_up(yuki_thread_ctx_t * ctx);
+extern void _ybuffer_thread_retire(yuki_thread_ctx_t * ctx);
+
+__thread yuki_thread_ctx_t g_yuki_thread_ctx __attribute__((tls_model("initial-exec")));
+
+// the only thread key in yuki. it's used to run destructor on thread exit.
+static pthread_key_t g_ythread_key;
+static pthread_once_t g_ythread_key_once = PTHREAD_ONCE_INIT;
+static int g_ythread_key_error = 0;
+
+// all registered contexts. walked by ybuffer_stats().
+static pthread_mutex_t g_ythread_ctx_mutex = PTHREAD_MUTEX_INITIALIZER;
+static yuki_thread_ctx_t * g_ythread_ctx_list = NULL;
+
+static void _ythread_destroy(void * ctx)
+{
+    if (!ctx) {
+        return;
+    }
+
+    yuki_thread_ctx_t * thread_ctx = (yuki_thread_ctx_t*)ctx;
+
+    // key value is cleared before destructor runs. register again if context is reused.
+    thread_ctx->registered = yfalse;
+
+    // ytable may use buffer memory. clean it up first.
+    _ytable_thread_clean_up(thread_ctx);
+    _ybuffer_thread_clean_up(thread_ctx);
+
+    pthread_mutex_lock(&g_ythread_ctx_mutex);
+
+    // counters must move to global totals before context goes away
+    _ybuffer_thread_retire(thread_ctx);
+
+    if (thread_ctx->next) {
+        thread_ctx->next->prev = thread_ctx->prev;
+    }
+
+    if (thread_ctx->prev) {
+        thread_ctx->prev->next = thread_ctx->next;
+    } else {
+        g_ythread_ctx_list = thread_ctx->next;
+    }
+
+    thread_ctx->prev = NULL;
+    thread_ctx->next = NULL;
+    pthread_mutex_unlock(&g_ythread_ctx_mutex);
+}
+
+static void _ythread_key_create()
+{
+    g_ythread_key_error = pthread_key_create(&g_ythread_key, &_ythread_destroy);
+}
+
+ybool_t _ythread_init(config_t * config)
+{
+    (void)config;
+
+    // key is never deleted as other threads may still hold their contexts.
+    pthread_once(&g_ythread_key_once, &_ythread_key_create);
+
+    if (g_ythread_key_error) {
+        YUKI_LOG_FATAL("cannot create thread key. [err: %d]", g_ythread_key_error);
+        return yfalse;
+    }
+
+    return ytrue;
+}
+
+void _ythread_clean_up()
+{
+    // do nothing
+}
+
+void _ythread_shutdown()
+{
+    // do nothing
+}
+
+/**
+ * make sure thread destructor will be called for this context.
+ * every component must call it before storing resources in context.
+ */
+ybool_t _ythread_ctx_register(yuki_thread_ctx_t * ctx)
+{
+    if (ctx->registered) {
+        return ytrue;
+    }
+
+    pthread_once(&g_ythread_key_once, &_ythread_key_create);
+
+    if (g_ythread_key_error) {
+        YUKI_LOG_FATAL("thread key is not created. [err: %d]", g_ythread_key_error);
+        return yfalse;
+    }
+
+    int error = pthread_setspecific(g_ythread_key, ctx);
+
+    if (error) {
+        YUKI_LOG_FATAL("cannot set thread context. [err: %d]", error);
+        return yfalse;
+    }
+
+    pthread_mutex_lock(&g_ythread_ctx_mutex);
+    ctx->prev = NULL;
+    ctx->next = g_ythread_ctx_list;
+
+    if (ctx->next) {
+        ctx->next->prev = ctx;
+    }
+
+    g_ythread_ctx_list = ctx;
+    pthread_mutex_unlock(&g_ythread_ctx_mutex);
+
+    ctx->registered = ytrue;
+    return ytrue;
+}
+
+/**
+ * call visitor on every registered context.
+ * contexts cannot exit while visitor is running.
+ */
+void _ythread_ctx_foreach(ythread_ctx_visitor_func visitor, void * data)
+{
+    yuki_thread_ctx_t * ctx = NULL;
+
+    pthread_mutex_lock(&g_ythread_ctx_mutex);
+
+    for (ctx = g_ythread_ctx_list; ctx; ctx = ctx->next) {
+        visitor(ctx, data);
+    }
+
+    pthread_mutex_unlock(&g_ythread_ctx_mutex);
+}
@@ -0,0 +1,25 @@
+#ifndef _YUKI_THREAD_H_
+#define _YUKI_THREAD_H_
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * thread context of current thread.
+ * initial-exec tls model makes access a single fs-relative load.
+ */
+extern __thread yuki_thread_ctx_t g_yuki_thread_ctx __attribute__((tls_model("initial-exec")));
+
+#define yuki_thread_ctx() (&g_yuki_thread_ctx)
+
+typedef void (*ythread_ctx_visitor_func)(yuki_thread_ctx_t * ctx, void * data);
+
+ybool_t _ythread_ctx_register(yuki_thread_ctx_t * ctx);
+void _ythread_ctx_foreach(ythread_ctx_visitor_func visitor, void * data);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -12,6 +12,7 @@
 #endif
 
 #include <stddef.h>
+#include <pthread.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -66,6 +67,7 @@ typedef enum _YVAR_TYPE {
     YVAR_TYPE_ARRAY,
     YVAR_TYPE_LIST,
     YVAR_TYPE_MAP,
+    YVAR_TYPE_PACKED,
     YVAR_TYPE_MAX, // max
 } YVAR_TYPE;
 
@@ -78,6 +80,12 @@ typedef enum _YVAR_OPTIONS {
     YVAR_OPTION_HOLD_RESOURCE = 0x2, /**< need to free memory */
     YVAR_OPTION_SORTED = 0x4, /**< array is sorted */
     YVAR_OPTION_PINNED = 0x8, /**< var is pinned. pinned var cannot be modified until upinned. */
+    YVAR_OPTION_INDEXED = 0x10, /**< internal. map has a hash index placed before its keys. */
+    YVAR_OPTION_INTERNED = 0x20, /**< string points to canonical copy in intern table. see yvar_intern(). */
+    YVAR_OPTION_INLINE = 0x40, /**< internal. short string is stored inside var. */
+    YVAR_OPTION_HASHED = 0x80, /**< internal. hash of cstr is cached in var. */
+    YVAR_OPTION_FROZEN = 0x100, /**< var and everything it references are immutable and shared by clones. see yvar_freeze(). */
+    YVAR_OPTION_GROWABLE = 0x200, /**< internal. array has a capacity header placed before its vars. see yvar_array_push(). */
 } YVAR_OPTIONS;
 
 typedef int8_t ybool_t;
@@ -106,11 +114,25 @@ typedef struct _ystr_t {
     char * str;
 } ystr_t;
 
+/**
+ * short string stored inside var. it's created by clone/pin.
+ */
+#define YVAR_INLINE_STR_MAX_SIZE 14
+
+typedef struct _yinline_str_t {
+    char str[YVAR_INLINE_STR_MAX_SIZE + 1];
+    yuint8_t size;
+} yinline_str_t;
+
 typedef struct _yarray_t {
     ysize_t size;
     struct _yvar_t * yvars;
 } yarray_t;
 
+/**
+ * list of vars stored in unrolled nodes.
+ * size of list is offset of tail node plus its size.
+ */
 typedef struct _ylist_t {
     struct _ylist_node_t * head;
     struct _ylist_node_t * tail;
@@ -126,10 +148,21 @@ typedef struct _ymap_t {
     struct _yvar_t * values;
 } ymap_t;
 
+/**
+ * ints of the same int-like type stored one after another without var header.
+ * see yvar_packed().
+ */
+typedef struct _ypacked_t {
+    yuint32_t size;
+    yuint8_t type; /**< type of elements. bool, int8, ..., uint64 */
+    void * data;
+} ypacked_t;
+
 typedef struct _yvar_t {
     yuint8_t type;
     yuint8_t version;
     yvar_option_t options;
+    yuint32_t hash; /**< cached hash of string. it's valid only if YVAR_OPTION_HASHED is set. */
 
     union {
         yint8_t yundefined_data; // should be always 0
@@ -144,21 +177,78 @@ typedef struct _yvar_t {
         yuint64_t yuint64_data;
         ycstr_t ycstr_data;
         ystr_t ystr_data;
+        yinline_str_t yinline_data;
         yarray_t yarray_data;
         ylist_t ylist_data;
         ymap_t ymap_data;
+        ypacked_t ypacked_data;
     } data;
 } yvar_t;
 
 typedef yvar_t yvar_map_kv_t[][2];
 typedef yvar_t yvar_triple_array_t[][3];
 
+/**
+ * default number of vars in a list node.
+ */
+#define YLIST_NODE_CAPACITY 16
+
+/**
+ * list node holds a block of vars. a node is never empty.
+ */
 typedef struct _ylist_node_t {
     struct _ylist_node_t * prev;
     struct _ylist_node_t * next;
-    yvar_t yvar;
+    ysize_t offset; /**< index of first var of this node in list */
+    ysize_t size; /**< number of vars in this node */
+    ysize_t capacity; /**< max number of vars in this node */
+    yvar_t yvars[];
 } ylist_node_t;
 
+/**
+ * a var in serialized buffer. see yvar_serialize().
+ */
+struct _yvar_record_t;
+
+/**
+ * read-only cursor on a var in serialized buffer.
+ * it's valid as long as the buffer is.
+ */
+typedef struct _yvar_view_t {
+    const char * base; /**< start of buffer */
+    ysize_t size; /**< size of buffer */
+    const struct _yvar_record_t * record;
+} yvar_view_t;
+
+/**
+ * what yvar_walk() does after a visitor returns.
+ */
+typedef enum _YVAR_WALK_RESULT {
+    YVAR_WALK_CONTINUE = 0, /**< visit elements of var */
+    YVAR_WALK_SKIP, /**< don't visit elements of var */
+    YVAR_WALK_STOP, /**< stop walking. yvar_walk() returns yfalse. */
+} YVAR_WALK_RESULT;
+
+/**
+ * a var on the stack of yvar_walk().
+ * elements of array and list are visited in order. elements of map are its keys and values arrays.
+ */
+typedef struct _yvar_walk_frame_t {
+    const yvar_t * yvar; /**< var being visited */
+    yvar_t * peer; /**< var at the same position in peer tree. NULL if peer tree has no such var. */
+    ysize_t index; /**< index of var in its parent. keys of map is 0 and values is 1. */
+    ysize_t depth; /**< root is 0 */
+
+    // internal. position of next element.
+    ysize_t next;
+    const ylist_node_t * node;
+    ysize_t node_index;
+    const ylist_node_t * peer_node;
+    ysize_t peer_node_index;
+} yvar_walk_frame_t;
+
+typedef YVAR_WALK_RESULT (*yvar_walk_func)(yvar_walk_frame_t * frame, void * data);
+
 typedef struct _ybuffer_t {
     ysize_t size;
     ysize_t offset;
@@ -166,11 +256,109 @@ typedef struct _ybuffer_t {
     char buffer[];
 } ybuffer_t;
 
+/**
+ * arena memory detached by ybuffer_detach().
+ * it lives in the memory it describes.
+ */
+typedef struct _ybuffer_chain_t {
+    ybuffer_t * chunks;
+    ybuffer_t * blocks;
+    struct _ybuffer_chain_t * next; /**< next chain adopted by the same thread or detached along with this one */
+    ysize_t live_bytes;
+    ysize_t chunk_count;
+    ysize_t wasted_bytes;
+} ybuffer_chain_t;
+
+/**
+ * per-thread bump arena.
+ * small buffers are carved from chunks, big ones get a dedicated block.
+ */
+typedef struct _ybuffer_arena_t {
+    ybuffer_t * chunks; /**< current chunk is the head */
+    ybuffer_t * blocks; /**< dedicated blocks */
+    ybuffer_t * retired; /**< destroyed global buffers */
+    ybuffer_t * spare; /**< chunks retained across clean up */
+    ybuffer_t * mapped; /**< mapped block kept for reuse with its pages dropped */
+    ybuffer_chain_t * adopted; /**< chains adopted from other threads */
+    ysize_t next_chunk_size;
+} ybuffer_arena_t;
+
+/**
+ * position in thread arena returned by ybuffer_mark().
+ */
+typedef struct _ybuffer_mark_t {
+    ybuffer_t * chunk;
+    ysize_t offset;
+    ybuffer_t * block;
+} ybuffer_mark_t;
+
+/**
+ * who asks ybuffer for memory. used by ybuffer_stats().
+ */
+typedef enum _ybuffer_site_t {
+    YBUFFER_SITE_OTHER,
+    YBUFFER_SITE_CLONE, /**< yvar_clone() and yvar_pin() */
+    YBUFFER_SITE_LIST, /**< list nodes */
+    YBUFFER_SITE_ARRAY, /**< growable arrays */
+    YBUFFER_SITE_JSON, /**< yvar_to_json() and yvar_from_json() */
+    YBUFFER_SITE_SQL, /**< sql built by ytable */
+    YBUFFER_SITE_CONFIG, /**< ytable config and connections */
+    YBUFFER_SITE_MAX,
+} ybuffer_site_t;
+
+/**
+ * memory usage reported by ybuffer_stats().
+ */
+typedef struct _ybuffer_stats_t {
+    ysize_t live_bytes; /**< arena bytes handed out and not released */
+    ysize_t peak_bytes; /**< max live bytes since thread starts */
+    ysize_t chunk_count; /**< arena chunks and dedicated blocks in use */
+    ysize_t wasted_bytes; /**< unused tail of arena chunks that are not current */
+    ysize_t global_bytes; /**< memory held by global buffers. only set in global stats */
+    yuint64_t alloc_count[YBUFFER_SITE_MAX];
+    yuint64_t refused_count; /**< allocations refused by thread budget */
+} ybuffer_stats_t;
+
+/**
+ * called when an allocation crosses thread budget.
+ * return ytrue to let the allocation go on.
+ */
+typedef ybool_t (*ybuffer_budget_func)(ysize_t live_bytes, ysize_t size, ysize_t budget, void * data);
+
+/**
+ * max number of live ybuffer pools.
+ */
+#define YBUFFER_POOL_MAX 8
+
+/**
+ * fixed-size object pool.
+ * objects are global memory recycled through per-thread magazines.
+ */
+typedef struct _ybuffer_pool_t {
+    pthread_mutex_t mutex;
+    void * depot; /**< free objects shared by all threads */
+    ysize_t depot_count;
+    ybuffer_t * slabs; /**< memory owned by pool */
+    ysize_t object_size;
+    yuint32_t id; /**< unique id. 0 means pool is not init-ed */
+    yuint32_t slot; /**< magazine index in thread context */
+} ybuffer_pool_t;
+
+/**
+ * per-thread cache of free objects of a pool.
+ */
+typedef struct _ybuffer_magazine_t {
+    void * head;
+    ysize_t count;
+    yuint32_t pool_id;
+} ybuffer_magazine_t;
+
 /**
  * cookie for global buffer.
  */
 typedef struct _ybuffer_cookie_t {
     ybuffer_t * prev;
+    yuint64_t shard;
     yuint64_t padding;
 } ybuffer_cookie_t;
 
@@ -204,6 +392,7 @@ typedef enum _ytable_error_t {
     YTABLE_ERROR_NOT_EXPECTED_RESULT,
     YTABLE_ERROR_CANNOT_FETCH_INSERT_ID,
     YTABLE_ERROR_NOT_IMPLEMENTED,
+    YTABLE_ERROR_OUT_OF_BUDGET,
     YTABLE_ERROR_UNKNOWN,
 } ytable_error_t;
 
@@ -222,6 +411,7 @@ typedef struct _ytable_t {
     yvar_t sql;
     ytable_verb_t verb;
     ytable_error_t last_error;
+    yuint64_t refused_count; /**< thread refused count when current call starts */
     ysize_t ytable_index; /**< index in ytable conf. */
 } ytable_t;
 
@@ -263,6 +453,24 @@ typedef struct _ytable_sql_buider_t {
     ytable_sql_result_parser_func parser;
 } ytable_sql_builder_t;
 
+/**
+ * all per-thread states of yuki.
+ */
+typedef struct _yuki_thread_ctx_t {
+    ybuffer_arena_t arena;
+    ybuffer_magazine_t magazines[YBUFFER_POOL_MAX];
+    ybuffer_stats_t stats; /**< only written by owner thread */
+    ysize_t budget; /**< arena byte budget. 0 means config default */
+    ybool_t over_budget; /**< an allocation is refused since last clean up */
+    struct _yuki_thread_ctx_t * prev; /**< registered contexts */
+    struct _yuki_thread_ctx_t * next;
+    ytable_connection_thread_data_t * connections;
+    yuint32_t connections_generation; /**< ytable init generation owning connections */
+    yint32_t logid;
+    yuint32_t shard; /**< global buffer shard index plus 1 */
+    ybool_t registered; /**< thread destructor is registered */
+} yuki_thread_ctx_t;
+
 #ifdef __cplusplus
 }
 #endif
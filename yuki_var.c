@@ -1,11 +1,74 @@
 #include <string.h>
 #include <stdio.h>
+#include <stdlib.h>
 #include <assert.h>
+#include <pthread.h>
 
+#include "libconfig.h"
 #include "yuki.h"
 
-// forward declaration as _yvar_clone_internal_element() uses it.
-static ybool_t _yvar_list_push_back_internal(ybuffer_t * buffer, yvar_t * list, const yvar_t * var, ybool_t need_clone);
+/**
+ * memory where a var is cloned to.
+ * a growable ctx takes a new buffer from thread arena when current one is full,
+ * so that var can be cloned in one pass without sizing it first.
+ */
+typedef struct _yvar_clone_ctx_t {
+    ybuffer_t * buffer;
+    ysize_t next_size; /**< size of next buffer. 0 means buffer is not growable. */
+} yvar_clone_ctx_t;
+
+// clone buffer doubles from min size to max size like arena chunks
+#define YVAR_CLONE_BUFFER_MIN_SIZE ((ysize_t)512)
+#define YVAR_CLONE_BUFFER_MAX_SIZE (YBUFFER_CHUNK_MIN_SIZE / 4)
+
+/**
+ * hash index of a map. open addressing with linear probing.
+ * memory layout in clone buffer is [slots][index][keys var].
+ * a slot stores key index plus 1. 0 means empty.
+ */
+typedef struct _yvar_map_index_t {
+    yuint32_t capacity; /**< power of 2 */
+    yuint32_t count;
+} yvar_map_index_t;
+
+/**
+ * header of a growable array. it's placed right before vars of the array.
+ * `size` is the size of the var owning the end of block. only this var can push in place.
+ */
+typedef struct _yvar_array_block_t {
+    ysize_t capacity;
+    ysize_t size;
+} yvar_array_block_t;
+
+#define YVAR_ARRAY_MIN_CAPACITY ((ysize_t)8)
+
+/**
+ * canonical copy of an interned string. it's immutable once published.
+ */
+typedef struct _yvar_intern_entry_t {
+    yuint32_t hash;
+    ysize_t size;
+    char str[];
+} yvar_intern_entry_t;
+
+/**
+ * intern table. open addressing with linear probing.
+ * readers probe it without lock. writers insert under g_yvar_intern_mutex.
+ * table pointer and slots are published with release store and read with acquire load.
+ * a grown table replaces the old one, which is kept until shutdown
+ * as readers may still be probing it.
+ */
+typedef struct _yvar_intern_table_t {
+    yuint32_t capacity; /**< power of 2 */
+    yuint32_t count;
+    struct _yvar_intern_table_t * retired;
+    yvar_intern_entry_t * slots[];
+} yvar_intern_table_t;
+
+#define YVAR_INTERN_MIN_CAPACITY 256
+
+static yvar_intern_table_t * g_yvar_intern_table = NULL;
+static pthread_mutex_t g_yvar_intern_mutex = PTHREAD_MUTEX_INITIALIZER;
 
 static ybool_t _ybool_to_str(ybool_t ybool, char * output, ysize_t size)
 {
@@ -28,36 +91,31 @@ static ybool_t _ybool_to_str(ybool_t ybool, char * output, ysize_t size)
     return ytrue;
 }
 
-#define _YUKI_INT_TYPE_TO_STR_FUNCTION(t, s) \
+#define _YUKI_INT_TYPE_TO_STR_FUNCTION(t, f) \
     static ybool_t _##t##_to_str(t##_t t, char * output, ysize_t size) \
     { \
         YUKI_ASSERT(output && size); \
         \
-        char buf[32]; \
-        int n = snprintf(buf, sizeof(buf), s, t); \
-        \
-        if (n < 0) { \
-            YUKI_LOG_FATAL("snprintf fails with err %d", n); \
-            return yfalse; \
-        } \
+        char buf[YSTRING_INT_MAX_LENGTH + 1]; \
+        ysize_t n = f(t, buf); \
         \
         if (n >= size) { \
-            YUKI_LOG_WARNING("buffer length is too small. [required: %d] [actual: %u]", n + 1, size); \
+            YUKI_LOG_WARNING("buffer length is too small. [required: %u] [actual: %u]", n + 1, size); \
             return yfalse; \
         } \
         \
-        strncpy(output, buf, n + 1); \
+        memcpy(output, buf, n + 1); \
         return ytrue; \
     }
 
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yint8,   "%d")
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint8,  "%u")
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yint16,  "%d")
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint16, "%u")
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yint32,  "%" PRId32)
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint32, "%" PRIu32)
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yint64,  "%" PRId64)
-_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint64, "%" PRIu64)
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yint8,   ystring_from_int64)
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint8,  ystring_from_uint64)
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yint16,  ystring_from_int64)
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint16, ystring_from_uint64)
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yint32,  ystring_from_int64)
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint32, ystring_from_uint64)
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yint64,  ystring_from_int64)
+_YUKI_INT_TYPE_TO_STR_FUNCTION(yuint64, ystring_from_uint64)
 
 static ybool_t _ycstr_to_str(const ycstr_t * ycstr, char * output, ysize_t size)
 {
@@ -73,496 +131,1013 @@ static ybool_t _ycstr_to_str(const ycstr_t * ycstr, char * output, ysize_t size)
     return ytrue;
 }
 
+static inline yuint32_t _yvar_hash_int(yuint64_t value)
+{
+    // finalizer of murmur3
+    value ^= value >> 33;
+    value *= 0xFF51AFD7ED558CCDULL;
+    value ^= value >> 33;
+    value *= 0xC4CEB9FE1A85EC53ULL;
+    value ^= value >> 33;
+    return (yuint32_t)value;
+}
+
 /**
- * count size of memory of a var recursively.
- * especially, if yvar is NULL, return 0.
+ * size of a string var. NULL string is treated as empty.
  */
-static ysize_t _yvar_mem_size(const yvar_t * yvar)
+static inline ysize_t _yvar_str_size(const yvar_t * yvar)
 {
-    YUKI_ASSERT(yvar);
+    if (yvar->options & YVAR_OPTION_INLINE) {
+        return yvar->data.yinline_data.size;
+    }
 
-    ysize_t size = ybuffer_round_up(sizeof(yvar_t));
+    return yvar->data.ycstr_data.str? yvar->data.ycstr_data.size: 0;
+}
 
-    switch (yvar->type) {
-        case YVAR_TYPE_ARRAY:
-        {
-            FOREACH_YVAR_ARRAY(*yvar, value) {
-                size += _yvar_mem_size(value);
-            }
+static inline yuint32_t _yvar_hash_bytes(const char * str, ysize_t size)
+{
+    // fnv-1a
+    const unsigned char * bytes = (const unsigned char*)str;
+    yuint32_t hash = 2166136261u;
+    ysize_t i;
 
-            ysize_t cnt = yvar_count(*yvar);
-            size += ybuffer_round_up(cnt * sizeof(yvar_t));
-            size -= ybuffer_round_up(sizeof(yvar_t)) * cnt;
+    for (i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
 
-            break;
-        }
-        case YVAR_TYPE_LIST:
-        {
-            FOREACH_YVAR_LIST(*yvar, value) {
-                size += _yvar_mem_size(value) + ybuffer_round_up(sizeof(ylist_node_t) - sizeof(yvar_t));
-            }
+    return hash;
+}
 
-            break;
-        }
-        case YVAR_TYPE_MAP:
-            size += _yvar_mem_size(yvar->data.ymap_data.keys);
-            size += _yvar_mem_size(yvar->data.ymap_data.values);
-            break;
-        case YVAR_TYPE_STR:
+/**
+ * hash of a var. vars equal to each other always have the same hash.
+ * it's used by map index and can be used as cache key.
+ * cstr hash is cached in var by clone/pin/intern.
+ */
+yuint32_t _yvar_hash(const yvar_t * yvar)
+{
+    if (yvar->options & YVAR_OPTION_HASHED) {
+        return yvar->hash;
+    }
+
+    switch (yvar->type) {
+        case YVAR_TYPE_BOOL:
+            return _yvar_hash_int(yvar->data.ybool_data);
+        case YVAR_TYPE_INT8:
+            return _yvar_hash_int(yvar->data.yint8_data);
+        case YVAR_TYPE_UINT8:
+            return _yvar_hash_int(yvar->data.yuint8_data);
+        case YVAR_TYPE_INT16:
+            return _yvar_hash_int(yvar->data.yint16_data);
+        case YVAR_TYPE_UINT16:
+            return _yvar_hash_int(yvar->data.yuint16_data);
+        case YVAR_TYPE_INT32:
+            return _yvar_hash_int(yvar->data.yint32_data);
+        case YVAR_TYPE_UINT32:
+            return _yvar_hash_int(yvar->data.yuint32_data);
+        case YVAR_TYPE_INT64:
+            return _yvar_hash_int(yvar->data.yint64_data);
+        case YVAR_TYPE_UINT64:
+            return _yvar_hash_int(yvar->data.yuint64_data);
         case YVAR_TYPE_CSTR:
-            size += ybuffer_round_up((yvar_cstr_strlen(*yvar)) + 1);
-            break;
+        case YVAR_TYPE_STR:
+            return _yvar_hash_bytes(yvar_cstr_buffer(*yvar), _yvar_str_size(yvar));
+        default:
+            // containers are rarely used as key. put them in one bucket.
+            return yvar->type;
     }
+}
 
-    return size;
+static inline yuint32_t _yvar_map_index_capacity(ysize_t count)
+{
+    yuint32_t capacity = 1;
+
+    while (capacity < count * 2) {
+        capacity <<= 1;
+    }
+
+    return capacity;
 }
 
 /**
- * clone internal elements of a var in a given buffer.
+ * memory of hash index needed by a map.
  */
-static ybool_t _yvar_clone_internal_element(ybuffer_t * buffer, yvar_t * new_var, const yvar_t * old_var)
+static ysize_t _yvar_map_index_mem_size(const yvar_t * map)
 {
-    YUKI_ASSERT(buffer && new_var && old_var);
+    const yvar_t * keys = map->data.ymap_data.keys;
 
-    yvar_memzero(*new_var);
-
-    if (!yvar_assign(*new_var, *old_var)) {
-        YUKI_LOG_FATAL("cannot assign new value");
-        return yfalse;
+    if (!keys || !yvar_is_array(*keys) || yvar_count(*keys) < YVAR_MAP_INDEX_THRESHOLD) {
+        return 0;
     }
 
-    // recursively enum elements in old var and allocate new resouce to clone value
-    switch (old_var->type) {
-        case YVAR_TYPE_ARRAY:
-        {
-            yvar_t * yvars = (yvar_t*)ybuffer_alloc(buffer, old_var->data.yarray_data.size * sizeof(yvar_t));
+    return ybuffer_round_up(_yvar_map_index_capacity(yvar_count(*keys)) * sizeof(yuint32_t))
+        + ybuffer_round_up(sizeof(yvar_map_index_t));
+}
 
-            if (!yvars) {
-                YUKI_LOG_WARNING("out of memory");
-                return yfalse;
-            }
+static inline yvar_map_index_t * _yvar_map_index(const yvar_t * map)
+{
+    return (yvar_map_index_t*)((char*)map->data.ymap_data.keys - ybuffer_round_up(sizeof(yvar_map_index_t)));
+}
 
-            ysize_t cnt = 0;
+static inline yuint32_t * _yvar_map_index_slots(yvar_map_index_t * index)
+{
+    return (yuint32_t*)((char*)index - ybuffer_round_up(index->capacity * sizeof(yuint32_t)));
+}
 
-            FOREACH_YVAR_ARRAY(*old_var, value) {
-                if (!_yvar_clone_internal_element(buffer, yvars + cnt, value)) {
-                    YUKI_LOG_WARNING("fail to clone internal buffer");
-                    return yfalse;
-                }
+/**
+ * fill hash index with cloned keys.
+ * the first one wins if a key appears more than once, same as linear search.
+ */
+static void _yvar_map_index_build(yvar_map_index_t * index, const yvar_t * keys)
+{
+    yuint32_t * slots = _yvar_map_index_slots(index);
+    yuint32_t mask = index->capacity - 1;
+    yuint32_t i, pos;
 
-                cnt++;
-            }
+    memset(slots, 0, index->capacity * sizeof(yuint32_t));
 
-            new_var->data.yarray_data.yvars = yvars;
+    for (i = 0; i < index->count; i++) {
+        const yvar_t * key = keys->data.yarray_data.yvars + i;
 
-            break;
+        for (pos = _yvar_hash(key) & mask; slots[pos]; pos = (pos + 1) & mask) {
+            if (yvar_equal(keys->data.yarray_data.yvars[slots[pos] - 1], *key)) {
+                break;
+            }
         }
-        case YVAR_TYPE_LIST:
-        {
-            yvar_t list = YVAR_LIST();
 
-            FOREACH_YVAR_LIST(*old_var, value) {
-                if (!_yvar_list_push_back_internal(buffer, &list, value, ytrue)) {
-                    YUKI_LOG_WARNING("cannot add new node");
-                    return yfalse;
-                }
-            }
+        if (!slots[pos]) {
+            slots[pos] = i + 1;
+        }
+    }
+}
 
-            new_var->data.ylist_data.head = list.data.ylist_data.head;
-            new_var->data.ylist_data.tail = list.data.ylist_data.tail;
+/**
+ * frames on C stack. deeper vars grow the stack on heap.
+ */
+#define YVAR_WALK_STACK_SIZE 32
 
-            break;
-        }
-        case YVAR_TYPE_MAP:
-        {
-            yvar_t * keys = ybuffer_smart_alloc(buffer, yvar_t);
+/**
+ * prepare to visit elements of the var in frame.
+ */
+static inline void _yvar_walk_begin(yvar_walk_frame_t * frame)
+{
+    const yvar_t * peer = frame->peer;
 
-            if (!keys) {
-                YUKI_LOG_WARNING("out of memory");
-                return yfalse;
+    frame->next = 0;
+    frame->node = NULL;
+    frame->node_index = 0;
+    frame->peer_node = NULL;
+    frame->peer_node_index = 0;
+
+    if (yvar_is_list(*frame->yvar)) {
+        frame->node = frame->yvar->data.ylist_data.head;
+        frame->peer_node = peer && yvar_is_list(*peer)? peer->data.ylist_data.head: NULL;
+    }
+}
+
+/**
+ * get next element of the var in frame and the element at the same position in peer.
+ * @return NULL if all elements are visited.
+ */
+static inline const yvar_t * _yvar_walk_next(yvar_walk_frame_t * frame, yvar_t ** peer)
+{
+    const yvar_t * yvar = frame->yvar;
+    yvar_t * parent_peer = frame->peer;
+    const yvar_t * element;
+
+    *peer = NULL;
+
+    switch (yvar->type) {
+        case YVAR_TYPE_ARRAY:
+            if (frame->next >= yvar->data.yarray_data.size) {
+                return NULL;
             }
 
-            if (!_yvar_clone_internal_element(buffer, keys, old_var->data.ymap_data.keys)) {
-                YUKI_LOG_WARNING("fail to clone internal buffer");
-                return yfalse;
+            element = yvar->data.yarray_data.yvars + frame->next;
+
+            if (parent_peer && yvar_is_array(*parent_peer) && frame->next < parent_peer->data.yarray_data.size) {
+                *peer = parent_peer->data.yarray_data.yvars + frame->next;
+            }
+
+            break;
+        case YVAR_TYPE_LIST:
+            if (!frame->node) {
+                return NULL;
             }
 
-            yvar_t * values = ybuffer_smart_alloc(buffer, yvar_t);
+            element = frame->node->yvars + frame->node_index;
 
-            if (!values) {
-                YUKI_LOG_WARNING("out of memory");
-                return yfalse;
+            if (++frame->node_index == frame->node->size) {
+                frame->node = frame->node->next;
+                frame->node_index = 0;
             }
 
-            if (!_yvar_clone_internal_element(buffer, values, old_var->data.ymap_data.values)) {
-                YUKI_LOG_WARNING("fail to clone internal buffer");
-                return yfalse;
+            // nodes of peer list may be of different sizes
+            if (frame->peer_node) {
+                *peer = (yvar_t*)frame->peer_node->yvars + frame->peer_node_index;
+
+                if (++frame->peer_node_index == frame->peer_node->size) {
+                    frame->peer_node = frame->peer_node->next;
+                    frame->peer_node_index = 0;
+                }
             }
 
-            new_var->data.ymap_data.keys = keys;
-            new_var->data.ymap_data.values = values;
-            
             break;
-        }
-        case YVAR_TYPE_CSTR:
-        case YVAR_TYPE_STR:
-        {
-            // the len includes '\0'
-            ysize_t len = yvar_cstr_strlen(*old_var) + 1;
-            char * dest = (char *)ybuffer_alloc(buffer, len);
+        case YVAR_TYPE_MAP:
+            if (frame->next >= 2) {
+                return NULL;
+            }
 
-            if (!dest) {
-                YUKI_LOG_WARNING("out of memory");
-                return yfalse;
+            element = frame->next? yvar->data.ymap_data.values: yvar->data.ymap_data.keys;
+
+            if (parent_peer && yvar_is_map(*parent_peer)) {
+                *peer = frame->next? parent_peer->data.ymap_data.values: parent_peer->data.ymap_data.keys;
             }
 
-            strncpy(dest, yvar_cstr_buffer(*old_var), len);
-            yvar_str_buffer(*new_var) = dest;
             break;
-        }
+        default:
+            return NULL;
     }
 
-    return ytrue;
+    frame->next++;
+    return element;
 }
 
-static ybool_t _yvar_map_assoc_array_sort(yvar_map_kv_t src, ysize_t src_size,
-    yvar_t even_dst[], ysize_t even_size,
-    yvar_t odd_dst[], ysize_t odd_size)
+static ybool_t _yvar_walk_grow(yvar_walk_frame_t ** stack, const yvar_walk_frame_t * local_stack, ysize_t * capacity)
 {
-    YUKI_ASSERT(src && even_dst && odd_dst);
-    YUKI_ASSERT(src_size == odd_size);
-    YUKI_ASSERT(src_size == even_size);
+    yvar_walk_frame_t * frames = (yvar_walk_frame_t*)malloc(*capacity * 2 * sizeof(yvar_walk_frame_t));
 
-    // copy odd value to odd array, even to even array
-    ysize_t index = 0;
-    for (; index < src_size; index++) {
-        // NOTE: don't use yvar_assign, as dst is not initialized.
-        even_dst[index] = src[index][0];
-        odd_dst[index] = src[index][1];
+    if (!frames) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
     }
 
-    // TODO: sort array
+    memcpy(frames, *stack, *capacity * sizeof(yvar_walk_frame_t));
+
+    if (*stack != local_stack) {
+        free(*stack);
+    }
 
+    *stack = frames;
+    *capacity *= 2;
     return ytrue;
 }
 
-static ybool_t _yvar_clone_internal(ybuffer_t * buffer, yvar_t ** new_var, const yvar_t * old_var)
+/**
+ * walk a var tree in depth-first order without recursion.
+ * pre is called before elements of a var are visited. elements are visited only if pre returns
+ * YVAR_WALK_CONTINUE. post is called after all elements are visited. either of them can be NULL.
+ *
+ * if peer is set, peer tree is walked in step with var tree. e.g. compare two trees, or fill
+ * a tree of the same shape. to modify a tree in place, walk it with itself as peer.
+ *
+ * sample code.
+ * @code
+ * static YVAR_WALK_RESULT count_strings(yvar_walk_frame_t * frame, void * data)
+ * {
+ *     if (yvar_like_string(*frame->yvar)) {
+ *         (*(ysize_t*)data)++;
+ *     }
+ *
+ *     return YVAR_WALK_CONTINUE;
+ * }
+ *
+ * ysize_t count = 0;
+ * yvar_walk(result, count_strings, NULL, &count);
+ * @endcode
+ *
+ * @return yfalse if a visitor returns YVAR_WALK_STOP.
+ */
+static inline __attribute__((always_inline)) ybool_t _yvar_walk_internal(const yvar_t * yvar, yvar_t * peer,
+    yvar_walk_func pre, yvar_walk_func post, void * data)
 {
-    YUKI_ASSERT(new_var);
+    yvar_walk_frame_t local_stack[YVAR_WALK_STACK_SIZE];
+    yvar_walk_frame_t * stack = local_stack;
+    yvar_walk_frame_t * frame;
+    ysize_t capacity = YVAR_WALK_STACK_SIZE;
+    ysize_t depth = 0;
+    ysize_t index = 0;
+    const yvar_t * element = yvar;
+    yvar_t * element_peer = peer;
+    ybool_t ret = ytrue;
+
+    for (;;) {
+        if (element) {
+            if (depth == capacity && !_yvar_walk_grow(&stack, local_stack, &capacity)) {
+                ret = yfalse;
+                break;
+            }
 
-    if (!buffer) {
-        YUKI_LOG_WARNING("out of memory");
-        return yfalse;
+            frame = stack + depth;
+            frame->yvar = element;
+            frame->peer = element_peer;
+            frame->index = index;
+            frame->depth = depth;
+
+            YVAR_WALK_RESULT result = pre? pre(frame, data): YVAR_WALK_CONTINUE;
+
+            if (YVAR_WALK_STOP == result) {
+                ret = yfalse;
+                break;
+            }
+
+            if (YVAR_WALK_CONTINUE == result) {
+                _yvar_walk_begin(frame);
+                depth++;
+            }
+        } else {
+            // all elements of the var on top are visited
+            if (post && YVAR_WALK_STOP == post(stack + depth - 1, data)) {
+                ret = yfalse;
+                break;
+            }
+
+            depth--;
+        }
+
+        if (!depth) {
+            break;
+        }
+
+        frame = stack + depth - 1;
+        index = frame->next;
+        element = _yvar_walk_next(frame, &element_peer);
+    }
+
+    if (stack != local_stack) {
+        free(stack);
     }
 
-    yvar_t * yvar = ybuffer_smart_alloc(buffer, yvar_t);
+    return ret;
+}
 
+ybool_t _yvar_walk(const yvar_t * yvar, yvar_t * peer, yvar_walk_func pre, yvar_walk_func post, void * data)
+{
     if (!yvar) {
-        YUKI_LOG_WARNING("out of memory");
+        YUKI_LOG_FATAL("invalid param");
         return yfalse;
     }
 
-    if (!_yvar_clone_internal_element(buffer, yvar, old_var)) {
-        YUKI_LOG_WARNING("fail to clone internal element");
-        return yfalse;
-    }
+    return _yvar_walk_internal(yvar, peer, pre, post, data);
+}
 
-    // buffer MUST be empty.
-    YUKI_ASSERT(!ybuffer_available_size(buffer));
+static const ysize_t _yvar_packed_element_sizes[YVAR_TYPE_MAX] = {
+    [YVAR_TYPE_BOOL] = sizeof(ybool_t),
+    [YVAR_TYPE_INT8] = sizeof(yint8_t),
+    [YVAR_TYPE_UINT8] = sizeof(yuint8_t),
+    [YVAR_TYPE_INT16] = sizeof(yint16_t),
+    [YVAR_TYPE_UINT16] = sizeof(yuint16_t),
+    [YVAR_TYPE_INT32] = sizeof(yint32_t),
+    [YVAR_TYPE_UINT32] = sizeof(yuint32_t),
+    [YVAR_TYPE_INT64] = sizeof(yint64_t),
+    [YVAR_TYPE_UINT64] = sizeof(yuint64_t),
+};
+
+ysize_t _yvar_packed_element_size(yuint8_t type)
+{
+    return type < YVAR_TYPE_MAX? _yvar_packed_element_sizes[type]: 0;
+}
 
-    YUKI_LOG_DEBUG("var is cloned");
-    yvar_set_option(*yvar, YVAR_OPTION_HOLD_RESOURCE);
-    *new_var = yvar;
-    return ytrue;
+static inline ysize_t _yvar_packed_data_size(const yvar_t * packed)
+{
+    return packed->data.ypacked_data.size * _yvar_packed_element_size(packed->data.ypacked_data.type);
 }
 
-static ybool_t _yvar_list_push_back_internal(ybuffer_t * buffer, yvar_t * list, const yvar_t * var, ybool_t need_clone)
+/**
+ * check whether a var owns memory outside itself.
+ * scalars, inline strings, interned strings and frozen vars are fully copied by memcpy.
+ */
+static inline ybool_t _yvar_need_deep_clone(const yvar_t * yvar)
 {
-    YUKI_ASSERT(buffer && list && var);
+    return yvar->type >= YVAR_TYPE_CSTR
+        && !(yvar->options & (YVAR_OPTION_INLINE | YVAR_OPTION_INTERNED | YVAR_OPTION_FROZEN));
+}
 
-    ylist_node_t * node = ybuffer_smart_alloc(buffer, ylist_node_t);
+/**
+ * check whether any var in an array owns memory outside itself.
+ * an array of scalars is not walked element by element.
+ */
+static inline ybool_t _yvar_array_need_deep_clone(const yvar_t * yvars, ysize_t size)
+{
+    ysize_t i;
 
-    if (!node) {
-        YUKI_LOG_WARNING("out of memory");
-        return yfalse;
+    for (i = 0; i < size; i++) {
+        if (_yvar_need_deep_clone(yvars + i)) {
+            return ytrue;
+        }
     }
 
-    if (need_clone) {
-        if (!_yvar_clone_internal_element(buffer, &node->yvar, var)) {
-            YUKI_LOG_WARNING("cannot clone value to node");
-            return yfalse;
-        }
-    } else {
-        yvar_memzero(node->yvar);
+    return yfalse;
+}
 
-        if (!yvar_assign(node->yvar, *var)) {
-            YUKI_LOG_WARNING("cannot assign new value to node");
-            return yfalse;
-        }
+static YVAR_WALK_RESULT _yvar_mem_size_visit(yvar_walk_frame_t * frame, void * data)
+{
+    const yvar_t * yvar = frame->yvar;
+    ysize_t * size = (ysize_t*)data;
+
+    // elements are counted in memory of their parent
+    if (!frame->depth) {
+        *size += ybuffer_round_up(sizeof(yvar_t));
     }
 
-    // if list is empty, change both head and tail.
-    if (!list->data.ylist_data.head) {
-        YUKI_ASSERT(!list->data.ylist_data.tail);
+    // frozen var is shared. only the var itself is copied.
+    if (yvar->options & YVAR_OPTION_FROZEN) {
+        return YVAR_WALK_SKIP;
+    }
 
-        list->data.ylist_data.head = node;
-        list->data.ylist_data.tail = node;
-        node->next = NULL;
-        node->prev = NULL;
-    } else {
-        YUKI_ASSERT(list->data.ylist_data.tail);
+    switch (yvar->type) {
+        case YVAR_TYPE_ARRAY:
+            *size += ybuffer_round_up(yvar->data.yarray_data.size * sizeof(yvar_t));
+            return _yvar_array_need_deep_clone(yvar->data.yarray_data.yvars, yvar->data.yarray_data.size)?
+                YVAR_WALK_CONTINUE: YVAR_WALK_SKIP;
+        case YVAR_TYPE_LIST:
+        {
+            // cloned list is stored in one node
+            ysize_t cnt = yvar_count(*yvar);
 
-        ylist_node_t * old_tail = list->data.ylist_data.tail;
-        old_tail->next = node;
-        node->prev = old_tail;
-        node->next = NULL;
-        list->data.ylist_data.tail = node;
+            if (cnt) {
+                *size += ybuffer_round_up(sizeof(ylist_node_t) + cnt * sizeof(yvar_t));
+            }
+
+            return YVAR_WALK_CONTINUE;
+        }
+        case YVAR_TYPE_MAP:
+            *size += _yvar_map_index_mem_size(yvar) + ybuffer_round_up(sizeof(yvar_t)) * 2;
+            return YVAR_WALK_CONTINUE;
+        case YVAR_TYPE_PACKED:
+            *size += ybuffer_round_up(_yvar_packed_data_size(yvar));
+            break;
+        case YVAR_TYPE_STR:
+        case YVAR_TYPE_CSTR:
+            // interned string is shared and short string is inline, neither is copied
+            if (!(yvar->options & (YVAR_OPTION_INTERNED | YVAR_OPTION_INLINE))
+                    && yvar_cstr_strlen(*yvar) > YVAR_INLINE_STR_MAX_SIZE) {
+                *size += ybuffer_round_up((yvar_cstr_strlen(*yvar)) + 1);
+            }
+
+            break;
     }
 
-    return ytrue;
+    return YVAR_WALK_SKIP;
 }
 
-ybool_t _yvar_get_bool(const yvar_t * yvar, ybool_t * output)
+/**
+ * count size of memory of a cloned var.
+ */
+static ysize_t _yvar_mem_size(const yvar_t * yvar)
 {
-    if (!yvar || !output) {
-        YUKI_LOG_FATAL("invalid param");
-        return yfalse;
+    YUKI_ASSERT(yvar);
+
+    ysize_t size = 0;
+
+    if (!_yvar_walk_internal(yvar, NULL, &_yvar_mem_size_visit, NULL, &size)) {
+        YUKI_LOG_WARNING("cannot count size of var");
     }
 
-    switch (yvar->type) {
-        case YVAR_TYPE_UNDEFINED:
-            *output = yfalse;
-            break;
+    return size;
+}
+
+/**
+ * allocate memory for cloned var.
+ */
+static inline void * _yvar_clone_alloc(yvar_clone_ctx_t * ctx, ysize_t size)
+{
+    ybuffer_t * buffer = ctx->buffer;
+    ysize_t rounded = ybuffer_round_up(size);
+
+    if (buffer && buffer->offset + rounded <= buffer->size) {
+        char * ret = buffer->buffer + buffer->offset;
+        buffer->offset += rounded;
+        return ret;
+    }
+
+    if (!ctx->next_size) {
+        YUKI_LOG_FATAL("not enough memory in clone buffer");
+        return NULL;
+    }
+
+    // big memory is allocated alone and current buffer keeps serving small ones
+    if (rounded > ctx->next_size / 2) {
+        return ybuffer_site_simple_alloc(rounded, YBUFFER_SITE_CLONE);
+    }
+
+    buffer = ybuffer_site_create(ctx->next_size > rounded? ctx->next_size: rounded, YBUFFER_SITE_CLONE);
+
+    if (!buffer) {
+        return NULL;
+    }
+
+    if (ctx->next_size < YVAR_CLONE_BUFFER_MAX_SIZE) {
+        ctx->next_size *= 2;
+    }
+
+    ctx->buffer = buffer;
+    buffer->offset = rounded;
+    return buffer->buffer;
+}
+
+/**
+ * copy all vars of a list into one node by memcpy.
+ * new list can be the same as old list.
+ */
+static ybool_t _yvar_list_copy(yvar_clone_ctx_t * ctx, yvar_t * new_list, const yvar_t * old_list)
+{
+    ysize_t size = yvar_count(*old_list);
+    ylist_node_t * node = NULL;
+
+    if (size) {
+        node = (ylist_node_t*)_yvar_clone_alloc(ctx, sizeof(ylist_node_t) + size * sizeof(yvar_t));
+
+        if (!node) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+
+        const ylist_node_t * old_node = old_list->data.ylist_data.head;
+        yvar_t * dest = node->yvars;
+
+        for (; old_node; old_node = old_node->next) {
+            memcpy(dest, old_node->yvars, old_node->size * sizeof(yvar_t));
+            dest += old_node->size;
+        }
+
+        node->prev = NULL;
+        node->next = NULL;
+        node->offset = 0;
+        node->size = size;
+        node->capacity = size;
+    }
+
+    new_list->data.ylist_data.head = node;
+    new_list->data.ylist_data.tail = node;
+    return ytrue;
+}
+
+/**
+ * copy elements of a packed array by memcpy.
+ * new packed array can be the same as old one.
+ */
+static ybool_t _yvar_packed_copy(yvar_clone_ctx_t * ctx, yvar_t * new_packed, const yvar_t * old_packed)
+{
+    ysize_t size = _yvar_packed_data_size(old_packed);
+    void * data = NULL;
+
+    if (size) {
+        data = _yvar_clone_alloc(ctx, size);
+
+        if (!data) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+
+        memcpy(data, old_packed->data.ypacked_data.data, size);
+    }
+
+    new_packed->data.ypacked_data.data = data;
+    return ytrue;
+}
+
+/**
+ * read an element to a scalar var. index must be valid.
+ */
+static void _yvar_packed_load(const yvar_t * packed, ysize_t index, yvar_t * output)
+{
+    const void * data = packed->data.ypacked_data.data;
+
+    switch (packed->data.ypacked_data.type) {
         case YVAR_TYPE_BOOL:
-            *output = yvar->data.ybool_data;
+            yvar_bool(*output, ((const ybool_t*)data)[index]);
             break;
         case YVAR_TYPE_INT8:
-            *output = yvar->data.yint8_data? ytrue: yfalse;
+            yvar_int8(*output, ((const yint8_t*)data)[index]);
             break;
         case YVAR_TYPE_UINT8:
-            *output = yvar->data.yuint8_data? ytrue: yfalse;
+            yvar_uint8(*output, ((const yuint8_t*)data)[index]);
             break;
         case YVAR_TYPE_INT16:
-            *output = yvar->data.yint16_data? ytrue: yfalse;
+            yvar_int16(*output, ((const yint16_t*)data)[index]);
             break;
         case YVAR_TYPE_UINT16:
-            *output = yvar->data.yuint16_data? ytrue: yfalse;
+            yvar_uint16(*output, ((const yuint16_t*)data)[index]);
             break;
         case YVAR_TYPE_INT32:
-            *output = yvar->data.yint32_data? ytrue: yfalse;
+            yvar_int32(*output, ((const yint32_t*)data)[index]);
             break;
         case YVAR_TYPE_UINT32:
-            *output = yvar->data.yuint32_data? ytrue: yfalse;
-            break;
-        case YVAR_TYPE_CSTR:
-            *output = yvar->data.ycstr_data.size? ytrue: yfalse;
-            break;
-        case YVAR_TYPE_STR:
-            *output = yvar->data.ystr_data.size? ytrue: yfalse;
+            yvar_uint32(*output, ((const yuint32_t*)data)[index]);
             break;
-        case YVAR_TYPE_ARRAY:
-            *output = yvar->data.yarray_data.size? ytrue: yfalse;
+        case YVAR_TYPE_INT64:
+            yvar_int64(*output, ((const yint64_t*)data)[index]);
             break;
-        case YVAR_TYPE_LIST:
-            *output = yvar->data.ylist_data.head? ytrue: yfalse;
-            YUKI_ASSERT(*output || !yvar->data.ylist_data.tail);
+        case YVAR_TYPE_UINT64:
+            yvar_uint64(*output, ((const yuint64_t*)data)[index]);
             break;
-        case YVAR_TYPE_MAP:
-            *output = yvar->data.ymap_data.keys? ytrue: yfalse;
-            YUKI_ASSERT(*output || !yvar->data.ymap_data.values);
+        default:
+            YUKI_LOG_FATAL("invalid packed element type. [type: %d]", packed->data.ypacked_data.type);
+            yvar_undefined(*output);
             break;
+    }
+}
+
+/**
+ * a packed element of any type.
+ */
+typedef union _yvar_packed_element_t {
+    yint8_t int8;
+    yuint8_t uint8;
+    yint16_t int16;
+    yuint16_t uint16;
+    yint32_t int32;
+    yuint32_t uint32;
+    yint64_t int64;
+    yuint64_t uint64;
+} yvar_packed_element_t;
+
+/**
+ * convert a var to element type and write it to element.
+ * fail if value is out of range of element type.
+ */
+static ybool_t _yvar_packed_store(yuint8_t type, void * element, const yvar_t * value)
+{
+    switch (type) {
+        case YVAR_TYPE_BOOL:
+            return _yvar_get_bool(value, (ybool_t*)element);
+        case YVAR_TYPE_INT8:
+            return _yvar_get_int8(value, (yint8_t*)element);
+        case YVAR_TYPE_UINT8:
+            return _yvar_get_uint8(value, (yuint8_t*)element);
+        case YVAR_TYPE_INT16:
+            return _yvar_get_int16(value, (yint16_t*)element);
+        case YVAR_TYPE_UINT16:
+            return _yvar_get_uint16(value, (yuint16_t*)element);
+        case YVAR_TYPE_INT32:
+            return _yvar_get_int32(value, (yint32_t*)element);
+        case YVAR_TYPE_UINT32:
+            return _yvar_get_uint32(value, (yuint32_t*)element);
+        case YVAR_TYPE_INT64:
+            return _yvar_get_int64(value, (yint64_t*)element);
+        case YVAR_TYPE_UINT64:
+            return _yvar_get_uint64(value, (yuint64_t*)element);
         default:
-            YUKI_LOG_FATAL("impossible type value %d", yvar->type);
+            YUKI_LOG_FATAL("invalid packed element type. [type: %d]", type);
             return yfalse;
     }
-    
-    return ytrue;
 }
 
-ybool_t _yvar_get_int8(const yvar_t * yvar, yint8_t * output)
+/**
+ * allocate keys var and `value_count` values vars of a cloned map.
+ * layout is [slots][index][keys][values]. index must be right before keys var.
+ * it's built after keys are cloned. more than one values var can share the keys and index.
+ */
+static yvar_t * _yvar_map_block_alloc(yvar_clone_ctx_t * ctx, const yvar_t * old_map, ysize_t value_count)
 {
-    if (!yvar || !output) {
-        YUKI_LOG_FATAL("invalid param");
-        return yfalse;
+    ysize_t index_size = _yvar_map_index_mem_size(old_map);
+    char * block = (char*)_yvar_clone_alloc(ctx,
+        index_size + ybuffer_round_up(sizeof(yvar_t)) + value_count * sizeof(yvar_t));
+
+    if (!block) {
+        return NULL;
     }
 
-    switch (yvar->type) {
-        case YVAR_TYPE_UNDEFINED:
-            YUKI_LOG_DEBUG("undefined cannot be converted to int8");
-            return yfalse;
-        case YVAR_TYPE_BOOL:
-            *output = yvar->data.ybool_data;
-            break;
-        case YVAR_TYPE_INT8:
-            *output = yvar->data.yint8_data;
-            break;
-        case YVAR_TYPE_UINT8:
-            if (yvar->data.yuint8_data > YUKI_MAX_INT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
-                return yfalse;
+    yvar_t * keys = (yvar_t*)(block + index_size);
+
+    if (index_size) {
+        yvar_map_index_t * index = (yvar_map_index_t*)((char*)keys - ybuffer_round_up(sizeof(yvar_map_index_t)));
+        index->count = yvar_count(*old_map->data.ymap_data.keys);
+        index->capacity = _yvar_map_index_capacity(index->count);
+    }
+
+    return keys;
+}
+
+static inline yvar_t * _yvar_map_block_values(yvar_t * keys)
+{
+    return (yvar_t*)((char*)keys + ybuffer_round_up(sizeof(yvar_t)));
+}
+
+/**
+ * clone a var to its peer. elements of array, list and map are copied by their parent in one go.
+ * only the ones owning memory are visited again.
+ */
+static YVAR_WALK_RESULT _yvar_clone_visit(yvar_walk_frame_t * frame, void * data)
+{
+    yvar_clone_ctx_t * ctx = (yvar_clone_ctx_t*)data;
+    const yvar_t * old_var = frame->yvar;
+    yvar_t * new_var = frame->peer;
+
+    YUKI_ASSERT(new_var);
+
+    if (!frame->depth) {
+        *new_var = *old_var;
+    }
+
+    // frozen var never changes. new var shares everything it references.
+    if (!_yvar_need_deep_clone(old_var)) {
+        return YVAR_WALK_SKIP;
+    }
+
+    switch (old_var->type) {
+        case YVAR_TYPE_ARRAY:
+        {
+            ysize_t size = old_var->data.yarray_data.size;
+            yvar_t * yvars = (yvar_t*)_yvar_clone_alloc(ctx, size * sizeof(yvar_t));
+            new_var->options &= ~YVAR_OPTION_GROWABLE;
+
+            if (!yvars) {
+                YUKI_LOG_WARNING("out of memory");
+                return YVAR_WALK_STOP;
             }
 
-            *output = (yint8_t)yvar->data.yuint8_data;
-            break;
-        case YVAR_TYPE_INT16:
-            if (yvar->data.yint16_data > YUKI_MAX_INT8_VALUE || yvar->data.yint16_data < YUKI_MIN_INT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
-                return yfalse;
+            if (size) {
+                memcpy(yvars, old_var->data.yarray_data.yvars, size * sizeof(yvar_t));
             }
 
-            *output = (yint8_t)yvar->data.yint16_data;
-            break;
-        case YVAR_TYPE_UINT16:
-            if (yvar->data.yuint16_data > YUKI_MAX_INT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
-                return yfalse;
+            new_var->data.yarray_data.yvars = yvars;
+            return _yvar_array_need_deep_clone(yvars, size)? YVAR_WALK_CONTINUE: YVAR_WALK_SKIP;
+        }
+        case YVAR_TYPE_LIST:
+            if (!_yvar_list_copy(ctx, new_var, old_var)) {
+                YUKI_LOG_WARNING("cannot copy list");
+                return YVAR_WALK_STOP;
             }
 
-            *output = (yint8_t)yvar->data.yuint16_data;
-            break;
-        case YVAR_TYPE_INT32:
-            if (yvar->data.yint32_data > YUKI_MAX_INT8_VALUE || yvar->data.yint32_data < YUKI_MIN_INT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
-                return yfalse;
+            return YVAR_WALK_CONTINUE;
+        case YVAR_TYPE_MAP:
+        {
+            yvar_t * keys = _yvar_map_block_alloc(ctx, old_var, 1);
+
+            if (!keys) {
+                YUKI_LOG_WARNING("out of memory");
+                return YVAR_WALK_STOP;
             }
 
-            *output = (yint8_t)yvar->data.yint32_data;
-            break;
-        case YVAR_TYPE_UINT32:
-            if (yvar->data.yuint32_data > YUKI_MAX_INT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
-                return yfalse;
+            yvar_t * values = _yvar_map_block_values(keys);
+            *keys = *old_var->data.ymap_data.keys;
+            *values = *old_var->data.ymap_data.values;
+            new_var->data.ymap_data.keys = keys;
+            new_var->data.ymap_data.values = values;
+            new_var->options &= ~YVAR_OPTION_INDEXED;
+            return YVAR_WALK_CONTINUE;
+        }
+        case YVAR_TYPE_PACKED:
+            if (!_yvar_packed_copy(ctx, new_var, old_var)) {
+                YUKI_LOG_WARNING("cannot copy packed array");
+                return YVAR_WALK_STOP;
             }
 
-            *output = (yint8_t)yvar->data.yuint32_data;
             break;
-        case YVAR_TYPE_INT64:
-            if (yvar->data.yint64_data > YUKI_MAX_INT8_VALUE || yvar->data.yint64_data < YUKI_MIN_INT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
-                return yfalse;
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+        {
+            // the len includes '\0'
+            ysize_t len = yvar_cstr_strlen(*old_var) + 1;
+            const char * src = yvar_cstr_buffer(*old_var);
+
+            // cache hash for fast equal and map index.
+            // str bytes can be changed by yvar_str_buffer(), so its hash is never cached.
+            if (YVAR_TYPE_STR == old_var->type) {
+                new_var->options &= ~YVAR_OPTION_HASHED;
+            } else if (!(new_var->options & YVAR_OPTION_HASHED)) {
+                new_var->hash = _yvar_hash_bytes(src, len - 1);
+                new_var->options |= YVAR_OPTION_HASHED;
             }
 
-            *output = (yint8_t)yvar->data.yint64_data;
-            break;
-        case YVAR_TYPE_UINT64:
-            if (yvar->data.yuint64_data > YUKI_MAX_INT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
-                return yfalse;
+            if (len <= YVAR_INLINE_STR_MAX_SIZE + 1) {
+                if (len > 1) {
+                    memcpy(new_var->data.yinline_data.str, src, len - 1);
+                }
+
+                new_var->data.yinline_data.str[len - 1] = '\0';
+                new_var->data.yinline_data.size = (yuint8_t)(len - 1);
+                new_var->options |= YVAR_OPTION_INLINE;
+                break;
             }
 
-            *output = (yint8_t)yvar->data.yuint64_data;
+            char * dest = (char *)_yvar_clone_alloc(ctx, len);
+
+            if (!dest) {
+                YUKI_LOG_WARNING("out of memory");
+                return YVAR_WALK_STOP;
+            }
+
+            memcpy(dest, src, len - 1);
+            dest[len - 1] = '\0';
+            new_var->data.ystr_data.str = dest;
             break;
-        case YVAR_TYPE_CSTR:
-            YUKI_LOG_DEBUG("cstr cannot be converted to int8");
-            return yfalse;
-        case YVAR_TYPE_STR:
-            YUKI_LOG_DEBUG("str cannot be converted to int8");
-            return yfalse;
-        case YVAR_TYPE_ARRAY:
-            YUKI_LOG_DEBUG("array cannot be converted to int8");
-            return yfalse;
-        case YVAR_TYPE_LIST:
-            YUKI_LOG_DEBUG("list cannot be converted to int8");
-            return yfalse;
-        case YVAR_TYPE_MAP:
-            YUKI_LOG_DEBUG("map cannot be converted to int8");
-            return yfalse;
-        default:
-            YUKI_LOG_FATAL("impossible type value %d", yvar->type);
-            return yfalse;
+        }
     }
-    
-    return ytrue;
+
+    return YVAR_WALK_SKIP;
 }
 
-ybool_t _yvar_get_uint8(const yvar_t * yvar, yuint8_t * output)
+/**
+ * build index of a cloned map after its keys are cloned.
+ */
+static YVAR_WALK_RESULT _yvar_clone_leave(yvar_walk_frame_t * frame, void * data)
 {
-    if (!yvar || !output) {
-        YUKI_LOG_FATAL("invalid param");
-        return yfalse;
+    yvar_t * new_var = frame->peer;
+    (void)data;
+
+    if (yvar_is_map(*new_var) && _yvar_map_index_mem_size(frame->yvar)) {
+        _yvar_map_index_build(_yvar_map_index(new_var), new_var->data.ymap_data.keys);
+        new_var->options |= YVAR_OPTION_INDEXED;
     }
 
-    switch (yvar->type) {
-        case YVAR_TYPE_UNDEFINED:
-            YUKI_LOG_DEBUG("undefined cannot be converted to uint8");
-            return yfalse;
-        case YVAR_TYPE_BOOL:
-            *output = (yuint8_t)yvar->data.ybool_data;
-            break;
-        case YVAR_TYPE_INT8:
-            if (yvar->data.yint8_data < YUKI_MIN_UINT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
-                return yfalse;
-            }
+    return YVAR_WALK_CONTINUE;
+}
 
-            *output = (yuint8_t)yvar->data.yint8_data;
-            break;
-        case YVAR_TYPE_UINT8:
-            *output = yvar->data.yuint8_data;
-            break;
-        case YVAR_TYPE_INT16:
-            if (yvar->data.yint16_data > YUKI_MAX_UINT8_VALUE || yvar->data.yint16_data < YUKI_MIN_UINT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
-                return yfalse;
-            }
+/**
+ * clone internal elements of a var in a given ctx.
+ */
+static ybool_t _yvar_clone_internal_element(yvar_clone_ctx_t * ctx, yvar_t * new_var, const yvar_t * old_var)
+{
+    YUKI_ASSERT(new_var && old_var);
 
-            *output = (yuint8_t)yvar->data.yint16_data;
-            break;
-        case YVAR_TYPE_UINT16:
-            if (yvar->data.yuint16_data > YUKI_MAX_UINT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
+    if (!_yvar_walk_internal(old_var, new_var, &_yvar_clone_visit, &_yvar_clone_leave, ctx)) {
+        YUKI_LOG_WARNING("fail to clone internal buffer");
+        return yfalse;
+    }
+
+    return ytrue;
+}
+
+typedef struct _yvar_map_kv_ref_t {
+    const yvar_t * pair;
+    ysize_t index;
+} yvar_map_kv_ref_t;
+
+static int _yvar_map_kv_ref_compare(const void * lhs, const void * rhs)
+{
+    const yvar_map_kv_ref_t * lhs_ref = (const yvar_map_kv_ref_t*)lhs;
+    const yvar_map_kv_ref_t * rhs_ref = (const yvar_map_kv_ref_t*)rhs;
+    int ret = _yvar_compare(lhs_ref->pair, rhs_ref->pair);
+
+    // keep original order of equal keys so that the first one wins
+    if (!ret) {
+        ret = lhs_ref->index < rhs_ref->index? -1: 1;
+    }
+
+    return ret;
+}
+
+/**
+ * split key-value pairs into keys and values sorted by key.
+ */
+static ybool_t _yvar_map_assoc_array_sort(yvar_map_kv_t src, ysize_t src_size,
+    yvar_t even_dst[], ysize_t even_size,
+    yvar_t odd_dst[], ysize_t odd_size)
+{
+    YUKI_ASSERT(src && even_dst && odd_dst);
+    YUKI_ASSERT(src_size == odd_size);
+    YUKI_ASSERT(src_size == even_size);
+
+    yvar_map_kv_ref_t refs[src_size];
+    ysize_t index = 0;
+
+    for (; index < src_size; index++) {
+        refs[index].pair = src[index];
+        refs[index].index = index;
+    }
+
+    qsort(refs, src_size, sizeof(refs[0]), &_yvar_map_kv_ref_compare);
+
+    // copy odd value to odd array, even to even array
+    for (index = 0; index < src_size; index++) {
+        // NOTE: don't use yvar_assign, as dst is not initialized.
+        even_dst[index] = refs[index].pair[0];
+        odd_dst[index] = refs[index].pair[1];
+    }
+
+    return ytrue;
+}
+
+/**
+ * clone a var in a given ctx.
+ */
+static ybool_t _yvar_clone_internal(yvar_clone_ctx_t * ctx, yvar_t ** new_var, const yvar_t * old_var)
+{
+    YUKI_ASSERT(new_var);
+
+    yvar_t * yvar = (yvar_t*)_yvar_clone_alloc(ctx, sizeof(yvar_t));
+
+    if (!yvar) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    if (!_yvar_clone_internal_element(ctx, yvar, old_var)) {
+        YUKI_LOG_WARNING("fail to clone internal element");
+        return yfalse;
+    }
+
+    // fixed-size buffer MUST be empty.
+    YUKI_ASSERT(ctx->next_size || !ybuffer_available_size(ctx->buffer));
+
+    YUKI_LOG_DEBUG("var is cloned");
+    yvar_set_option(*yvar, YVAR_OPTION_HOLD_RESOURCE);
+    *new_var = yvar;
+    return ytrue;
+}
+
+/**
+ * copy-on-write of a frozen array or list before it's modified.
+ * only the elements or nodes of the var itself are copied. its elements are still shared.
+ */
+static ybool_t _yvar_thaw(yvar_t * yvar)
+{
+    YUKI_ASSERT(yvar && (yvar->options & YVAR_OPTION_FROZEN));
+
+    yvar_clone_ctx_t ctx = {NULL, YVAR_CLONE_BUFFER_MIN_SIZE};
+
+    switch (yvar->type) {
+        case YVAR_TYPE_ARRAY:
+        {
+            ysize_t size = yvar->data.yarray_data.size;
+            yvar_t * yvars = (yvar_t*)_yvar_clone_alloc(&ctx, size * sizeof(yvar_t));
+
+            if (!yvars) {
+                YUKI_LOG_WARNING("out of memory");
                 return yfalse;
             }
 
-            *output = (yuint8_t)yvar->data.yuint16_data;
-            break;
-        case YVAR_TYPE_INT32:
-            if (yvar->data.yint32_data > YUKI_MAX_UINT8_VALUE || yvar->data.yint32_data < YUKI_MIN_UINT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
-                return yfalse;
+            if (size) {
+                memcpy(yvars, yvar->data.yarray_data.yvars, size * sizeof(yvar_t));
             }
 
-            *output = (yuint8_t)yvar->data.yint32_data;
+            yvar->data.yarray_data.yvars = yvars;
+            yvar->options &= ~YVAR_OPTION_GROWABLE;
             break;
-        case YVAR_TYPE_UINT32:
-            if (yvar->data.yuint32_data > YUKI_MAX_UINT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
+        }
+        case YVAR_TYPE_LIST:
+            if (!_yvar_list_copy(&ctx, yvar, yvar)) {
+                YUKI_LOG_WARNING("cannot copy list");
                 return yfalse;
             }
 
-            *output = (yuint8_t)yvar->data.yuint32_data;
             break;
-        case YVAR_TYPE_INT64:
-            if (yvar->data.yint64_data > YUKI_MAX_UINT8_VALUE || yvar->data.yint64_data < YUKI_MIN_UINT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
+        case YVAR_TYPE_PACKED:
+            if (!_yvar_packed_copy(&ctx, yvar, yvar)) {
+                YUKI_LOG_WARNING("cannot copy packed array");
                 return yfalse;
             }
 
-            *output = (yuint8_t)yvar->data.yint64_data;
             break;
-        case YVAR_TYPE_UINT64:
-            if (yvar->data.yuint64_data > YUKI_MAX_UINT8_VALUE) {
-                YUKI_LOG_DEBUG("value is overflow");
-                return yfalse;
-            }
+    }
 
-            *output = (yuint8_t)yvar->data.yuint64_data;
+    yvar->options &= ~YVAR_OPTION_FROZEN;
+    return ytrue;
+}
+
+ybool_t _yvar_get_bool(const yvar_t * yvar, ybool_t * output)
+{
+    if (!yvar || !output) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    switch (yvar->type) {
+        case YVAR_TYPE_UNDEFINED:
+            *output = yfalse;
+            break;
+        case YVAR_TYPE_BOOL:
+            *output = yvar->data.ybool_data;
+            break;
+        case YVAR_TYPE_INT8:
+            *output = yvar->data.yint8_data? ytrue: yfalse;
+            break;
+        case YVAR_TYPE_UINT8:
+            *output = yvar->data.yuint8_data? ytrue: yfalse;
+            break;
+        case YVAR_TYPE_INT16:
+            *output = yvar->data.yint16_data? ytrue: yfalse;
+            break;
+        case YVAR_TYPE_UINT16:
+            *output = yvar->data.yuint16_data? ytrue: yfalse;
+            break;
+        case YVAR_TYPE_INT32:
+            *output = yvar->data.yint32_data? ytrue: yfalse;
+            break;
+        case YVAR_TYPE_UINT32:
+            *output = yvar->data.yuint32_data? ytrue: yfalse;
             break;
         case YVAR_TYPE_CSTR:
-            YUKI_LOG_DEBUG("cstr cannot be converted to uint8");
-            return yfalse;
         case YVAR_TYPE_STR:
-            YUKI_LOG_DEBUG("str cannot be converted to uint8");
-            return yfalse;
+            *output = _yvar_str_size(yvar)? ytrue: yfalse;
+            break;
         case YVAR_TYPE_ARRAY:
-            YUKI_LOG_DEBUG("array cannot be converted to uint8");
-            return yfalse;
+            *output = yvar->data.yarray_data.size? ytrue: yfalse;
+            break;
         case YVAR_TYPE_LIST:
-            YUKI_LOG_DEBUG("list cannot be converted to uint8");
-            return yfalse;
+            *output = yvar->data.ylist_data.head? ytrue: yfalse;
+            YUKI_ASSERT(*output || !yvar->data.ylist_data.tail);
+            break;
         case YVAR_TYPE_MAP:
-            YUKI_LOG_DEBUG("map cannot be converted to uint8");
-            return yfalse;
+            *output = yvar->data.ymap_data.keys? ytrue: yfalse;
+            YUKI_ASSERT(*output || !yvar->data.ymap_data.values);
+            break;
+        case YVAR_TYPE_PACKED:
+            *output = yvar->data.ypacked_data.size? ytrue: yfalse;
+            break;
         default:
             YUKI_LOG_FATAL("impossible type value %d", yvar->type);
             return yfalse;
@@ -571,7 +1146,7 @@ ybool_t _yvar_get_uint8(const yvar_t * yvar, yuint8_t * output)
     return ytrue;
 }
 
-ybool_t _yvar_get_int16(const yvar_t * yvar, yint16_t * output)
+ybool_t _yvar_get_int8(const yvar_t * yvar, yint8_t * output)
 {
     if (!yvar || !output) {
         YUKI_LOG_FATAL("invalid param");
@@ -580,7 +1155,7 @@ ybool_t _yvar_get_int16(const yvar_t * yvar, yint16_t * output)
 
     switch (yvar->type) {
         case YVAR_TYPE_UNDEFINED:
-            YUKI_LOG_DEBUG("undefined cannot be converted to int16");
+            YUKI_LOG_DEBUG("undefined cannot be converted to int8");
             return yfalse;
         case YVAR_TYPE_BOOL:
             *output = yvar->data.ybool_data;
@@ -589,65 +1164,78 @@ ybool_t _yvar_get_int16(const yvar_t * yvar, yint16_t * output)
             *output = yvar->data.yint8_data;
             break;
         case YVAR_TYPE_UINT8:
-            *output = (yint16_t)yvar->data.yuint8_data;
+            if (yvar->data.yuint8_data > YUKI_MAX_INT8_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yint8_t)yvar->data.yuint8_data;
             break;
         case YVAR_TYPE_INT16:
-            *output = yvar->data.yint16_data;
+            if (yvar->data.yint16_data > YUKI_MAX_INT8_VALUE || yvar->data.yint16_data < YUKI_MIN_INT8_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yint8_t)yvar->data.yint16_data;
             break;
         case YVAR_TYPE_UINT16:
-            if (yvar->data.yuint16_data > YUKI_MAX_INT16_VALUE) {
+            if (yvar->data.yuint16_data > YUKI_MAX_INT8_VALUE) {
                 YUKI_LOG_DEBUG("value is overflow");
                 return yfalse;
             }
 
-            *output = (yint16_t)yvar->data.yuint16_data;
+            *output = (yint8_t)yvar->data.yuint16_data;
             break;
         case YVAR_TYPE_INT32:
-            if (yvar->data.yint32_data > YUKI_MAX_INT16_VALUE || yvar->data.yint32_data < YUKI_MIN_INT16_VALUE) {
+            if (yvar->data.yint32_data > YUKI_MAX_INT8_VALUE || yvar->data.yint32_data < YUKI_MIN_INT8_VALUE) {
                 YUKI_LOG_DEBUG("value is overflow");
                 return yfalse;
             }
 
-            *output = (yint16_t)yvar->data.yint32_data;
+            *output = (yint8_t)yvar->data.yint32_data;
             break;
         case YVAR_TYPE_UINT32:
-            if (yvar->data.yuint32_data > YUKI_MAX_INT16_VALUE) {
+            if (yvar->data.yuint32_data > YUKI_MAX_INT8_VALUE) {
                 YUKI_LOG_DEBUG("value is overflow");
                 return yfalse;
             }
 
-            *output = (yint16_t)yvar->data.yuint32_data;
+            *output = (yint8_t)yvar->data.yuint32_data;
             break;
         case YVAR_TYPE_INT64:
-            if (yvar->data.yint64_data > YUKI_MAX_INT16_VALUE || yvar->data.yint64_data < YUKI_MIN_INT16_VALUE) {
+            if (yvar->data.yint64_data > YUKI_MAX_INT8_VALUE || yvar->data.yint64_data < YUKI_MIN_INT8_VALUE) {
                 YUKI_LOG_DEBUG("value is overflow");
                 return yfalse;
             }
 
-            *output = (yint16_t)yvar->data.yint64_data;
+            *output = (yint8_t)yvar->data.yint64_data;
             break;
         case YVAR_TYPE_UINT64:
-            if (yvar->data.yuint64_data > YUKI_MAX_INT16_VALUE) {
+            if (yvar->data.yuint64_data > YUKI_MAX_INT8_VALUE) {
                 YUKI_LOG_DEBUG("value is overflow");
                 return yfalse;
             }
 
-            *output = (yint16_t)yvar->data.yuint64_data;
+            *output = (yint8_t)yvar->data.yuint64_data;
             break;
         case YVAR_TYPE_CSTR:
-            YUKI_LOG_DEBUG("cstr cannot be converted to int16");
+            YUKI_LOG_DEBUG("cstr cannot be converted to int8");
             return yfalse;
         case YVAR_TYPE_STR:
-            YUKI_LOG_DEBUG("str cannot be converted to int16");
+            YUKI_LOG_DEBUG("str cannot be converted to int8");
             return yfalse;
         case YVAR_TYPE_ARRAY:
-            YUKI_LOG_DEBUG("array cannot be converted to int16");
+            YUKI_LOG_DEBUG("array cannot be converted to int8");
             return yfalse;
         case YVAR_TYPE_LIST:
-            YUKI_LOG_DEBUG("list cannot be converted to int16");
+            YUKI_LOG_DEBUG("list cannot be converted to int8");
             return yfalse;
         case YVAR_TYPE_MAP:
-            YUKI_LOG_DEBUG("map cannot be converted to int16");
+            YUKI_LOG_DEBUG("map cannot be converted to int8");
+            return yfalse;
+        case YVAR_TYPE_PACKED:
+            YUKI_LOG_DEBUG("packed array cannot be converted to int8");
             return yfalse;
         default:
             YUKI_LOG_FATAL("impossible type value %d", yvar->type);
@@ -657,7 +1245,7 @@ ybool_t _yvar_get_int16(const yvar_t * yvar, yint16_t * output)
     return ytrue;
 }
 
-ybool_t _yvar_get_uint16(const yvar_t * yvar, yuint16_t * output)
+ybool_t _yvar_get_uint8(const yvar_t * yvar, yuint8_t * output)
 {
     if (!yvar || !output) {
         YUKI_LOG_FATAL("invalid param");
@@ -666,70 +1254,258 @@ ybool_t _yvar_get_uint16(const yvar_t * yvar, yuint16_t * output)
 
     switch (yvar->type) {
         case YVAR_TYPE_UNDEFINED:
-            YUKI_LOG_DEBUG("undefined cannot be converted to uint16");
+            YUKI_LOG_DEBUG("undefined cannot be converted to uint8");
             return yfalse;
         case YVAR_TYPE_BOOL:
-            *output = yvar->data.ybool_data;
+            *output = (yuint8_t)yvar->data.ybool_data;
             break;
         case YVAR_TYPE_INT8:
-            if (yvar->data.yint8_data < YUKI_MIN_UINT16_VALUE) {
+            if (yvar->data.yint8_data < YUKI_MIN_UINT8_VALUE) {
                 YUKI_LOG_DEBUG("value is overflow");
                 return yfalse;
             }
 
-            *output = yvar->data.yint8_data;
+            *output = (yuint8_t)yvar->data.yint8_data;
             break;
         case YVAR_TYPE_UINT8:
             *output = yvar->data.yuint8_data;
             break;
         case YVAR_TYPE_INT16:
-            if (yvar->data.yint16_data < YUKI_MIN_UINT16_VALUE) {
+            if (yvar->data.yint16_data > YUKI_MAX_UINT8_VALUE || yvar->data.yint16_data < YUKI_MIN_UINT8_VALUE) {
                 YUKI_LOG_DEBUG("value is overflow");
                 return yfalse;
             }
 
-            *output = (yuint16_t)yvar->data.yint16_data;
+            *output = (yuint8_t)yvar->data.yint16_data;
             break;
         case YVAR_TYPE_UINT16:
-            *output = yvar->data.yuint16_data;
+            if (yvar->data.yuint16_data > YUKI_MAX_UINT8_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yuint8_t)yvar->data.yuint16_data;
             break;
         case YVAR_TYPE_INT32:
-            if (yvar->data.yint32_data > YUKI_MAX_UINT16_VALUE || yvar->data.yint32_data < YUKI_MIN_UINT16_VALUE) {
+            if (yvar->data.yint32_data > YUKI_MAX_UINT8_VALUE || yvar->data.yint32_data < YUKI_MIN_UINT8_VALUE) {
                 YUKI_LOG_DEBUG("value is overflow");
                 return yfalse;
             }
 
-            *output = (yuint16_t)yvar->data.yint32_data;
+            *output = (yuint8_t)yvar->data.yint32_data;
             break;
         case YVAR_TYPE_UINT32:
-            if (yvar->data.yuint32_data > YUKI_MAX_UINT16_VALUE) {
+            if (yvar->data.yuint32_data > YUKI_MAX_UINT8_VALUE) {
                 YUKI_LOG_DEBUG("value is overflow");
                 return yfalse;
             }
 
-            *output = (yuint16_t)yvar->data.yuint32_data;
+            *output = (yuint8_t)yvar->data.yuint32_data;
             break;
         case YVAR_TYPE_INT64:
-            if (yvar->data.yint64_data > YUKI_MAX_UINT16_VALUE || yvar->data.yint64_data < YUKI_MIN_UINT16_VALUE) {
+            if (yvar->data.yint64_data > YUKI_MAX_UINT8_VALUE || yvar->data.yint64_data < YUKI_MIN_UINT8_VALUE) {
                 YUKI_LOG_DEBUG("value is overflow");
                 return yfalse;
             }
 
-            *output = (yuint16_t)yvar->data.yint64_data;
+            *output = (yuint8_t)yvar->data.yint64_data;
             break;
         case YVAR_TYPE_UINT64:
-            if (yvar->data.yuint64_data > YUKI_MAX_UINT16_VALUE) {
+            if (yvar->data.yuint64_data > YUKI_MAX_UINT8_VALUE) {
                 YUKI_LOG_DEBUG("value is overflow");
                 return yfalse;
             }
 
-            *output = (yuint16_t)yvar->data.yuint64_data;
+            *output = (yuint8_t)yvar->data.yuint64_data;
             break;
         case YVAR_TYPE_CSTR:
-            YUKI_LOG_DEBUG("cstr cannot be converted to uint16");
+            YUKI_LOG_DEBUG("cstr cannot be converted to uint8");
             return yfalse;
         case YVAR_TYPE_STR:
-            YUKI_LOG_DEBUG("str cannot be converted to uint16");
+            YUKI_LOG_DEBUG("str cannot be converted to uint8");
+            return yfalse;
+        case YVAR_TYPE_ARRAY:
+            YUKI_LOG_DEBUG("array cannot be converted to uint8");
+            return yfalse;
+        case YVAR_TYPE_LIST:
+            YUKI_LOG_DEBUG("list cannot be converted to uint8");
+            return yfalse;
+        case YVAR_TYPE_MAP:
+            YUKI_LOG_DEBUG("map cannot be converted to uint8");
+            return yfalse;
+        case YVAR_TYPE_PACKED:
+            YUKI_LOG_DEBUG("packed array cannot be converted to uint8");
+            return yfalse;
+        default:
+            YUKI_LOG_FATAL("impossible type value %d", yvar->type);
+            return yfalse;
+    }
+    
+    return ytrue;
+}
+
+ybool_t _yvar_get_int16(const yvar_t * yvar, yint16_t * output)
+{
+    if (!yvar || !output) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    switch (yvar->type) {
+        case YVAR_TYPE_UNDEFINED:
+            YUKI_LOG_DEBUG("undefined cannot be converted to int16");
+            return yfalse;
+        case YVAR_TYPE_BOOL:
+            *output = yvar->data.ybool_data;
+            break;
+        case YVAR_TYPE_INT8:
+            *output = yvar->data.yint8_data;
+            break;
+        case YVAR_TYPE_UINT8:
+            *output = (yint16_t)yvar->data.yuint8_data;
+            break;
+        case YVAR_TYPE_INT16:
+            *output = yvar->data.yint16_data;
+            break;
+        case YVAR_TYPE_UINT16:
+            if (yvar->data.yuint16_data > YUKI_MAX_INT16_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yint16_t)yvar->data.yuint16_data;
+            break;
+        case YVAR_TYPE_INT32:
+            if (yvar->data.yint32_data > YUKI_MAX_INT16_VALUE || yvar->data.yint32_data < YUKI_MIN_INT16_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yint16_t)yvar->data.yint32_data;
+            break;
+        case YVAR_TYPE_UINT32:
+            if (yvar->data.yuint32_data > YUKI_MAX_INT16_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yint16_t)yvar->data.yuint32_data;
+            break;
+        case YVAR_TYPE_INT64:
+            if (yvar->data.yint64_data > YUKI_MAX_INT16_VALUE || yvar->data.yint64_data < YUKI_MIN_INT16_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yint16_t)yvar->data.yint64_data;
+            break;
+        case YVAR_TYPE_UINT64:
+            if (yvar->data.yuint64_data > YUKI_MAX_INT16_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yint16_t)yvar->data.yuint64_data;
+            break;
+        case YVAR_TYPE_CSTR:
+            YUKI_LOG_DEBUG("cstr cannot be converted to int16");
+            return yfalse;
+        case YVAR_TYPE_STR:
+            YUKI_LOG_DEBUG("str cannot be converted to int16");
+            return yfalse;
+        case YVAR_TYPE_ARRAY:
+            YUKI_LOG_DEBUG("array cannot be converted to int16");
+            return yfalse;
+        case YVAR_TYPE_LIST:
+            YUKI_LOG_DEBUG("list cannot be converted to int16");
+            return yfalse;
+        case YVAR_TYPE_MAP:
+            YUKI_LOG_DEBUG("map cannot be converted to int16");
+            return yfalse;
+        case YVAR_TYPE_PACKED:
+            YUKI_LOG_DEBUG("packed array cannot be converted to int16");
+            return yfalse;
+        default:
+            YUKI_LOG_FATAL("impossible type value %d", yvar->type);
+            return yfalse;
+    }
+    
+    return ytrue;
+}
+
+ybool_t _yvar_get_uint16(const yvar_t * yvar, yuint16_t * output)
+{
+    if (!yvar || !output) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    switch (yvar->type) {
+        case YVAR_TYPE_UNDEFINED:
+            YUKI_LOG_DEBUG("undefined cannot be converted to uint16");
+            return yfalse;
+        case YVAR_TYPE_BOOL:
+            *output = yvar->data.ybool_data;
+            break;
+        case YVAR_TYPE_INT8:
+            if (yvar->data.yint8_data < YUKI_MIN_UINT16_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = yvar->data.yint8_data;
+            break;
+        case YVAR_TYPE_UINT8:
+            *output = yvar->data.yuint8_data;
+            break;
+        case YVAR_TYPE_INT16:
+            if (yvar->data.yint16_data < YUKI_MIN_UINT16_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yuint16_t)yvar->data.yint16_data;
+            break;
+        case YVAR_TYPE_UINT16:
+            *output = yvar->data.yuint16_data;
+            break;
+        case YVAR_TYPE_INT32:
+            if (yvar->data.yint32_data > YUKI_MAX_UINT16_VALUE || yvar->data.yint32_data < YUKI_MIN_UINT16_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yuint16_t)yvar->data.yint32_data;
+            break;
+        case YVAR_TYPE_UINT32:
+            if (yvar->data.yuint32_data > YUKI_MAX_UINT16_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yuint16_t)yvar->data.yuint32_data;
+            break;
+        case YVAR_TYPE_INT64:
+            if (yvar->data.yint64_data > YUKI_MAX_UINT16_VALUE || yvar->data.yint64_data < YUKI_MIN_UINT16_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yuint16_t)yvar->data.yint64_data;
+            break;
+        case YVAR_TYPE_UINT64:
+            if (yvar->data.yuint64_data > YUKI_MAX_UINT16_VALUE) {
+                YUKI_LOG_DEBUG("value is overflow");
+                return yfalse;
+            }
+
+            *output = (yuint16_t)yvar->data.yuint64_data;
+            break;
+        case YVAR_TYPE_CSTR:
+            YUKI_LOG_DEBUG("cstr cannot be converted to uint16");
+            return yfalse;
+        case YVAR_TYPE_STR:
+            YUKI_LOG_DEBUG("str cannot be converted to uint16");
             return yfalse;
         case YVAR_TYPE_ARRAY:
             YUKI_LOG_DEBUG("array cannot be converted to uint16");
@@ -740,6 +1516,9 @@ ybool_t _yvar_get_uint16(const yvar_t * yvar, yuint16_t * output)
         case YVAR_TYPE_MAP:
             YUKI_LOG_DEBUG("map cannot be converted to uint16");
             return yfalse;
+        case YVAR_TYPE_PACKED:
+            YUKI_LOG_DEBUG("packed array cannot be converted to uint16");
+            return yfalse;
         default:
             YUKI_LOG_FATAL("impossible type value %d", yvar->type);
             return yfalse;
@@ -816,6 +1595,9 @@ ybool_t _yvar_get_int32(const yvar_t * yvar, yint32_t * output)
         case YVAR_TYPE_MAP:
             YUKI_LOG_DEBUG("map cannot be converted to int32");
             return yfalse;
+        case YVAR_TYPE_PACKED:
+            YUKI_LOG_DEBUG("packed array cannot be converted to int32");
+            return yfalse;
         default:
             YUKI_LOG_FATAL("impossible type value %d", yvar->type);
             return yfalse;
@@ -902,6 +1684,9 @@ ybool_t _yvar_get_uint32(const yvar_t * yvar, yuint32_t * output)
         case YVAR_TYPE_MAP:
             YUKI_LOG_DEBUG("map cannot be converted to uint32");
             return yfalse;
+        case YVAR_TYPE_PACKED:
+            YUKI_LOG_DEBUG("packed array cannot be converted to uint32");
+            return yfalse;
         default:
             YUKI_LOG_FATAL("impossible type value %d", yvar->type);
             return yfalse;
@@ -968,6 +1753,9 @@ ybool_t _yvar_get_int64(const yvar_t * yvar, yint64_t * output)
         case YVAR_TYPE_MAP:
             YUKI_LOG_DEBUG("map cannot be converted to int64");
             return yfalse;
+        case YVAR_TYPE_PACKED:
+            YUKI_LOG_DEBUG("packed array cannot be converted to int64");
+            return yfalse;
         default:
             YUKI_LOG_FATAL("impossible type value %d", yvar->type);
             return yfalse;
@@ -1021,7 +1809,7 @@ ybool_t _yvar_get_uint64(const yvar_t * yvar, yuint64_t * output)
             *output = yvar->data.yint32_data;
             break;
         case YVAR_TYPE_UINT32:
-            *output = yvar->data.yuint64_data;
+            *output = yvar->data.yuint32_data;
             break;
         case YVAR_TYPE_INT64:
             if (yvar->data.yint64_data < YUKI_MIN_UINT64_VALUE) {
@@ -1049,6 +1837,69 @@ ybool_t _yvar_get_uint64(const yvar_t * yvar, yuint64_t * output)
         case YVAR_TYPE_MAP:
             YUKI_LOG_DEBUG("map cannot be converted to uint64");
             return yfalse;
+        case YVAR_TYPE_PACKED:
+            YUKI_LOG_DEBUG("packed array cannot be converted to uint64");
+            return yfalse;
+        default:
+            YUKI_LOG_FATAL("impossible type value %d", yvar->type);
+            return yfalse;
+    }
+    
+    return ytrue;
+}
+
+ybool_t _yvar_get_str(const yvar_t * yvar, char * output, ysize_t size)
+{
+    return _yvar_get_cstr(yvar, output, size);
+}
+
+ybool_t _yvar_get_cstr(const yvar_t * yvar, char * output, ysize_t size)
+{
+    if (!yvar || !output || !size) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    switch (yvar->type) {
+        case YVAR_TYPE_UNDEFINED:
+            YUKI_LOG_DEBUG("undefined cannot be converted to str");
+            return yfalse;
+        case YVAR_TYPE_BOOL:
+            return _ybool_to_str(yvar->data.ybool_data, output, size);
+        case YVAR_TYPE_INT8:
+            return _yint8_to_str(yvar->data.yint8_data, output, size);
+        case YVAR_TYPE_UINT8:
+            return _yuint8_to_str(yvar->data.yuint8_data, output, size);
+        case YVAR_TYPE_INT16:
+            return _yint16_to_str(yvar->data.yint16_data, output, size);
+        case YVAR_TYPE_UINT16:
+            return _yuint16_to_str(yvar->data.yuint16_data, output, size);
+        case YVAR_TYPE_INT32:
+            return _yint32_to_str(yvar->data.yint32_data, output, size);
+        case YVAR_TYPE_UINT32:
+            return _yuint32_to_str(yvar->data.yuint32_data, output, size);
+        case YVAR_TYPE_INT64:
+            return _yint64_to_str(yvar->data.yint64_data, output, size);
+        case YVAR_TYPE_UINT64:
+            return _yuint64_to_str(yvar->data.yuint64_data, output, size);
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+        {
+            ycstr_t ycstr = {_yvar_str_size(yvar), yvar_cstr_buffer(*yvar)};
+            return _ycstr_to_str(&ycstr, output, size);
+        }
+        case YVAR_TYPE_ARRAY:
+            YUKI_LOG_DEBUG("array cannot be converted to str or cstr");
+            return yfalse;
+        case YVAR_TYPE_LIST:
+            YUKI_LOG_DEBUG("list cannot be converted to str or cstr");
+            return yfalse;
+        case YVAR_TYPE_MAP:
+            YUKI_LOG_DEBUG("map cannot be converted to str or cstr");
+            return yfalse;
+        case YVAR_TYPE_PACKED:
+            YUKI_LOG_DEBUG("packed array cannot be converted to str or cstr");
+            return yfalse;
         default:
             YUKI_LOG_FATAL("impossible type value %d", yvar->type);
             return yfalse;
@@ -1057,389 +1908,1383 @@ ybool_t _yvar_get_uint64(const yvar_t * yvar, yuint64_t * output)
     return ytrue;
 }
 
-ybool_t _yvar_get_str(const yvar_t * yvar, char * output, ysize_t size)
+ybool_t _yvar_like_string(const yvar_t * yvar)
+{
+    return yvar? (yvar_is_cstr(*yvar) || yvar_is_str(*yvar)): yfalse;
+}
+
+ybool_t _yvar_like_int(const yvar_t * yvar)
+{
+    return yvar? (yvar->type >= YVAR_TYPE_INT_MIN && yvar->type <= YVAR_TYPE_INT_MAX): yfalse;
+}
+
+ybool_t _yvar_has_option(const yvar_t * yvar, yuint32_t opt)
+{
+    return yvar && (yvar->options & opt);
+}
+
+ybool_t _yvar_set_option(yvar_t * yvar, yuint32_t opt)
+{
+    if (!yvar) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    yvar->options |= opt;
+    return ytrue;
+}
+
+ybool_t _yvar_unset_option(yvar_t * yvar, yuint32_t opt)
+{
+    if (!yvar) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    yvar->options &= ~opt;
+    return ytrue;
+}
+
+/**
+ * count of var. the symantic is similar to the count() in PHP.
+ * only count elements in array or list.
+ * one exception is undefined var. this function always returns 0 for it.
+ */
+ysize_t _yvar_count(const yvar_t * yvar)
+{
+    if (!yvar) {
+        YUKI_LOG_FATAL("invalid param");
+        return 0;
+    }
+
+    switch (yvar->type) {
+        case YVAR_TYPE_UNDEFINED:
+            return 0;
+        case YVAR_TYPE_BOOL:
+        case YVAR_TYPE_INT8:
+        case YVAR_TYPE_UINT8:
+        case YVAR_TYPE_INT16:
+        case YVAR_TYPE_UINT16:
+        case YVAR_TYPE_INT32:
+        case YVAR_TYPE_UINT32:
+        case YVAR_TYPE_INT64:
+        case YVAR_TYPE_UINT64:
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+            return 1;
+        case YVAR_TYPE_ARRAY:
+            return yvar->data.yarray_data.size;
+        case YVAR_TYPE_LIST:
+        {
+            const ylist_node_t * tail = yvar->data.ylist_data.tail;
+            return tail? tail->offset + tail->size: 0;
+        }
+        case YVAR_TYPE_MAP:
+            return _yvar_count(yvar->data.ymap_data.keys);
+        case YVAR_TYPE_PACKED:
+            return yvar->data.ypacked_data.size;
+        default:
+            YUKI_LOG_FATAL("impossible type value %d", yvar->type);
+            return 0;
+    }
+}
+
+/**
+ * compare two vars of the same type except array, list and map.
+ */
+static ybool_t _yvar_equal_value(const yvar_t * plhs, const yvar_t * prhs)
+{
+    switch (plhs->type) {
+        case YVAR_TYPE_UNDEFINED:
+            return ytrue;
+        case YVAR_TYPE_BOOL:
+            return plhs->data.ybool_data == prhs->data.ybool_data;
+        case YVAR_TYPE_INT8:
+            return plhs->data.yint8_data == prhs->data.yint8_data;
+        case YVAR_TYPE_UINT8:
+            return plhs->data.yuint8_data == prhs->data.yuint8_data;
+        case YVAR_TYPE_INT16:
+            return plhs->data.yint16_data == prhs->data.yint16_data;
+        case YVAR_TYPE_UINT16:
+            return plhs->data.yuint16_data == prhs->data.yuint16_data;
+        case YVAR_TYPE_INT32:
+            return plhs->data.yint32_data == prhs->data.yint32_data;
+        case YVAR_TYPE_UINT32:
+            return plhs->data.yuint32_data == prhs->data.yuint32_data;
+        case YVAR_TYPE_INT64:
+            return plhs->data.yint64_data == prhs->data.yint64_data;
+        case YVAR_TYPE_UINT64:
+            return plhs->data.yuint64_data == prhs->data.yuint64_data;
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+        {
+            if (_yvar_str_size(plhs) != _yvar_str_size(prhs)) {
+                return yfalse;
+            }
+
+            const char * lhs_str = yvar_cstr_buffer(*plhs);
+            const char * rhs_str = yvar_cstr_buffer(*prhs);
+
+            if (lhs_str == rhs_str) {
+                return ytrue;
+            }
+
+            // interned strings are equal only if they share the same pointer
+            if (plhs->options & prhs->options & YVAR_OPTION_INTERNED) {
+                return yfalse;
+            }
+
+            if ((plhs->options & prhs->options & YVAR_OPTION_HASHED) && plhs->hash != prhs->hash) {
+                return yfalse;
+            }
+
+            if (!lhs_str || !rhs_str) {
+                return !_yvar_str_size(plhs);
+            }
+
+            return !memcmp(lhs_str, rhs_str, _yvar_str_size(plhs));
+        }
+        case YVAR_TYPE_PACKED:
+        {
+            ysize_t size = _yvar_packed_data_size(plhs);
+
+            if (plhs->data.ypacked_data.type != prhs->data.ypacked_data.type
+                    || plhs->data.ypacked_data.size != prhs->data.ypacked_data.size) {
+                return yfalse;
+            }
+
+            return plhs->data.ypacked_data.data == prhs->data.ypacked_data.data
+                || !size || !memcmp(plhs->data.ypacked_data.data, prhs->data.ypacked_data.data, size);
+        }
+        default:
+            YUKI_LOG_FATAL("impossible type value %d", plhs->type);
+            return yfalse;
+    }
+}
+
+
+/**
+ * compare a var with its peer. elements of array, list and map are compared by walking them.
+ */
+static YVAR_WALK_RESULT _yvar_equal_visit(yvar_walk_frame_t * frame, void * data)
+{
+    const yvar_t * plhs = frame->yvar;
+    const yvar_t * prhs = frame->peer;
+    (void)data;
+
+    if (plhs == prhs) {
+        return YVAR_WALK_SKIP;
+    }
+
+    if (!prhs || plhs->type != prhs->type) {
+        return YVAR_WALK_STOP;
+    }
+
+    switch (plhs->type) {
+        case YVAR_TYPE_ARRAY:
+            if (plhs->data.yarray_data.size != prhs->data.yarray_data.size) {
+                return YVAR_WALK_STOP;
+            }
+
+            // shared arrays, e.g. clones of a frozen var
+            if (plhs->data.yarray_data.yvars == prhs->data.yarray_data.yvars) {
+                return YVAR_WALK_SKIP;
+            }
+
+            return YVAR_WALK_CONTINUE;
+        case YVAR_TYPE_LIST:
+            // nodes of lists of the same size may be different. they are walked in step anyway.
+            return yvar_count(*plhs) == yvar_count(*prhs)? YVAR_WALK_CONTINUE: YVAR_WALK_STOP;
+        case YVAR_TYPE_MAP:
+            return YVAR_WALK_CONTINUE;
+        default:
+            return _yvar_equal_value(plhs, prhs)? YVAR_WALK_SKIP: YVAR_WALK_STOP;
+    }
+}
+
+ybool_t _yvar_equal(const yvar_t * plhs, const yvar_t * prhs)
+{
+    if (plhs == prhs) {
+        return ytrue;
+    }
+
+    if (!plhs || !prhs) {
+        YUKI_LOG_DEBUG("NULL pointer in param");
+        return yfalse;
+    }
+
+    if (plhs->type != prhs->type) {
+        YUKI_LOG_DEBUG("different type");
+        return yfalse;
+    }
+
+    switch (plhs->type) {
+        case YVAR_TYPE_ARRAY:
+        case YVAR_TYPE_LIST:
+        case YVAR_TYPE_MAP:
+            // rhs is only read by visitor
+            return _yvar_walk_internal(plhs, (yvar_t*)prhs, &_yvar_equal_visit, NULL, NULL);
+        default:
+            return _yvar_equal_value(plhs, prhs);
+    }
+}
+
+#define _YVAR_COMPARE_VALUE(l, r) ((l) < (r)? -1: ((l) > (r)? 1: 0))
+
+/**
+ * total order of vars. it's consistent with _yvar_equal().
+ * vars are ordered by type first, then by value.
+ * strings are compared byte by byte, containers element by element.
+ * @return -1 if lhs < rhs, 0 if equal, 1 if lhs > rhs.
+ */
+yint8_t _yvar_compare(const yvar_t * plhs, const yvar_t * prhs)
+{
+    if (plhs == prhs) {
+        return 0;
+    }
+
+    if (!plhs || !prhs) {
+        YUKI_LOG_DEBUG("NULL pointer in param");
+        return plhs? 1: -1;
+    }
+
+    if (plhs->type != prhs->type) {
+        return _YVAR_COMPARE_VALUE(plhs->type, prhs->type);
+    }
+
+    switch (plhs->type) {
+        case YVAR_TYPE_UNDEFINED:
+            return 0;
+        case YVAR_TYPE_BOOL:
+            return _YVAR_COMPARE_VALUE(plhs->data.ybool_data, prhs->data.ybool_data);
+        case YVAR_TYPE_INT8:
+            return _YVAR_COMPARE_VALUE(plhs->data.yint8_data, prhs->data.yint8_data);
+        case YVAR_TYPE_UINT8:
+            return _YVAR_COMPARE_VALUE(plhs->data.yuint8_data, prhs->data.yuint8_data);
+        case YVAR_TYPE_INT16:
+            return _YVAR_COMPARE_VALUE(plhs->data.yint16_data, prhs->data.yint16_data);
+        case YVAR_TYPE_UINT16:
+            return _YVAR_COMPARE_VALUE(plhs->data.yuint16_data, prhs->data.yuint16_data);
+        case YVAR_TYPE_INT32:
+            return _YVAR_COMPARE_VALUE(plhs->data.yint32_data, prhs->data.yint32_data);
+        case YVAR_TYPE_UINT32:
+            return _YVAR_COMPARE_VALUE(plhs->data.yuint32_data, prhs->data.yuint32_data);
+        case YVAR_TYPE_INT64:
+            return _YVAR_COMPARE_VALUE(plhs->data.yint64_data, prhs->data.yint64_data);
+        case YVAR_TYPE_UINT64:
+            return _YVAR_COMPARE_VALUE(plhs->data.yuint64_data, prhs->data.yuint64_data);
+        case YVAR_TYPE_CSTR:
+        case YVAR_TYPE_STR:
+        {
+            ysize_t lhs_size = _yvar_str_size(plhs);
+            ysize_t rhs_size = _yvar_str_size(prhs);
+            int ret = 0;
+
+            if (lhs_size && rhs_size) {
+                ret = memcmp(yvar_cstr_buffer(*plhs), yvar_cstr_buffer(*prhs), lhs_size < rhs_size? lhs_size: rhs_size);
+            }
+
+            return ret? _YVAR_COMPARE_VALUE(ret, 0): _YVAR_COMPARE_VALUE(lhs_size, rhs_size);
+        }
+        case YVAR_TYPE_ARRAY:
+        {
+            ysize_t lhs_cnt = plhs->data.yarray_data.size;
+            ysize_t rhs_cnt = prhs->data.yarray_data.size;
+            ysize_t cnt;
+            yint8_t ret;
+
+            for (cnt = 0; cnt < lhs_cnt && cnt < rhs_cnt; cnt++) {
+                ret = _yvar_compare(plhs->data.yarray_data.yvars + cnt, prhs->data.yarray_data.yvars + cnt);
+
+                if (ret) {
+                    return ret;
+                }
+            }
+
+            return _YVAR_COMPARE_VALUE(lhs_cnt, rhs_cnt);
+        }
+        case YVAR_TYPE_LIST:
+        {
+            const ylist_node_t * lhs_node = plhs->data.ylist_data.head;
+            const ylist_node_t * rhs_node = prhs->data.ylist_data.head;
+            ysize_t lhs_index = 0;
+            ysize_t rhs_index = 0;
+            yint8_t ret;
+
+            while (lhs_node && rhs_node) {
+                ret = _yvar_compare(lhs_node->yvars + lhs_index, rhs_node->yvars + rhs_index);
+
+                if (ret) {
+                    return ret;
+                }
+
+                if (++lhs_index == lhs_node->size) {
+                    lhs_node = lhs_node->next;
+                    lhs_index = 0;
+                }
+
+                if (++rhs_index == rhs_node->size) {
+                    rhs_node = rhs_node->next;
+                    rhs_index = 0;
+                }
+            }
+
+            return _YVAR_COMPARE_VALUE(yvar_count(*plhs), yvar_count(*prhs));
+        }
+        case YVAR_TYPE_MAP:
+        {
+            yint8_t ret = _yvar_compare(plhs->data.ymap_data.keys, prhs->data.ymap_data.keys);
+            return ret? ret: _yvar_compare(plhs->data.ymap_data.values, prhs->data.ymap_data.values);
+        }
+        case YVAR_TYPE_PACKED:
+        {
+            ysize_t lhs_cnt = plhs->data.ypacked_data.size;
+            ysize_t rhs_cnt = prhs->data.ypacked_data.size;
+            yvar_t lhs_value, rhs_value;
+            ysize_t cnt;
+            yint8_t ret;
+
+            if (plhs->data.ypacked_data.type != prhs->data.ypacked_data.type) {
+                return _YVAR_COMPARE_VALUE(plhs->data.ypacked_data.type, prhs->data.ypacked_data.type);
+            }
+
+            for (cnt = 0; cnt < lhs_cnt && cnt < rhs_cnt; cnt++) {
+                _yvar_packed_load(plhs, cnt, &lhs_value);
+                _yvar_packed_load(prhs, cnt, &rhs_value);
+                ret = _yvar_compare(&lhs_value, &rhs_value);
+
+                if (ret) {
+                    return ret;
+                }
+            }
+
+            return _YVAR_COMPARE_VALUE(lhs_cnt, rhs_cnt);
+        }
+        default:
+            YUKI_LOG_FATAL("impossible type value %d", plhs->type);
+            return 0;
+    }
+}
+
+#undef _YVAR_COMPARE_VALUE
+
+ysize_t _yvar_cstr_strlen(const yvar_t * yvar)
+{
+    if (!yvar_like_string(*yvar)) {
+        YUKI_LOG_FATAL("var is not str or cstr");
+        return 0;
+    }
+
+    return _yvar_str_size(yvar);
+}
+
+/**
+ * clone an array of array to a var.
+ * it's designed to help ytable to clone field or condition easily.
+ * the type of triple_array is yvar_t[size][dimension].
+ */
+ybool_t _yvar_triple_array_clone(yvar_t ** array, yvar_triple_array_t triple_array, ysize_t size, ysize_t dimension)
+{
+    if (!array || !triple_array || !*triple_array || !size || !dimension) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    yvar_t raw_array[size];
+    ysize_t index;
+
+    for (index = 0; index < size; index++) {
+        yvar_array_with_size(raw_array[index], triple_array[index], dimension);
+    }
+
+    yvar_t the_array = YVAR_ARRAY_WITH_SIZE(raw_array, size);
+    return yvar_clone(*array, the_array);
+}
+
+/**
+ * pin an array of array to a var.
+ * it's designed to help ytable to pin field or condition easily.
+ * the type of triple_array is yvar_t[size][dimension].
+ */
+ybool_t _yvar_triple_array_pin(yvar_t ** array, yvar_triple_array_t triple_array, ysize_t size, ysize_t dimension)
+{
+    if (!array || !triple_array || !*triple_array || !size || !dimension) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    yvar_t raw_array[size];
+    ysize_t index;
+
+    for (index = 0; index < size; index++) {
+        yvar_array_with_size(raw_array[index], triple_array[index], dimension);
+    }
+
+    yvar_t the_array = YVAR_ARRAY_WITH_SIZE(raw_array, size);
+    return yvar_pin(*array, the_array);
+}
+
+ybool_t _yvar_array_get(const yvar_t * array, size_t index, yvar_t * output)
+{
+    if (!array || !output) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    static yvar_t undefined = YVAR_UNDEFINED();
+
+    if (!yvar_is_array(*array)) {
+        YUKI_LOG_DEBUG("var is not array");
+        return yfalse;
+    }
+
+    const yarray_t * arr = &array->data.yarray_data;
+
+    if (index >= arr->size) {
+        YUKI_LOG_DEBUG("out of bound. [index: %u]", index);
+        return yvar_assign(*output, undefined);
+    }
+
+    return yvar_assign(*output, arr->yvars[index]);
+}
+
+ysize_t _yvar_array_size(const yvar_t * pyvar)
+{
+    if (!yvar_is_array(*pyvar)) {
+        return 0;
+    }
+
+    return pyvar->data.yarray_data.size;
+}
+
+static int _yvar_qsort_compare(const void * lhs, const void * rhs)
+{
+    return _yvar_compare((const yvar_t*)lhs, (const yvar_t*)rhs);
+}
+
+/**
+ * sort elements of an array in place and mark it sorted.
+ */
+ybool_t _yvar_array_sort(yvar_t * array)
+{
+    if (!array || !yvar_is_array(*array)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*array, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("array is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    if ((array->options & YVAR_OPTION_FROZEN) && !_yvar_thaw(array)) {
+        YUKI_LOG_WARNING("cannot copy frozen array");
+        return yfalse;
+    }
+
+    if (array->data.yarray_data.size > 1) {
+        qsort(array->data.yarray_data.yvars, array->data.yarray_data.size, sizeof(yvar_t), &_yvar_qsort_compare);
+    }
+
+    yvar_set_option(*array, YVAR_OPTION_SORTED);
+    return ytrue;
+}
+
+/**
+ * same as _yvar_compare() but string and int64 keys are compared inline.
+ */
+static inline int _yvar_compare_key(const yvar_t * lhs, const yvar_t * rhs)
+{
+    if (lhs->type == rhs->type && (YVAR_TYPE_CSTR == lhs->type || YVAR_TYPE_STR == lhs->type)) {
+        const char * lhs_str = yvar_cstr_buffer(*lhs);
+        const char * rhs_str = yvar_cstr_buffer(*rhs);
+
+        if (lhs_str && rhs_str) {
+            ysize_t lhs_size = _yvar_str_size(lhs);
+            ysize_t rhs_size = _yvar_str_size(rhs);
+
+            if (lhs_str == rhs_str && lhs_size == rhs_size) {
+                return 0;
+            }
+
+            int ret = memcmp(lhs_str, rhs_str, lhs_size < rhs_size? lhs_size: rhs_size);
+            return ret? ret: (lhs_size > rhs_size) - (lhs_size < rhs_size);
+        }
+    }
+
+    return _yvar_compare(lhs, rhs);
+}
+
+/**
+ * binary search for the first element equal to key in sorted vars.
+ */
+static inline ybool_t _yvar_sorted_find(const yvar_t * yvars, ysize_t size, const yvar_t * key, ysize_t * index)
+{
+    ysize_t low = 0;
+    ysize_t high = size;
+    ysize_t mid;
+
+    while (low < high) {
+        mid = low + (high - low) / 2;
+
+        if (_yvar_compare_key(yvars + mid, key) < 0) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+
+    if (low < size && !_yvar_compare_key(yvars + low, key)) {
+        *index = low;
+        return ytrue;
+    }
+
+    return yfalse;
+}
+
+/**
+ * find the first element equal to key.
+ * binary search is used if array is sorted, otherwise it's a linear search.
+ */
+ybool_t _yvar_array_bsearch(const yvar_t * array, const yvar_t * key, ysize_t * index)
+{
+    if (!array || !key || !index || !yvar_is_array(*array)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    const yvar_t * yvars = array->data.yarray_data.yvars;
+    ysize_t size = array->data.yarray_data.size;
+    ysize_t i;
+
+    if (!yvar_has_option(*array, YVAR_OPTION_SORTED)) {
+        for (i = 0; i < size; i++) {
+            if (yvar_equal(yvars[i], *key)) {
+                *index = i;
+                return ytrue;
+            }
+        }
+
+        return yfalse;
+    }
+
+    return _yvar_sorted_find(yvars, size, key, index);
+}
+
+static inline yvar_array_block_t * _yvar_array_block(const yvar_t * array)
+{
+    return (yvar_array_block_t*)((char*)array->data.yarray_data.yvars - ybuffer_round_up(sizeof(yvar_array_block_t)));
+}
+
+/**
+ * check whether `extra` vars can be pushed to array in place.
+ */
+static inline ybool_t _yvar_array_has_room(const yvar_t * array, ysize_t extra)
+{
+    if ((array->options & (YVAR_OPTION_GROWABLE | YVAR_OPTION_FROZEN)) != YVAR_OPTION_GROWABLE) {
+        return yfalse;
+    }
+
+    const yvar_array_block_t * block = _yvar_array_block(array);
+    ysize_t size = array->data.yarray_data.size;
+    return block->size == size && block->capacity - size >= extra;
+}
+
+/**
+ * move vars of array to a new block in arena.
+ * old vars are left untouched as other vars may still use them.
+ */
+static ybool_t _yvar_array_grow(yvar_t * array, ysize_t capacity)
+{
+    ysize_t size = array->data.yarray_data.size;
+    ysize_t header_size = ybuffer_round_up(sizeof(yvar_array_block_t));
+    char * memory = (char*)ybuffer_site_simple_alloc(header_size + capacity * sizeof(yvar_t), YBUFFER_SITE_ARRAY);
+
+    if (!memory) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    yvar_array_block_t * block = (yvar_array_block_t*)memory;
+    yvar_t * yvars = (yvar_t*)(memory + header_size);
+
+    if (size) {
+        memcpy(yvars, array->data.yarray_data.yvars, size * sizeof(yvar_t));
+    }
+
+    block->capacity = capacity;
+    block->size = size;
+    array->data.yarray_data.yvars = yvars;
+    array->options = (array->options | YVAR_OPTION_GROWABLE) & ~YVAR_OPTION_FROZEN;
+    return ytrue;
+}
+
+/**
+ * append a var to array. value is copied by yvar_assign() and not cloned.
+ * capacity grows geometrically in thread arena, so it's amortized O(1).
+ * memory is released by yuki_clean_up() as cloned vars.
+ * @code
+ * yvar_t rows = YVAR_EMPTY();
+ * yvar_array_with_size(rows, NULL, 0);
+ * yvar_array_reserve(rows, 100); // optional
+ *
+ * while (...) {
+ *     yvar_array_push(rows, row);
+ * }
+ * @endcode
+ */
+ybool_t _yvar_array_push(yvar_t * array, const yvar_t * value)
+{
+    if (!array || !value || !yvar_is_array(*array)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*array, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("array is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    ysize_t size = array->data.yarray_data.size;
+
+    if (!_yvar_array_has_room(array, 1)
+            && !_yvar_array_grow(array, size < YVAR_ARRAY_MIN_CAPACITY / 2? YVAR_ARRAY_MIN_CAPACITY: size * 2)) {
+        YUKI_LOG_WARNING("cannot grow array");
+        return yfalse;
+    }
+
+    // NOTE: don't use yvar_assign, as dst is not initialized.
+    array->data.yarray_data.yvars[size] = *value;
+    array->data.yarray_data.size = ++_yvar_array_block(array)->size;
+    array->options &= ~YVAR_OPTION_SORTED;
+    return ytrue;
+}
+
+/**
+ * make sure at least `capacity` vars can be stored in array without growing again.
+ */
+ybool_t _yvar_array_reserve(yvar_t * array, ysize_t capacity)
+{
+    if (!array || !yvar_is_array(*array)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*array, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("array is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    ysize_t size = array->data.yarray_data.size;
+
+    if (capacity < size) {
+        capacity = size;
+    }
+
+    if (_yvar_array_has_room(array, capacity - size)) {
+        return ytrue;
+    }
+
+    return _yvar_array_grow(array, capacity);
+}
+
+ybool_t _yvar_list_push_back(yvar_t * yvar, yvar_t * node)
+{
+    if (!yvar || !node || !yvar_is_list(*yvar)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    if (yvar_has_option(*yvar, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("list is readonly or pinned. cannot be modified.");
+        return yfalse;
+    }
+
+    if ((yvar->options & YVAR_OPTION_FROZEN) && !_yvar_thaw(yvar)) {
+        YUKI_LOG_WARNING("cannot copy frozen list");
+        return yfalse;
+    }
+
+    ylist_node_t * tail = yvar->data.ylist_data.tail;
+
+    // vars are pushed to tail node until it's full
+    if (!tail || tail->size == tail->capacity) {
+        ylist_node_t * new_tail = (ylist_node_t*)ybuffer_site_simple_alloc(
+            sizeof(ylist_node_t) + YLIST_NODE_CAPACITY * sizeof(yvar_t), YBUFFER_SITE_LIST);
+
+        if (!new_tail) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+
+        new_tail->prev = tail;
+        new_tail->next = NULL;
+        new_tail->offset = tail? tail->offset + tail->size: 0;
+        new_tail->size = 0;
+        new_tail->capacity = YLIST_NODE_CAPACITY;
+
+        if (tail) {
+            tail->next = new_tail;
+        } else {
+            yvar->data.ylist_data.head = new_tail;
+        }
+
+        yvar->data.ylist_data.tail = new_tail;
+        tail = new_tail;
+    }
+
+    yvar_t * value = tail->yvars + tail->size;
+    yvar_memzero(*value);
+
+    if (!yvar_assign(*value, *node)) {
+        YUKI_LOG_WARNING("cannot assign new value to node");
+        return yfalse;
+    }
+
+    tail->size++;
+    return ytrue;
+}
+
+// packed array kernels {{{
+#if defined(__GNUC__)
+/**
+ * packed elements are processed 32 bytes a time by gcc vector extensions.
+ * gcc lowers them to sse2 or avx2 instructions whichever is available.
+ */
+# define YVAR_PACKED_VECTOR_SIZE 32
+typedef yuint64_t _yvar_packed_mask_t __attribute__((vector_size(YVAR_PACKED_VECTOR_SIZE)));
+
+// x86 has no ordered compare of 64-bit ints before sse4.2. gcc emulates it lane by lane,
+// which is slower than a scalar loop. min/max of 64-bit ints falls back to the scalar loop.
+# if defined(__x86_64__) && !defined(__SSE4_2__)
+#  define YVAR_PACKED_VECTOR_INT64_ORDER 0
+# else
+#  define YVAR_PACKED_VECTOR_INT64_ORDER 1
+# endif
+
+# define _YVAR_PACKED_VECTOR_KERNELS(t) \
+    typedef y##t##_t _yvar_packed_vector_##t##_t __attribute__((vector_size(YVAR_PACKED_VECTOR_SIZE))); \
+    static ysize_t _yvar_packed_vector_min_max_##t(const y##t##_t * data, ysize_t size, y##t##_t * min, y##t##_t * max) \
+    { \
+        const ysize_t lanes = YVAR_PACKED_VECTOR_SIZE / sizeof(y##t##_t); \
+        _yvar_packed_vector_##t##_t vmin, vmax, v, mask; \
+        ysize_t i, j; \
+        if (size < lanes || (sizeof(y##t##_t) == 8 && !YVAR_PACKED_VECTOR_INT64_ORDER)) { \
+            return 0; \
+        } \
+        memcpy(&vmin, data, sizeof(vmin)); \
+        vmax = vmin; \
+        for (i = lanes; i + lanes <= size; i += lanes) { \
+            memcpy(&v, data + i, sizeof(v)); \
+            mask = (_yvar_packed_vector_##t##_t)(v < vmin); \
+            vmin = (v & mask) | (vmin & ~mask); \
+            mask = (_yvar_packed_vector_##t##_t)(v > vmax); \
+            vmax = (v & mask) | (vmax & ~mask); \
+        } \
+        *min = vmin[0]; \
+        *max = vmax[0]; \
+        for (j = 1; j < lanes; j++) { \
+            *min = vmin[j] < *min? vmin[j]: *min; \
+            *max = vmax[j] > *max? vmax[j]: *max; \
+        } \
+        return i; \
+    } \
+    static ysize_t _yvar_packed_vector_find_##t(const y##t##_t * data, ysize_t size, y##t##_t value) \
+    { \
+        const ysize_t lanes = YVAR_PACKED_VECTOR_SIZE / sizeof(y##t##_t); \
+        _yvar_packed_vector_##t##_t needle, v; \
+        _yvar_packed_mask_t mask; \
+        ysize_t i; \
+        needle = (_yvar_packed_vector_##t##_t){0} + value; \
+        for (i = 0; i + lanes <= size; i += lanes) { \
+            memcpy(&v, data + i, sizeof(v)); \
+            mask = (_yvar_packed_mask_t)(v == needle); \
+            if (mask[0] | mask[1] | mask[2] | mask[3]) { \
+                break; \
+            } \
+        } \
+        return i; \
+    }
+#else
+# define _YVAR_PACKED_VECTOR_KERNELS(t) \
+    static inline ysize_t _yvar_packed_vector_min_max_##t(const y##t##_t * data, ysize_t size, y##t##_t * min, y##t##_t * max) \
+    { \
+        return 0; \
+    } \
+    static inline ysize_t _yvar_packed_vector_find_##t(const y##t##_t * data, ysize_t size, y##t##_t value) \
+    { \
+        return 0; \
+    }
+#endif
+
+/**
+ * define kernels of an element type. vector kernels process as many elements as possible,
+ * and return how many elements are done. scalar loop finishes the rest.
+ *
+ * sum uses 4 independent accumulators so that adds are not serialized.
+ * all ints are added as yuint64_t; result wraps around on overflow.
+ */
+#define _YVAR_PACKED_KERNELS(t) \
+    _YVAR_PACKED_VECTOR_KERNELS(t) \
+    static yuint64_t _yvar_packed_sum_##t(const y##t##_t * data, ysize_t size) \
+    { \
+        yuint64_t sum0 = 0, sum1 = 0, sum2 = 0, sum3 = 0; \
+        ysize_t i; \
+        for (i = 0; i + 4 <= size; i += 4) { \
+            sum0 += (yuint64_t)data[i]; \
+            sum1 += (yuint64_t)data[i + 1]; \
+            sum2 += (yuint64_t)data[i + 2]; \
+            sum3 += (yuint64_t)data[i + 3]; \
+        } \
+        for (; i < size; i++) { \
+            sum0 += (yuint64_t)data[i]; \
+        } \
+        return sum0 + sum1 + sum2 + sum3; \
+    } \
+    static void _yvar_packed_min_max_##t(const y##t##_t * data, ysize_t size, y##t##_t * min, y##t##_t * max) \
+    { \
+        ysize_t i = _yvar_packed_vector_min_max_##t(data, size, min, max); \
+        if (!i) { \
+            *min = *max = data[0]; \
+        } \
+        for (; i < size; i++) { \
+            *min = data[i] < *min? data[i]: *min; \
+            *max = data[i] > *max? data[i]: *max; \
+        } \
+    } \
+    static ybool_t _yvar_packed_find_##t(const y##t##_t * data, ysize_t size, y##t##_t value, ysize_t * index) \
+    { \
+        ysize_t i = _yvar_packed_vector_find_##t(data, size, value); \
+        for (; i < size; i++) { \
+            if (data[i] == value) { \
+                *index = i; \
+                return ytrue; \
+            } \
+        } \
+        return yfalse; \
+    }
+
+// bool is stored as yint8_t and shares int8 kernels
+_YVAR_PACKED_KERNELS(int8)
+_YVAR_PACKED_KERNELS(uint8)
+_YVAR_PACKED_KERNELS(int16)
+_YVAR_PACKED_KERNELS(uint16)
+_YVAR_PACKED_KERNELS(int32)
+_YVAR_PACKED_KERNELS(uint32)
+_YVAR_PACKED_KERNELS(int64)
+_YVAR_PACKED_KERNELS(uint64)
+// }}}
+
+ybool_t _yvar_packed_get(const yvar_t * packed, ysize_t index, yvar_t * output)
 {
-    return _yvar_get_cstr(yvar, output, size);
+    if (!packed || !output) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    static yvar_t undefined = YVAR_UNDEFINED();
+
+    if (!yvar_is_packed(*packed)) {
+        YUKI_LOG_DEBUG("var is not packed array");
+        return yfalse;
+    }
+
+    if (index >= packed->data.ypacked_data.size) {
+        YUKI_LOG_DEBUG("out of bound. [index: %u]", index);
+        return yvar_assign(*output, undefined);
+    }
+
+    yvar_t value;
+    _yvar_packed_load(packed, index, &value);
+    return yvar_assign(*output, value);
 }
 
-ybool_t _yvar_get_cstr(const yvar_t * yvar, char * output, ysize_t size)
+/**
+ * value is converted to element type. fail if it's out of range.
+ */
+ybool_t _yvar_packed_set(yvar_t * packed, ysize_t index, const yvar_t * value)
 {
-    if (!yvar || !output || !size) {
+    if (!packed || !value || !yvar_is_packed(*packed)) {
         YUKI_LOG_FATAL("invalid param");
         return yfalse;
     }
 
-    switch (yvar->type) {
-        case YVAR_TYPE_UNDEFINED:
-            YUKI_LOG_DEBUG("undefined cannot be converted to str");
-            return yfalse;
-        case YVAR_TYPE_BOOL:
-            return _ybool_to_str(yvar->data.ybool_data, output, size);
-        case YVAR_TYPE_INT8:
-            return _yint8_to_str(yvar->data.yint8_data, output, size);
-        case YVAR_TYPE_UINT8:
-            return _yuint8_to_str(yvar->data.yuint8_data, output, size);
-        case YVAR_TYPE_INT16:
-            return _yint16_to_str(yvar->data.yint16_data, output, size);
-        case YVAR_TYPE_UINT16:
-            return _yuint16_to_str(yvar->data.yuint16_data, output, size);
-        case YVAR_TYPE_INT32:
-            return _yint32_to_str(yvar->data.yint32_data, output, size);
-        case YVAR_TYPE_UINT32:
-            return _yuint32_to_str(yvar->data.yuint32_data, output, size);
-        case YVAR_TYPE_INT64:
-            return _yint64_to_str(yvar->data.yint64_data, output, size);
-        case YVAR_TYPE_UINT64:
-            return _yuint64_to_str(yvar->data.yuint64_data, output, size);
-        case YVAR_TYPE_CSTR:
-        case YVAR_TYPE_STR:
-            return _ycstr_to_str(&yvar->data.ycstr_data, output, size);
-        case YVAR_TYPE_ARRAY:
-            YUKI_LOG_DEBUG("array cannot be converted to str or cstr");
-            return yfalse;
-        case YVAR_TYPE_LIST:
-            YUKI_LOG_DEBUG("list cannot be converted to str or cstr");
-            return yfalse;
-        case YVAR_TYPE_MAP:
-            YUKI_LOG_DEBUG("map cannot be converted to str or cstr");
-            return yfalse;
-        default:
-            YUKI_LOG_FATAL("impossible type value %d", yvar->type);
-            return yfalse;
+    if (yvar_has_option(*packed, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
+        YUKI_LOG_DEBUG("packed array is readonly or pinned. cannot be modified.");
+        return yfalse;
     }
-    
-    return ytrue;
-}
 
-ybool_t _yvar_like_string(const yvar_t * yvar)
-{
-    return yvar? (yvar_is_cstr(*yvar) || yvar_is_str(*yvar)): yfalse;
-}
+    if (index >= packed->data.ypacked_data.size) {
+        YUKI_LOG_DEBUG("out of bound. [index: %u]", index);
+        return yfalse;
+    }
 
-ybool_t _yvar_like_int(const yvar_t * yvar)
-{
-    return yvar? (yvar->type >= YVAR_TYPE_INT_MIN && yvar->type <= YVAR_TYPE_INT_MAX): yfalse;
-}
+    yuint8_t type = packed->data.ypacked_data.type;
+    ysize_t element_size = _yvar_packed_element_size(type);
+    yvar_packed_element_t element;
 
-ybool_t _yvar_has_option(const yvar_t * yvar, yuint32_t opt)
-{
-    return yvar && (yvar->options & opt);
-}
+    // convert first so that a frozen array is not copied for nothing
+    if (!_yvar_packed_store(type, &element, value)) {
+        YUKI_LOG_DEBUG("value cannot be stored in packed array. [type: %d]", type);
+        return yfalse;
+    }
 
-ybool_t _yvar_set_option(yvar_t * yvar, yuint32_t opt)
-{
-    if (!yvar) {
-        YUKI_LOG_FATAL("invalid param");
+    if ((packed->options & YVAR_OPTION_FROZEN) && !_yvar_thaw(packed)) {
+        YUKI_LOG_WARNING("cannot copy frozen packed array");
         return yfalse;
     }
 
-    yvar->options |= opt;
+    memcpy((char*)packed->data.ypacked_data.data + index * element_size, &element, element_size);
     return ytrue;
 }
 
-ybool_t _yvar_unset_option(yvar_t * yvar, yuint32_t opt)
+/**
+ * pack all elements of an array or a list to a new packed array of type.
+ * fail if any element cannot be converted to type.
+ */
+ybool_t _yvar_packed_from_array(yvar_t * packed, const yvar_t * array, yuint8_t type)
 {
-    if (!yvar) {
+    ysize_t element_size = _yvar_packed_element_size(type);
+
+    if (!packed || !array || !element_size) {
         YUKI_LOG_FATAL("invalid param");
         return yfalse;
     }
 
-    yvar->options &= ~opt;
+    if (!yvar_is_array(*array) && !yvar_is_list(*array)) {
+        YUKI_LOG_DEBUG("var is not array or list");
+        return yfalse;
+    }
+
+    ysize_t size = yvar_count(*array);
+
+    if (size > YUKI_MAX_UINT32_VALUE) {
+        YUKI_LOG_WARNING("too many elements for a packed array. [size: %lu]", size);
+        return yfalse;
+    }
+
+    char * data = NULL;
+    char * element;
+
+    if (size) {
+        data = (char*)ybuffer_site_simple_alloc(size * element_size, YBUFFER_SITE_ARRAY);
+
+        if (!data) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+    }
+
+    element = data;
+
+    if (yvar_is_array(*array)) {
+        const yvar_t * yvars = array->data.yarray_data.yvars;
+        ysize_t i;
+
+        for (i = 0; i < size; i++, element += element_size) {
+            if (!_yvar_packed_store(type, element, yvars + i)) {
+                YUKI_LOG_DEBUG("element cannot be packed. [index: %lu] [type: %d]", i, type);
+                return yfalse;
+            }
+        }
+    } else {
+        const ylist_node_t * node = array->data.ylist_data.head;
+        ysize_t i;
+
+        for (; node; node = node->next) {
+            for (i = 0; i < node->size; i++, element += element_size) {
+                if (!_yvar_packed_store(type, element, node->yvars + i)) {
+                    YUKI_LOG_DEBUG("element cannot be packed. [index: %lu] [type: %d]", node->offset + i, type);
+                    return yfalse;
+                }
+            }
+        }
+    }
+
+    yvar_packed(*packed, type, data, size);
     return ytrue;
 }
 
 /**
- * count of var. the symantic is similar to the count() in PHP.
- * only count elements in array or list.
- * one exception is undefined var. this function always returns 0 for it.
+ * unpack a packed array to an array of scalar vars.
  */
-ysize_t _yvar_count(const yvar_t * yvar)
+ybool_t _yvar_packed_to_array(yvar_t * array, const yvar_t * packed)
 {
-    if (!yvar) {
+    if (!array || !packed || !yvar_is_packed(*packed)) {
         YUKI_LOG_FATAL("invalid param");
-        return 0;
+        return yfalse;
     }
 
-    switch (yvar->type) {
-        case YVAR_TYPE_UNDEFINED:
-            return 0;
-        case YVAR_TYPE_BOOL:
-        case YVAR_TYPE_INT8:
-        case YVAR_TYPE_UINT8:
-        case YVAR_TYPE_INT16:
-        case YVAR_TYPE_UINT16:
-        case YVAR_TYPE_INT32:
-        case YVAR_TYPE_UINT32:
-        case YVAR_TYPE_CSTR:
-        case YVAR_TYPE_STR:
-            return 1;
-        case YVAR_TYPE_ARRAY:
-            return yvar->data.yarray_data.size;
-        case YVAR_TYPE_LIST:
-        {
-            ysize_t cnt = 0;
+    ysize_t size = packed->data.ypacked_data.size;
+    yvar_t * yvars = NULL;
+    ysize_t i;
 
-            FOREACH_YVAR_LIST(*yvar, value) {
-                cnt++;
-            }
+    if (size) {
+        yvars = (yvar_t*)ybuffer_site_simple_alloc(size * sizeof(yvar_t), YBUFFER_SITE_ARRAY);
 
-            return cnt;
+        if (!yvars) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+
+        for (i = 0; i < size; i++) {
+            _yvar_packed_load(packed, i, yvars + i);
         }
-        case YVAR_TYPE_MAP:
-            return _yvar_count(yvar->data.ymap_data.keys);
-        default:
-            YUKI_LOG_FATAL("impossible type value %d", yvar->type);
-            return 0;
     }
+
+    yvar_array_with_size(*array, yvars, size);
+    return ytrue;
 }
 
-ybool_t _yvar_equal(const yvar_t * plhs, const yvar_t * prhs)
+/**
+ * sum of signed ints is an int64 and sum of unsigned ints or bools is an uint64.
+ * sum wraps around on overflow.
+ */
+ybool_t _yvar_packed_sum(const yvar_t * packed, yvar_t * sum)
 {
-    if (plhs == prhs) {
-        return ytrue;
-    }
-
-    if (!plhs || !prhs) {
-        YUKI_LOG_DEBUG("NULL pointer in param");
+    if (!packed || !sum || !yvar_is_packed(*packed)) {
+        YUKI_LOG_FATAL("invalid param");
         return yfalse;
     }
 
-    if (plhs->type != prhs->type) {
-        YUKI_LOG_DEBUG("different type");
-        return yfalse;
-    }
+    const void * data = packed->data.ypacked_data.data;
+    ysize_t size = packed->data.ypacked_data.size;
 
-    switch (plhs->type) {
-        case YVAR_TYPE_UNDEFINED:
-            return ytrue;
+    switch (packed->data.ypacked_data.type) {
         case YVAR_TYPE_BOOL:
-            return plhs->data.ybool_data == prhs->data.ybool_data;
+            yvar_uint64(*sum, _yvar_packed_sum_uint8((const yuint8_t*)data, size));
+            break;
         case YVAR_TYPE_INT8:
-            return plhs->data.yint8_data == prhs->data.yint8_data;
+            yvar_int64(*sum, (yint64_t)_yvar_packed_sum_int8((const yint8_t*)data, size));
+            break;
         case YVAR_TYPE_UINT8:
-            return plhs->data.yuint8_data == prhs->data.yuint8_data;
+            yvar_uint64(*sum, _yvar_packed_sum_uint8((const yuint8_t*)data, size));
+            break;
         case YVAR_TYPE_INT16:
-            return plhs->data.yint16_data == prhs->data.yint16_data;
+            yvar_int64(*sum, (yint64_t)_yvar_packed_sum_int16((const yint16_t*)data, size));
+            break;
         case YVAR_TYPE_UINT16:
-            return plhs->data.yuint16_data == prhs->data.yuint16_data;
+            yvar_uint64(*sum, _yvar_packed_sum_uint16((const yuint16_t*)data, size));
+            break;
         case YVAR_TYPE_INT32:
-            return plhs->data.yint32_data == prhs->data.yint32_data;
+            yvar_int64(*sum, (yint64_t)_yvar_packed_sum_int32((const yint32_t*)data, size));
+            break;
         case YVAR_TYPE_UINT32:
-            return plhs->data.yuint32_data == prhs->data.yuint32_data;
+            yvar_uint64(*sum, _yvar_packed_sum_uint32((const yuint32_t*)data, size));
+            break;
         case YVAR_TYPE_INT64:
-            return plhs->data.yint64_data == prhs->data.yint64_data;
+            yvar_int64(*sum, (yint64_t)_yvar_packed_sum_int64((const yint64_t*)data, size));
+            break;
         case YVAR_TYPE_UINT64:
-            return plhs->data.yuint64_data == prhs->data.yuint64_data;
-        case YVAR_TYPE_CSTR:
-        case YVAR_TYPE_STR:
-            if (plhs->data.ycstr_data.size != prhs->data.ycstr_data.size) {
-                return yfalse;
-            }
+            yvar_uint64(*sum, _yvar_packed_sum_uint64((const yuint64_t*)data, size));
+            break;
+        default:
+            YUKI_LOG_FATAL("invalid packed element type. [type: %d]", packed->data.ypacked_data.type);
+            return yfalse;
+    }
 
-            if (plhs->data.ycstr_data.str == prhs->data.ycstr_data.str) {
-                return ytrue;
-            }
+    return ytrue;
+}
 
-            if (!plhs->data.ycstr_data.str || !prhs->data.ycstr_data.str) {
-                return yfalse;
-            }
+#define _YVAR_PACKED_MIN_MAX_CASE(T, t) \
+    case YVAR_TYPE_##T: \
+    { \
+        y##t##_t min_value, max_value; \
+        _yvar_packed_min_max_##t((const y##t##_t*)data, size, &min_value, &max_value); \
+        yvar_##t(*min, min_value); \
+        yvar_##t(*max, max_value); \
+        break; \
+    }
 
-            return !strcmp(plhs->data.ycstr_data.str, prhs->data.ycstr_data.str);
-        case YVAR_TYPE_ARRAY:
-        {
-            ysize_t lhs_cnt = yvar_count(*plhs);
-            ysize_t rhs_cnt = yvar_count(*prhs);
+/**
+ * min and max are vars of element type. fail if packed array is empty.
+ */
+ybool_t _yvar_packed_min_max(const yvar_t * packed, yvar_t * min, yvar_t * max)
+{
+    if (!packed || !min || !max || !yvar_is_packed(*packed)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
 
-            if (lhs_cnt != rhs_cnt) {
-                return yfalse;
-            }
+    const void * data = packed->data.ypacked_data.data;
+    ysize_t size = packed->data.ypacked_data.size;
 
-            ysize_t cnt;
-            for (cnt = 0; cnt < lhs_cnt; cnt++) {
-                if (!yvar_equal(plhs->data.yarray_data.yvars[cnt], prhs->data.yarray_data.yvars[cnt])) {
-                    return yfalse;
-                }
-            }
+    if (!size) {
+        YUKI_LOG_DEBUG("packed array is empty");
+        return yfalse;
+    }
 
-            return ytrue;
-        }
-        case YVAR_TYPE_LIST:
+    switch (packed->data.ypacked_data.type) {
+        case YVAR_TYPE_BOOL:
         {
-            ylist_node_t * lhs_head = plhs->data.ylist_data.head;
-            ylist_node_t * lhs_tail = plhs->data.ylist_data.tail;
-            ylist_node_t * rhs_head = prhs->data.ylist_data.head;
-            ylist_node_t * rhs_tail = prhs->data.ylist_data.tail;
-
-            while (lhs_head != lhs_tail && rhs_head != rhs_tail) {
-                if (!yvar_equal(lhs_head->yvar, rhs_head->yvar)) {
-                    return yfalse;
-                }
-
-                lhs_head = lhs_head->next;
-                rhs_head = rhs_head->next;
-            }
-
-            return lhs_head == lhs_tail && rhs_head == rhs_tail;
+            yint8_t min_value, max_value;
+            _yvar_packed_min_max_int8((const yint8_t*)data, size, &min_value, &max_value);
+            yvar_bool(*min, min_value);
+            yvar_bool(*max, max_value);
+            break;
         }
-        case YVAR_TYPE_MAP:
-            if (!yvar_equal(*plhs->data.ymap_data.keys, *prhs->data.ymap_data.keys)) {
-                return yfalse;
-            }
-
-            return yvar_equal(*plhs->data.ymap_data.values, *prhs->data.ymap_data.values);
+        _YVAR_PACKED_MIN_MAX_CASE(INT8, int8)
+        _YVAR_PACKED_MIN_MAX_CASE(UINT8, uint8)
+        _YVAR_PACKED_MIN_MAX_CASE(INT16, int16)
+        _YVAR_PACKED_MIN_MAX_CASE(UINT16, uint16)
+        _YVAR_PACKED_MIN_MAX_CASE(INT32, int32)
+        _YVAR_PACKED_MIN_MAX_CASE(UINT32, uint32)
+        _YVAR_PACKED_MIN_MAX_CASE(INT64, int64)
+        _YVAR_PACKED_MIN_MAX_CASE(UINT64, uint64)
         default:
-            YUKI_LOG_FATAL("impossible type value %d", plhs->type);
+            YUKI_LOG_FATAL("invalid packed element type. [type: %d]", packed->data.ypacked_data.type);
             return yfalse;
     }
-}
-
-ysize_t _yvar_cstr_strlen(const yvar_t * yvar)
-{
-    if (!yvar_like_string(*yvar)) {
-        YUKI_LOG_FATAL("var is not str or cstr");
-        return 0;
-    }
 
-    return yvar->data.ycstr_data.size;
+    return ytrue;
 }
 
+#define _YVAR_PACKED_FIND_CASE(T, t) \
+    case YVAR_TYPE_##T: \
+        return _yvar_packed_find_##t((const y##t##_t*)data, size, element.t, index);
+
 /**
- * clone an array of array to a var.
- * it's designed to help ytable to clone field or condition easily.
- * the type of triple_array is yvar_t[size][dimension].
+ * find index of the first element equal to value.
+ * value must be int-like. return yfalse if not found.
  */
-ybool_t _yvar_triple_array_clone(yvar_t ** array, yvar_triple_array_t triple_array, ysize_t size, ysize_t dimension)
+ybool_t _yvar_packed_find(const yvar_t * packed, const yvar_t * value, ysize_t * index)
 {
-    if (!array || !triple_array || !*triple_array || !size || !dimension) {
+    if (!packed || !value || !index || !yvar_is_packed(*packed)) {
         YUKI_LOG_FATAL("invalid param");
         return yfalse;
     }
 
-    yvar_t raw_array[size];
-    ysize_t index;
+    if (!yvar_like_int(*value)) {
+        YUKI_LOG_DEBUG("value is not int");
+        return yfalse;
+    }
 
-    for (index = 0; index < size; index++) {
-        yvar_array_with_size(raw_array[index], triple_array[index], dimension);
+    const void * data = packed->data.ypacked_data.data;
+    ysize_t size = packed->data.ypacked_data.size;
+    yuint8_t type = packed->data.ypacked_data.type;
+    yvar_packed_element_t element;
+
+    // a value out of range of element type cannot be found
+    if (!_yvar_packed_store(type, &element, value)) {
+        return yfalse;
+    }
+
+    switch (type) {
+        _YVAR_PACKED_FIND_CASE(BOOL, int8)
+        _YVAR_PACKED_FIND_CASE(INT8, int8)
+        _YVAR_PACKED_FIND_CASE(UINT8, uint8)
+        _YVAR_PACKED_FIND_CASE(INT16, int16)
+        _YVAR_PACKED_FIND_CASE(UINT16, uint16)
+        _YVAR_PACKED_FIND_CASE(INT32, int32)
+        _YVAR_PACKED_FIND_CASE(UINT32, uint32)
+        _YVAR_PACKED_FIND_CASE(INT64, int64)
+        _YVAR_PACKED_FIND_CASE(UINT64, uint64)
+        default:
+            YUKI_LOG_FATAL("invalid packed element type. [type: %d]", type);
+            return yfalse;
     }
-
-    yvar_t the_array = YVAR_ARRAY_WITH_SIZE(raw_array, size);
-    return yvar_clone(*array, the_array);
 }
 
 /**
- * pin an array of array to a var.
- * it's designed to help ytable to pin field or condition easily.
- * the type of triple_array is yvar_t[size][dimension].
+ * find position of key in map keys. keys and values of map must be arrays.
  */
-ybool_t _yvar_triple_array_pin(yvar_t ** array, yvar_triple_array_t triple_array, ysize_t size, ysize_t dimension)
+static ybool_t _yvar_map_find(const yvar_t * map, const yvar_t * key, ysize_t * position)
 {
-    if (!array || !triple_array || !*triple_array || !size || !dimension) {
-        YUKI_LOG_FATAL("invalid param");
+    const yvar_t * keys = map->data.ymap_data.keys;
+
+    if (map->options & YVAR_OPTION_INDEXED) {
+        yvar_map_index_t * index = _yvar_map_index(map);
+        yuint32_t * slots = _yvar_map_index_slots(index);
+        yuint32_t mask = index->capacity - 1;
+        yuint32_t pos;
+
+        for (pos = _yvar_hash(key) & mask; slots[pos]; pos = (pos + 1) & mask) {
+            if (yvar_equal(keys->data.yarray_data.yvars[slots[pos] - 1], *key)) {
+                *position = slots[pos] - 1;
+                return ytrue;
+            }
+        }
+
         return yfalse;
     }
 
-    yvar_t raw_array[size];
-    ysize_t index;
+    if (keys->options & YVAR_OPTION_SORTED) {
+        return _yvar_sorted_find(keys->data.yarray_data.yvars, keys->data.yarray_data.size, key, position);
+    }
 
-    for (index = 0; index < size; index++) {
-        yvar_array_with_size(raw_array[index], triple_array[index], dimension);
+    ysize_t i = 0;
+    FOREACH_YVAR_ARRAY(*keys, v) {
+        if (yvar_equal(*v, *key)) {
+            *position = i;
+            return ytrue;
+        }
+
+        i++;
     }
 
-    yvar_t the_array = YVAR_ARRAY_WITH_SIZE(raw_array, size);
-    return yvar_pin(*array, the_array);
+    return yfalse;
 }
 
-ybool_t _yvar_array_get(const yvar_t * array, size_t index, yvar_t * output)
+ybool_t _yvar_map_get(const yvar_t * map, const yvar_t * key, yvar_t * value)
 {
-    if (!array || !output) {
+    if (!map || !key || !value || !yvar_is_map(*map)) {
         YUKI_LOG_FATAL("invalid param");
         return yfalse;
     }
 
     static yvar_t undefined = YVAR_UNDEFINED();
+    yvar_t * keys = map->data.ymap_data.keys;
+    yvar_t * values = map->data.ymap_data.values;
+    ysize_t position;
 
-    if (!yvar_is_array(*array)) {
-        YUKI_LOG_DEBUG("var is not array");
+    if (!yvar_is_array(*keys) || !yvar_is_array(*values)) {
+        YUKI_LOG_FATAL("map keys or values is not an array. why?");
         return yfalse;
     }
 
-    const yarray_t * arr = &array->data.yarray_data;
-
-    if (index >= arr->size) {
-        YUKI_LOG_DEBUG("out of bound. [index: %u]", index);
-        return yvar_assign(*output, undefined);
+    if (_yvar_map_find(map, key, &position)) {
+        return yvar_array_get(*values, position, *value);
     }
 
-    return yvar_assign(*output, arr->yvars[index]);
+    YUKI_LOG_DEBUG("key is not found");
+    yvar_assign(*value, undefined);
+    return yfalse;
 }
 
-ysize_t _yvar_array_size(const yvar_t * pyvar)
+/**
+ * get value of key in a row. if key is undefined, row itself is the value.
+ * rows of a result set have the same keys in the same order. position of key in
+ * previous row is tried first, so key is resolved by one compare in most rows.
+ */
+static inline const yvar_t * _yvar_array_extract_value(const yvar_t * row, const yvar_t * key,
+    const yvar_t ** last_keys, ysize_t * position)
 {
-    if (!yvar_is_array(*pyvar)) {
-        return 0;
+    if (yvar_is_undefined(*key)) {
+        return row;
     }
 
-    return pyvar->data.yarray_data.size;
+    if (!yvar_is_map(*row)) {
+        return NULL;
+    }
+
+    const yvar_t * keys = row->data.ymap_data.keys;
+    const yvar_t * values = row->data.ymap_data.values;
+
+    if (!yvar_is_array(*keys) || !yvar_is_array(*values)) {
+        YUKI_LOG_FATAL("map keys or values is not an array. why?");
+        return NULL;
+    }
+
+    if (keys != *last_keys) {
+        if ((*position >= keys->data.yarray_data.size
+                || !yvar_equal(keys->data.yarray_data.yvars[*position], *key))
+                && !_yvar_map_find(row, key, position)) {
+            return NULL;
+        }
+
+        *last_keys = keys;
+    }
+
+    return *position < values->data.yarray_data.size? values->data.yarray_data.yvars + *position: NULL;
 }
 
-ybool_t _yvar_list_push_back(yvar_t * yvar, yvar_t * node)
+static inline ybool_t _yvar_array_extract_check(const yvar_t * array, const yvar_t * key, const void * output, ysize_t size)
 {
-    if (!yvar || !node || !yvar_is_list(*yvar)) {
+    if (!array || !key || (!output && size) || !yvar_is_array(*array)) {
         YUKI_LOG_FATAL("invalid param");
         return yfalse;
     }
 
-    if (yvar_has_option(*yvar, YVAR_OPTION_READONLY | YVAR_OPTION_PINNED)) {
-        YUKI_LOG_DEBUG("list is readonly or pinned. cannot be modified.");
+    if (size > array->data.yarray_data.size) {
+        YUKI_LOG_DEBUG("array has less rows than required. [rows: %lu] [size: %lu]",
+            array->data.yarray_data.size, size);
         return yfalse;
     }
 
-    ybuffer_t * buffer = ybuffer_create(sizeof(ylist_node_t));
+    return ytrue;
+}
 
-    if (!buffer) {
-        YUKI_LOG_WARNING("cannot create buffer");
-        return yfalse;
+/**
+ * if all rows are vars of type T, copy them without a branch so that loop can be vectorized.
+ * otherwise, every value is converted by _yvar_get_t() and fail if any of them cannot be converted.
+ */
+#define _YVAR_ARRAY_EXTRACT_INT_FUNCTION(t, T) \
+    ybool_t _yvar_array_extract_##t(const yvar_t * array, const yvar_t * key, y##t##_t * output, ysize_t size) \
+    { \
+        if (!_yvar_array_extract_check(array, key, output, size)) { \
+            return yfalse; \
+        } \
+        const yvar_t * rows = array->data.yarray_data.yvars; \
+        const yvar_t * last_keys = NULL; \
+        const yvar_t * value; \
+        ysize_t position = 0; \
+        ysize_t i; \
+        if (yvar_is_undefined(*key)) { \
+            yuint8_t mismatch = 0; \
+            for (i = 0; i < size; i++) { \
+                mismatch |= rows[i].type ^ YVAR_TYPE_##T; \
+                output[i] = rows[i].data.y##t##_data; \
+            } \
+            if (!mismatch) { \
+                return ytrue; \
+            } \
+        } \
+        for (i = 0; i < size; i++) { \
+            if (!(value = _yvar_array_extract_value(rows + i, key, &last_keys, &position))) { \
+                YUKI_LOG_DEBUG("key is not found in row. [row: %lu]", i); \
+                return yfalse; \
+            } \
+            if (YVAR_TYPE_##T == value->type) { \
+                output[i] = value->data.y##t##_data; \
+            } else if (!_yvar_get_##t(value, output + i)) { \
+                YUKI_LOG_DEBUG("value cannot be converted to " #t ". [row: %lu]", i); \
+                return yfalse; \
+            } \
+        } \
+        return ytrue; \
     }
 
-    ybool_t ret = _yvar_list_push_back_internal(buffer, yvar, node, yfalse);
-    YUKI_ASSERT(!ybuffer_available_size(buffer));
-    return ret;
-}
+_YVAR_ARRAY_EXTRACT_INT_FUNCTION(int64, INT64)
+_YVAR_ARRAY_EXTRACT_INT_FUNCTION(uint64, UINT64)
 
-ybool_t _yvar_map_get(const yvar_t * map, const yvar_t * key, yvar_t * value)
+/**
+ * strings in output point to vars in array. they are not copied.
+ * fail if any value is not a str or cstr.
+ */
+ybool_t _yvar_array_extract_cstr(const yvar_t * array, const yvar_t * key, ycstr_t * output, ysize_t size)
 {
-    if (!map || !key || !value || !yvar_is_map(*map)) {
-        YUKI_LOG_FATAL("invalid param");
+    if (!_yvar_array_extract_check(array, key, output, size)) {
         return yfalse;
     }
 
-    static yvar_t undefined = YVAR_UNDEFINED();
-    yvar_t * keys = map->data.ymap_data.keys;
-    yvar_t * values = map->data.ymap_data.values;
+    const yvar_t * rows = array->data.yarray_data.yvars;
+    const yvar_t * last_keys = NULL;
+    const yvar_t * value;
+    ysize_t position = 0;
+    ysize_t i;
 
-    if (!yvar_is_array(*keys) || !yvar_is_array(*values)) {
-        YUKI_LOG_FATAL("map keys or values is not an array. why?");
-        return yfalse;
-    }
+    for (i = 0; i < size; i++) {
+        if (!(value = _yvar_array_extract_value(rows + i, key, &last_keys, &position))) {
+            YUKI_LOG_DEBUG("key is not found in row. [row: %lu]", i);
+            return yfalse;
+        }
 
-    // TODO: for sorted map, use binary search
-    ysize_t i = 0;
-    FOREACH_YVAR_ARRAY(*keys, v) {
-        if (yvar_equal(*v, *key)) {
-            return yvar_array_get(*values, i, *value);
+        if (!yvar_like_string(*value)) {
+            YUKI_LOG_DEBUG("value is not a string. [row: %lu]", i);
+            return yfalse;
         }
 
-        i++;
+        output[i].str = yvar_cstr_buffer(*value);
+        output[i].size = _yvar_str_size(value);
     }
 
-    YUKI_LOG_DEBUG("key is not found");
-    yvar_assign(*value, undefined);
-    return yfalse;
+    return ytrue;
 }
 
 /**
  * clone a map thru a raw key-value array of vars.
  * this function can help user to create a map in a easier way.
+ * keys are sorted so that yvar_map_get() can use binary search.
  * @code
  * yvar_t raw_arr[][2] = {
  *     {YVAR_CSTR("uid"), YVAR_UINT64(123456UL)}, // "uid" => 123456
@@ -1471,6 +3316,7 @@ ybool_t _yvar_map_clone(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size)
     yvar_t keys = YVAR_ARRAY(even_array);
     yvar_t values = YVAR_ARRAY(odd_array);
     yvar_t local_map = YVAR_MAP(keys, values);
+    yvar_set_option(keys, YVAR_OPTION_SORTED);
 
     return yvar_clone(*map, local_map);
 }
@@ -1493,10 +3339,88 @@ ybool_t _yvar_map_pin(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size)
     yvar_t keys = YVAR_ARRAY(even_array);
     yvar_t values = YVAR_ARRAY(odd_array);
     yvar_t local_map = YVAR_MAP(keys, values);
+    yvar_set_option(keys, YVAR_OPTION_SORTED);
 
     return yvar_pin(*map, local_map);
 }
 
+/**
+ * build an array of maps from rows of values in one pass, e.g. a result set.
+ * every map takes the next `count of keys` values. maps share one copy of keys and its index.
+ * values are not copied. strings in values are copied into thread arena in place, and maps
+ * refer to slices of values, so that values must live as long as result.
+ * @note
+ * values cannot be used any more if it fails.
+ */
+ybool_t _yvar_map_rows(yvar_t ** result, const yvar_t * keys, yvar_t * values)
+{
+    if (!result || !keys || !values || !yvar_is_array(*keys) || !yvar_is_array(*values)) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    ysize_t key_cnt = keys->data.yarray_data.size;
+    ysize_t value_cnt = values->data.yarray_data.size;
+    yvar_t * value_vars = values->data.yarray_data.yvars;
+
+    if (!key_cnt || value_cnt % key_cnt) {
+        YUKI_LOG_WARNING("values cannot be split into rows. [keys: %lu] [values: %lu]", key_cnt, value_cnt);
+        return yfalse;
+    }
+
+    ysize_t rows = value_cnt / key_cnt;
+    ybuffer_mark_t mark = ybuffer_mark();
+    yvar_clone_ctx_t ctx = {NULL, YVAR_CLONE_BUFFER_MIN_SIZE};
+    // keys of row map is replaced by cloned keys soon
+    yvar_t row_map = YVAR_MAP(*(yvar_t*)keys, *values);
+    yvar_t * yvar = (yvar_t*)_yvar_clone_alloc(&ctx, sizeof(yvar_t));
+    yvar_t * maps = (yvar_t*)_yvar_clone_alloc(&ctx, rows * sizeof(yvar_t));
+    yvar_t * map_keys = _yvar_map_block_alloc(&ctx, &row_map, rows);
+    ysize_t i;
+
+    if (!yvar || !maps || !map_keys) {
+        YUKI_LOG_WARNING("out of memory");
+        ybuffer_rewind(mark);
+        return yfalse;
+    }
+
+    if (!_yvar_clone_internal_element(&ctx, map_keys, keys)) {
+        YUKI_LOG_WARNING("cannot clone keys");
+        ybuffer_rewind(mark);
+        return yfalse;
+    }
+
+    // values still refer to memory of caller
+    for (i = 0; i < value_cnt; i++) {
+        if (_yvar_need_deep_clone(value_vars + i)
+                && !_yvar_clone_internal_element(&ctx, value_vars + i, value_vars + i)) {
+            YUKI_LOG_WARNING("cannot clone values");
+            ybuffer_rewind(mark);
+            return yfalse;
+        }
+    }
+
+    row_map.data.ymap_data.keys = map_keys;
+
+    if (_yvar_map_index_mem_size(&row_map)) {
+        _yvar_map_index_build(_yvar_map_index(&row_map), map_keys);
+        row_map.options |= YVAR_OPTION_INDEXED;
+    }
+
+    yvar_t * row_values = _yvar_map_block_values(map_keys);
+
+    for (i = 0; i < rows; i++) {
+        yvar_array_with_size(row_values[i], value_vars + i * key_cnt, key_cnt);
+        maps[i] = row_map;
+        maps[i].data.ymap_data.values = row_values + i;
+    }
+
+    yvar_array_with_size(*yvar, maps, rows);
+    yvar_set_option(*yvar, YVAR_OPTION_HOLD_RESOURCE);
+    *result = yvar;
+    return ytrue;
+}
+
 ybool_t _yvar_assign(yvar_t * lhs, const yvar_t * rhs)
 {
     if (!lhs || !rhs) {
@@ -1509,6 +3433,12 @@ ybool_t _yvar_assign(yvar_t * lhs, const yvar_t * rhs)
         return yfalse;
     }
 
+    // lhs may be inside a frozen var shared by every clone. see yvar_freeze().
+    if (yvar_has_option(*lhs, YVAR_OPTION_FROZEN)) {
+        YUKI_LOG_DEBUG("left hand side value is frozen");
+        return yfalse;
+    }
+
     *lhs = *rhs;
     return ytrue;
 }
@@ -1520,10 +3450,16 @@ ybool_t _yvar_clone(yvar_t ** new_var, const yvar_t * old_var)
         return yfalse;
     }
 
-    ysize_t size = _yvar_mem_size(old_var);
-    ybuffer_t * buffer = ybuffer_create(size);
+    // clone in one pass with buffers growing from thread arena
+    ybuffer_mark_t mark = ybuffer_mark();
+    yvar_clone_ctx_t ctx = {NULL, YVAR_CLONE_BUFFER_MIN_SIZE};
+
+    if (!_yvar_clone_internal(&ctx, new_var, old_var)) {
+        ybuffer_rewind(mark);
+        return yfalse;
+    }
 
-    return _yvar_clone_internal(buffer, new_var, old_var);
+    return ytrue;
 }
 
 ybool_t _yvar_pin(yvar_t ** new_var, const yvar_t * old_var)
@@ -1533,12 +3469,21 @@ ybool_t _yvar_pin(yvar_t ** new_var, const yvar_t * old_var)
         return yfalse;
     }
 
+    // pinned var must live in one global buffer so that it can be unpinned by pointer.
     ysize_t size = _yvar_mem_size(old_var);
-    ybuffer_t * buffer = ybuffer_create_global(size);
-    ybool_t ret = _yvar_clone_internal(buffer, new_var, old_var);
+    ybuffer_t * buffer = ybuffer_site_create_global(size, YBUFFER_SITE_CLONE);
+
+    if (!buffer) {
+        YUKI_LOG_WARNING("out of memory");
+        return yfalse;
+    }
+
+    yvar_clone_ctx_t ctx = {buffer, 0};
+    ybool_t ret = _yvar_clone_internal(&ctx, new_var, old_var);
 
     if (!ret) {
         YUKI_LOG_FATAL("unable to pin var");
+        ybuffer_destroy_global(buffer);
         return yfalse;
     }
 
@@ -1567,6 +3512,49 @@ ybool_t _yvar_unpin(yvar_t * yvar)
     return ytrue;
 }
 
+static YVAR_WALK_RESULT _yvar_freeze_visit(yvar_walk_frame_t * frame, void * data)
+{
+    yvar_t * yvar = frame->peer;
+    (void)data;
+
+    if (yvar->options & YVAR_OPTION_FROZEN) {
+        return YVAR_WALK_SKIP;
+    }
+
+    yvar->options |= YVAR_OPTION_FROZEN;
+    return YVAR_WALK_CONTINUE;
+}
+
+/**
+ * freeze a var and everything it references.
+ * yvar_clone() shares a frozen var instead of copying it, so a condition set or
+ * a result can be referenced by many trees at the cost of copying one var.
+ * sorting an array or pushing to a list copies that array or list first.
+ * its elements are still shared.
+ *
+ * yvar_assign() refuses a frozen lhs, as it cannot tell a copy from a var inside
+ * the shared memory. reset a copy by yvar_memzero() or a constructor before reusing it.
+ * frozen memory must outlive all of its references, e.g. a pinned var or a static one.
+ * @code
+ * yvar_t * conditions;
+ * yvar_pin(conditions, raw_conditions);
+ * yvar_freeze(*conditions);
+ *
+ * // no deep clone any more
+ * ytable_where(table, *conditions);
+ * @endcode
+ */
+ybool_t _yvar_freeze(yvar_t * yvar)
+{
+    if (!yvar) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    // var is walked with itself as peer so that it can be modified in place
+    return _yvar_walk_internal(yvar, yvar, &_yvar_freeze_visit, NULL, NULL);
+}
+
 ybool_t _yvar_memzero(yvar_t * yvar)
 {
     if (!yvar) {
@@ -1577,3 +3565,180 @@ ybool_t _yvar_memzero(yvar_t * yvar)
     memset(yvar, 0, sizeof(yvar_t));
     return ytrue;
 }
+
+/**
+ * probe table for a string.
+ * if not found and pos is not NULL, pos is set to the empty slot ending the probe.
+ */
+static yvar_intern_entry_t * _yvar_intern_find(const yvar_intern_table_t * table,
+    const char * str, ysize_t size, yuint32_t hash, yuint32_t * pos)
+{
+    yuint32_t mask = table->capacity - 1;
+    yvar_intern_entry_t * entry;
+    yuint32_t i;
+
+    for (i = hash & mask; (entry = __atomic_load_n(table->slots + i, __ATOMIC_ACQUIRE)) != NULL; i = (i + 1) & mask) {
+        if (entry->hash == hash && entry->size == size && !memcmp(entry->str, str, size)) {
+            return entry;
+        }
+    }
+
+    if (pos) {
+        *pos = i;
+    }
+
+    return NULL;
+}
+
+/**
+ * create a table with all entries of old table.
+ */
+static yvar_intern_table_t * _yvar_intern_table_create(yuint32_t capacity, yvar_intern_table_t * old)
+{
+    yvar_intern_table_t * table = (yvar_intern_table_t*)calloc(1,
+        sizeof(yvar_intern_table_t) + capacity * sizeof(yvar_intern_entry_t*));
+
+    if (!table) {
+        return NULL;
+    }
+
+    table->capacity = capacity;
+    table->retired = old;
+
+    if (old) {
+        yuint32_t mask = capacity - 1;
+        yuint32_t i, pos;
+
+        for (i = 0; i < old->capacity; i++) {
+            if (!old->slots[i]) {
+                continue;
+            }
+
+            for (pos = old->slots[i]->hash & mask; table->slots[pos]; pos = (pos + 1) & mask) {
+            }
+
+            table->slots[pos] = old->slots[i];
+        }
+
+        table->count = old->count;
+    }
+
+    return table;
+}
+
+/**
+ * insert a string to intern table. must be called with g_yvar_intern_mutex locked.
+ */
+static yvar_intern_entry_t * _yvar_intern_insert(const char * str, ysize_t size, yuint32_t hash)
+{
+    yvar_intern_table_t * table = g_yvar_intern_table;
+    yvar_intern_entry_t * entry;
+    yuint32_t pos = 0;
+
+    // another thread may have inserted it
+    if (table && (entry = _yvar_intern_find(table, str, size, hash, &pos)) != NULL) {
+        return entry;
+    }
+
+    // keep load factor under 50%
+    if (!table || (table->count + 1) * 2 > table->capacity) {
+        table = _yvar_intern_table_create(table? table->capacity * 2: YVAR_INTERN_MIN_CAPACITY, table);
+
+        if (!table) {
+            return NULL;
+        }
+
+        _yvar_intern_find(table, str, size, hash, &pos);
+
+        // make sure readers see a fully built table
+        __atomic_store_n(&g_yvar_intern_table, table, __ATOMIC_RELEASE);
+    }
+
+    entry = (yvar_intern_entry_t*)malloc(sizeof(yvar_intern_entry_t) + size + 1);
+
+    if (!entry) {
+        return NULL;
+    }
+
+    entry->hash = hash;
+    entry->size = size;
+    memcpy(entry->str, str, size);
+    entry->str[size] = '\0';
+
+    // make sure readers see a fully built entry
+    __atomic_store_n(table->slots + pos, entry, __ATOMIC_RELEASE);
+    table->count++;
+    return entry;
+}
+
+/**
+ * make yvar a cstr var pointing to the canonical copy of str.
+ * the same string always gets the same pointer, so interned strings
+ * are compared by pointer and shared instead of copied by clone/pin.
+ * @note
+ * canonical copy is readonly and lives until yuki_shutdown().
+ * lookup is lock free. only the first intern of a string takes a lock.
+ */
+ybool_t _yvar_intern(yvar_t * yvar, const char * str, ysize_t size)
+{
+    if (!yvar || !str) {
+        YUKI_LOG_FATAL("invalid param");
+        return yfalse;
+    }
+
+    yuint32_t hash = _yvar_hash_bytes(str, size);
+    yvar_intern_table_t * table = __atomic_load_n(&g_yvar_intern_table, __ATOMIC_ACQUIRE);
+    yvar_intern_entry_t * entry = table? _yvar_intern_find(table, str, size, hash, NULL): NULL;
+
+    if (!entry) {
+        pthread_mutex_lock(&g_yvar_intern_mutex);
+        entry = _yvar_intern_insert(str, size, hash);
+        pthread_mutex_unlock(&g_yvar_intern_mutex);
+
+        if (!entry) {
+            YUKI_LOG_WARNING("out of memory");
+            return yfalse;
+        }
+    }
+
+    yvar_cstr_with_size(*yvar, entry->str, entry->size);
+    yvar->hash = entry->hash;
+    yvar->options |= YVAR_OPTION_INTERNED | YVAR_OPTION_HASHED;
+    return ytrue;
+}
+
+ybool_t _yvar_init(config_t * config)
+{
+    (void)config;
+    return ytrue;
+}
+
+void _yvar_clean_up()
+{
+}
+
+void _yvar_shutdown()
+{
+    pthread_mutex_lock(&g_yvar_intern_mutex);
+
+    yvar_intern_table_t * table = g_yvar_intern_table;
+    yvar_intern_table_t * retired;
+    yuint32_t i;
+
+    __atomic_store_n(&g_yvar_intern_table, NULL, __ATOMIC_RELEASE);
+
+    // the latest table holds all entries
+    if (table) {
+        for (i = 0; i < table->capacity; i++) {
+            free(table->slots[i]);
+        }
+    }
+
+    while (table) {
+        retired = table->retired;
+        free(table);
+        table = retired;
+    }
+
+    pthread_mutex_unlock(&g_yvar_intern_mutex);
+}
@@ -7,6 +7,11 @@ extern "C" {
 
 #define YUKI_VAR_VERSION 0x1
 
+/**
+ * map cloned or pinned with at least this many keys gets a hash index.
+ */
+#define YVAR_MAP_INDEX_THRESHOLD 8
+
 #define _YVAR_TEMP_VARIABLE_REAL(p, s) __yvar_temp##p##s
 #define _YVAR_TEMP_VARIABLE(p, s) _YVAR_TEMP_VARIABLE_REAL(p, s)
 #define _YVAR_INIT(t, tn, ...) {.type = (t), .version = YUKI_VAR_VERSION, .options = YVAR_OPTION_DEFAULT, .data.tn##_data = __VA_ARGS__}
@@ -30,6 +35,7 @@ extern "C" {
 #define YVAR_ARRAY_WITH_SIZE(d, s) _YVAR_INIT(YVAR_TYPE_ARRAY, yarray, {.size = (s), .yvars = (d)})
 #define YVAR_LIST() _YVAR_INIT(YVAR_TYPE_LIST, ylist, {0})
 #define YVAR_MAP(k, v) _YVAR_INIT(YVAR_TYPE_MAP, ymap, {&(k), &(v)})
+#define YVAR_PACKED(t, d, s) _YVAR_INIT(YVAR_TYPE_PACKED, ypacked, {.size = (s), .type = (t), .data = (d)})
 
 // following macros is for C++ compatible
 // NOTE: don't use them in pure C project. use upper case macro instead.
@@ -75,6 +81,8 @@ extern "C" {
         pointer->options = YVAR_OPTION_DEFAULT; \
         pointer->data.ycstr_data = str; \
     } while (0)
+#define yvar_intern(yvar, d) _yvar_intern(&(yvar), (d), sizeof((d)) - 1)
+#define yvar_intern_with_size(yvar, d, s) _yvar_intern(&(yvar), (d), (s))
 #define yvar_str(yvar) do { \
         yvar_t * pointer = &(yvar); \
         ystr_t str = {0}; \
@@ -115,6 +123,14 @@ extern "C" {
         pointer->options = YVAR_OPTION_DEFAULT; \
         pointer->data.ymap_data = map; \
     } while (0)
+#define yvar_packed(yvar, t, d, s) do { \
+        yvar_t * pointer = &(yvar); \
+        ypacked_t ypacked = {(yuint32_t)(s), (yuint8_t)(t), (d)}; \
+        pointer->type = YVAR_TYPE_PACKED; \
+        pointer->version = YUKI_VAR_VERSION; \
+        pointer->options = YVAR_OPTION_DEFAULT; \
+        pointer->data.ypacked_data = ypacked; \
+    } while (0)
 // }}}
 
 #define _YVAR_IS_TYPE(yvar, t) ((yvar).type == (t))
@@ -133,6 +149,7 @@ extern "C" {
 #define yvar_is_array(yvar)     _YVAR_IS_TYPE((yvar), YVAR_TYPE_ARRAY)
 #define yvar_is_list(yvar)      _YVAR_IS_TYPE((yvar), YVAR_TYPE_LIST)
 #define yvar_is_map(yvar)       _YVAR_IS_TYPE((yvar), YVAR_TYPE_MAP)
+#define yvar_is_packed(yvar)    _YVAR_IS_TYPE((yvar), YVAR_TYPE_PACKED)
 
 #define yvar_like_string(yvar)  _yvar_like_string(&(yvar))
 #define yvar_like_int(yvar)     _yvar_like_int(&(yvar))
@@ -156,6 +173,7 @@ extern "C" {
 #define yvar_count(yvar) _yvar_count(&(yvar))
 #define yvar_equal(lhs, rhs) _yvar_equal(&(lhs), &(rhs))
 #define yvar_compare(lhs, rhs) _yvar_compare(&(lhs), &(rhs))
+#define yvar_hash(yvar) _yvar_hash(&(yvar))
 
 #define yvar_str_strlen(yvar) _yvar_cstr_strlen(&(yvar))
 #define yvar_cstr_strlen(yvar) _yvar_cstr_strlen(&(yvar))
@@ -168,31 +186,68 @@ extern "C" {
     (sizeof(triple_array) / sizeof(triple_array[0])), (sizeof(triple_array[0]) / sizeof(triple_array[0][0])))
 #define yvar_array_get(yvar, index, output) _yvar_array_get(&(yvar), (index), &(output))
 #define yvar_array_size(yvar) _yvar_array_size(&(yvar))
+#define yvar_array_sort(yvar) _yvar_array_sort(&(yvar))
+#define yvar_array_bsearch(yvar, key, index) _yvar_array_bsearch(&(yvar), &(key), &(index))
+#define yvar_array_push(yvar, value) _yvar_array_push(&(yvar), &(value))
+#define yvar_array_reserve(yvar, capacity) _yvar_array_reserve(&(yvar), (capacity))
+/** extract values of key in first n rows of an array of maps. if key is undefined, rows are values. */
+#define yvar_array_extract_int64(yvar, key, output, n) _yvar_array_extract_int64(&(yvar), &(key), (output), (n))
+#define yvar_array_extract_uint64(yvar, key, output, n) _yvar_array_extract_uint64(&(yvar), &(key), (output), (n))
+#define yvar_array_extract_cstr(yvar, key, output, n) _yvar_array_extract_cstr(&(yvar), &(key), (output), (n))
 
 #define yvar_list_push_back(yvar, node) _yvar_list_push_back(&(yvar), &(node))
 
+#define yvar_packed_type(yvar) ((yvar).data.ypacked_data.type)
+#define yvar_packed_element_size(type) _yvar_packed_element_size((type))
+/** typed pointer to elements. e.g. yvar_packed_data(ids, int64)[0] */
+#define yvar_packed_data(yvar, t) ((y##t##_t*)(yvar).data.ypacked_data.data)
+#define yvar_packed_get(yvar, index, output) _yvar_packed_get(&(yvar), (index), &(output))
+#define yvar_packed_set(yvar, index, value) _yvar_packed_set(&(yvar), (index), &(value))
+#define yvar_packed_from_array(yvar, array, t) _yvar_packed_from_array(&(yvar), &(array), (t))
+#define yvar_packed_to_array(yvar, packed) _yvar_packed_to_array(&(yvar), &(packed))
+#define yvar_packed_sum(yvar, sum) _yvar_packed_sum(&(yvar), &(sum))
+#define yvar_packed_min_max(yvar, min, max) _yvar_packed_min_max(&(yvar), &(min), &(max))
+#define yvar_packed_find(yvar, value, index) _yvar_packed_find(&(yvar), &(value), &(index))
+
 #define yvar_map_get(map, k, v) _yvar_map_get(&(map), &(k), &(v))
 #define yvar_map_clone(map, raw_arr, size) _yvar_map_clone(&(map), (raw_arr), (size))
 #define yvar_map_smart_clone(map, raw_arr) _yvar_map_clone(&(map), (raw_arr), (sizeof((raw_arr)) / sizeof((raw_arr)[0])))
 #define yvar_map_pin(map, raw_arr, size) _yvar_map_pin(&(map), (raw_arr), (size))
 #define yvar_map_smart_pin(map, raw_arr) _yvar_map_pin(&(map), (raw_arr), (sizeof((raw_arr)) / sizeof((raw_arr)[0])))
+#define yvar_map_rows(result, k, v) _yvar_map_rows(&(result), &(k), &(v))
 
 #define yvar_assign(lhs, rhs) _yvar_assign(&(lhs), &(rhs))
 #define yvar_clone(new_var, old_var) _yvar_clone(&(new_var), &(old_var))
 #define yvar_pin(new_var, old_var) _yvar_pin(&(new_var), &(old_var))
 #define yvar_unpin(yvar) _yvar_unpin((yvar))
+#define yvar_freeze(yvar) _yvar_freeze(&(yvar))
+#define yvar_walk(yvar, pre, post, data) _yvar_walk(&(yvar), NULL, (pre), (post), (data))
+#define yvar_walk_with_peer(yvar, peer, pre, post, data) _yvar_walk(&(yvar), &(peer), (pre), (post), (data))
 #define yvar_memzero(yvar) _yvar_memzero(&(yvar))
 #define yvar_unset(yvar) yvar_memzero(yvar)
 
-/** get read/write reference of internal string buffer of cstr var. */
-#define yvar_cstr_buffer(yvar) ((yvar).data.ycstr_data.str)
-/** get read/write reference of internal string buffer of cstr var. */
-#define yvar_str_buffer(yvar) ((yvar).data.ystr_data.str)
+/** get internal string buffer of cstr var. short string may be stored inside var. */
+#define yvar_cstr_buffer(yvar) (((yvar).options & YVAR_OPTION_INLINE)? \
+    (const char *)(yvar).data.yinline_data.str: (yvar).data.ycstr_data.str)
+/** get internal string buffer of str var. short string may be stored inside var. */
+#define yvar_str_buffer(yvar) (((yvar).options & YVAR_OPTION_INLINE)? \
+    (yvar).data.yinline_data.str: (yvar).data.ystr_data.str)
 
 // hey friend, i don't intend to use following code to frighten you.
 // but it's really too complex to implement a 'foreach' loop in C.
 // if you find any issue when using these 'foreach's, please keep calm and contact me.
 
+// element type of FOREACH_YVAR_PACKED
+#define _YVAR_PACKED_TYPE_bool YVAR_TYPE_BOOL
+#define _YVAR_PACKED_TYPE_int8 YVAR_TYPE_INT8
+#define _YVAR_PACKED_TYPE_uint8 YVAR_TYPE_UINT8
+#define _YVAR_PACKED_TYPE_int16 YVAR_TYPE_INT16
+#define _YVAR_PACKED_TYPE_uint16 YVAR_TYPE_UINT16
+#define _YVAR_PACKED_TYPE_int32 YVAR_TYPE_INT32
+#define _YVAR_PACKED_TYPE_uint32 YVAR_TYPE_UINT32
+#define _YVAR_PACKED_TYPE_int64 YVAR_TYPE_INT64
+#define _YVAR_PACKED_TYPE_uint64 YVAR_TYPE_UINT64
+
 // if C99 is enabled, declare variable in for loop
 #if (defined(YUKI_CONFIG_C99_ENABLED))
 /**
@@ -248,9 +303,37 @@ extern "C" {
     if (!yvar_is_list(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))) { \
         YUKI_LOG_DEBUG("cannot do foreach list on a non list var"); \
     } else \
-        for (yvar_t *value = &_YVAR_TEMP_VARIABLE(head##key, __LINE__)->yvar; \
-            _YVAR_TEMP_VARIABLE(head##key, __LINE__); \
-            value = &(_YVAR_TEMP_VARIABLE(head##key, __LINE__) = _YVAR_TEMP_VARIABLE(head##key, __LINE__)->next)->yvar)
+        for (yvar_t *value = _YVAR_TEMP_VARIABLE(head##key, __LINE__)? _YVAR_TEMP_VARIABLE(head##key, __LINE__)->yvars: NULL; \
+            value; \
+            value = value + 1 != _YVAR_TEMP_VARIABLE(head##key, __LINE__)->yvars + _YVAR_TEMP_VARIABLE(head##key, __LINE__)->size? value + 1: \
+                (_YVAR_TEMP_VARIABLE(head##key, __LINE__) = _YVAR_TEMP_VARIABLE(head##key, __LINE__)->next)? \
+                    _YVAR_TEMP_VARIABLE(head##key, __LINE__)->yvars: NULL)
+
+/**
+ * iterate elements of a packed array in place.
+ * t is the element type without 'y' and '_t', e.g. int64. if var is not a packed array of t, do nothing.
+ *
+ * sample code.
+ * @code
+ * yint64_t raw_ids[] = {1, 2, 3};
+ * yvar_t ids = YVAR_PACKED(YVAR_TYPE_INT64, raw_ids, 3);
+ *
+ * // note: don't declare 'value' yourself. i will do this for you.
+ * FOREACH_YVAR_PACKED(ids, int64, value) {
+ *     // type of 'value' is yint64_t*.
+ * }
+ * @endcode
+ */
+# define FOREACH_YVAR_PACKED(packed, t, value) \
+    const yvar_t * _YVAR_TEMP_VARIABLE(yvar##key, __LINE__) = &(packed); \
+    if (!yvar_is_packed(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)) \
+        || _YVAR_PACKED_TYPE_##t != _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ypacked_data.type) { \
+        YUKI_LOG_DEBUG("cannot do foreach packed on a var which is not a packed array of " #t); \
+    } else \
+        for (y##t##_t *value = (y##t##_t*)_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ypacked_data.data, \
+            *_YVAR_TEMP_VARIABLE(end##key, __LINE__) = value + \
+                _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ypacked_data.size; \
+            value != _YVAR_TEMP_VARIABLE(end##key, __LINE__); value++)
 
 /**
  * iterate map elements.
@@ -306,9 +389,24 @@ extern "C" {
     if (!yvar_is_list(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__))) { \
         YUKI_LOG_DEBUG("cannot do foreach list on a non list var"); \
     } else \
-        for (value = &_YVAR_TEMP_VARIABLE(head##key, __LINE__)->yvar; \
-            _YVAR_TEMP_VARIABLE(head##key, __LINE__); \
-            value = &(_YVAR_TEMP_VARIABLE(head##key, __LINE__) = _YVAR_TEMP_VARIABLE(head##key, __LINE__)->next)->yvar)
+        for (value = _YVAR_TEMP_VARIABLE(head##key, __LINE__)? _YVAR_TEMP_VARIABLE(head##key, __LINE__)->yvars: NULL; \
+            value; \
+            value = value + 1 != _YVAR_TEMP_VARIABLE(head##key, __LINE__)->yvars + _YVAR_TEMP_VARIABLE(head##key, __LINE__)->size? value + 1: \
+                (_YVAR_TEMP_VARIABLE(head##key, __LINE__) = _YVAR_TEMP_VARIABLE(head##key, __LINE__)->next)? \
+                    _YVAR_TEMP_VARIABLE(head##key, __LINE__)->yvars: NULL)
+
+# define FOREACH_YVAR_PACKED(packed, t, value) \
+    y##t##_t * value; \
+    const yvar_t * _YVAR_TEMP_VARIABLE(yvar##key, __LINE__) = &(packed); \
+    y##t##_t * _YVAR_TEMP_VARIABLE(end##key, __LINE__); \
+    if (!yvar_is_packed(*_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)) \
+        || _YVAR_PACKED_TYPE_##t != _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ypacked_data.type) { \
+        YUKI_LOG_DEBUG("cannot do foreach packed on a var which is not a packed array of " #t); \
+    } else \
+        for (value = (y##t##_t*)_YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ypacked_data.data, \
+            _YVAR_TEMP_VARIABLE(end##key, __LINE__) = value + \
+                _YVAR_TEMP_VARIABLE(yvar##key, __LINE__)->data.ypacked_data.size; \
+            value != _YVAR_TEMP_VARIABLE(end##key, __LINE__); value++)
 
 # define FOREACH_YVAR_MAP(map, key, value) \
     yvar_t *key, *value; \
@@ -355,6 +453,7 @@ ybool_t _yvar_unset_option(yvar_t * yvar, yuint32_t opt);
 ysize_t _yvar_count(const yvar_t * yvar);
 ybool_t _yvar_equal(const yvar_t * plhs, const yvar_t * prhs);
 yint8_t _yvar_compare(const yvar_t * plhs, const yvar_t * prhs);
+yuint32_t _yvar_hash(const yvar_t * yvar);
 
 ysize_t _yvar_cstr_strlen(const yvar_t * yvar);
 
@@ -362,19 +461,40 @@ ybool_t _yvar_triple_array_clone(yvar_t ** array, yvar_triple_array_t triple_arr
 ybool_t _yvar_triple_array_pin(yvar_t ** array, yvar_triple_array_t triple_array, ysize_t size, ysize_t dimension);
 ybool_t _yvar_array_get(const yvar_t * pyvar, size_t index, yvar_t * output);
 ysize_t _yvar_array_size(const yvar_t * pyvar);
+ybool_t _yvar_array_sort(yvar_t * array);
+ybool_t _yvar_array_bsearch(const yvar_t * array, const yvar_t * key, ysize_t * index);
+ybool_t _yvar_array_push(yvar_t * array, const yvar_t * value);
+ybool_t _yvar_array_reserve(yvar_t * array, ysize_t capacity);
+ybool_t _yvar_array_extract_int64(const yvar_t * array, const yvar_t * key, yint64_t * output, ysize_t size);
+ybool_t _yvar_array_extract_uint64(const yvar_t * array, const yvar_t * key, yuint64_t * output, ysize_t size);
+ybool_t _yvar_array_extract_cstr(const yvar_t * array, const yvar_t * key, ycstr_t * output, ysize_t size);
 
 ybool_t _yvar_list_push_back(yvar_t * yvar, yvar_t * node);
 
+ysize_t _yvar_packed_element_size(yuint8_t type);
+ybool_t _yvar_packed_get(const yvar_t * packed, ysize_t index, yvar_t * output);
+ybool_t _yvar_packed_set(yvar_t * packed, ysize_t index, const yvar_t * value);
+ybool_t _yvar_packed_from_array(yvar_t * packed, const yvar_t * array, yuint8_t type);
+ybool_t _yvar_packed_to_array(yvar_t * array, const yvar_t * packed);
+ybool_t _yvar_packed_sum(const yvar_t * packed, yvar_t * sum);
+ybool_t _yvar_packed_min_max(const yvar_t * packed, yvar_t * min, yvar_t * max);
+ybool_t _yvar_packed_find(const yvar_t * packed, const yvar_t * value, ysize_t * index);
+
 ybool_t _yvar_map_get(const yvar_t * map, const yvar_t * key, yvar_t * value);
 ybool_t _yvar_map_clone(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size);
 ybool_t _yvar_map_pin(yvar_t ** map, yvar_map_kv_t raw_arr, ysize_t size);
+ybool_t _yvar_map_rows(yvar_t ** result, const yvar_t * keys, yvar_t * values);
 
 ybool_t _yvar_assign(yvar_t * lhs, const yvar_t * rhs);
 ybool_t _yvar_clone(yvar_t ** new_var, const yvar_t * old_var);
 ybool_t _yvar_pin(yvar_t ** new_var, const yvar_t * old_var);
 ybool_t _yvar_unpin(yvar_t * yvar);
+ybool_t _yvar_freeze(yvar_t * yvar);
+ybool_t _yvar_walk(const yvar_t * yvar, yvar_t * peer, yvar_walk_func pre, yvar_walk_func post, void * data);
 ybool_t _yvar_memzero(yvar_t * new_var);
 
+ybool_t _yvar_intern(yvar_t * yvar, const char * str, ysize_t size);
+
 #ifdef __cplusplus
 }
 #endif